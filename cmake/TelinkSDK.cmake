@@ -57,6 +57,26 @@ FUNCTION(ADD_OTA_TARGET TARGET TOOLS_PATH)
     )
 ENDFUNCTION()
 
+# Flash, RAM and stack report checked against the budgets in BASELINE, see tools/size_report.py.
+# "${TARGET}.report-baseline" stores the current build as the new baseline.
+FUNCTION(ADD_REPORT_TARGET TARGET TOOLS_PATH BASELINE)
+    IF(EXECUTABLE_OUTPUT_PATH)
+      SET(FILENAME "${EXECUTABLE_OUTPUT_PATH}/${TARGET}")
+    ELSE()
+      SET(FILENAME "${TARGET}")
+    ENDIF()
+    TARGET_COMPILE_OPTIONS(${TARGET} PRIVATE $<$<COMPILE_LANGUAGE:C>:-fstack-usage>)
+    SET_PROPERTY(TARGET ${TARGET} APPEND_STRING PROPERTY LINK_FLAGS " -Wl,-Map=${FILENAME}.map")
+    SET(REPORT_ARGS -m ${FILENAME}.map -s ${CMAKE_CURRENT_BINARY_DIR}/CMakeFiles/${TARGET}.dir -b ${BASELINE})
+    ADD_CUSTOM_TARGET("${TARGET}.report"
+        DEPENDS ${TARGET}
+        COMMAND python3 ${TOOLS_PATH}/size_report.py ${REPORT_ARGS}
+    )
+    ADD_CUSTOM_TARGET("${TARGET}.report-baseline"
+        DEPENDS ${TARGET}
+        COMMAND python3 ${TOOLS_PATH}/size_report.py ${REPORT_ARGS} --update
+    )
+ENDFUNCTION()
 
 FUNCTION(PRINT_SIZE_OF_TARGETS TARGET)
     IF(EXECUTABLE_OUTPUT_PATH)
@@ -102,6 +102,23 @@ extern "C"
 
 #define VOLTAGE_DETECT_ADC_PIN                                  GPIO_PC5
 
+/* Brown-out monitor, commits pending light state when the rail starts falling.
+ * It samples VOLTAGE_DETECT_ADC_PIN itself, keep VOLTAGE_DETECT_ENABLE at 0 when it is used.
+ */
+#define LIGHT_BROWN_OUT_ENABLE 1
+
+/* While a level or color transition runs, each reporting entry sends at most
+ * one report per this many milliseconds, the final value is always reported.
+ */
+#define LIGHT_REPORT_TRANSITION_INTERVAL_MS 1000
+
+/* Accept delta (tools/make_ota.py --base) and compressed (--compress) OTA images, see sampleLightOta.h */
+#define LIGHT_OTA_DELTA_ENABLE 1
+#define LIGHT_OTA_LZ_ENABLE 1
+
+/* Checkpoint the OTA download in NV and resume it after a power cycle, see sampleLightOta.h */
+#define LIGHT_OTA_RESUME_ENABLE 1
+
 /**********************************************************************
  * ZCL cluster support setting
  */
@@ -115,6 +132,8 @@ extern "C"
 #define ZCL_OTA_SUPPORT 1
 #define ZCL_GP_SUPPORT 1
 #define ZCL_WWAH_SUPPORT 0
+#define ZCL_TIME_SUPPORT 1
+#define ZCL_LIGHT_EXT_SUPPORT 1 // manufacturer specific, see custom_zcl/zcl_lightExt.h
 #if TOUCHLINK_SUPPORT
 #define ZCL_ZLL_COMMISSIONING_SUPPORT 1
 #endif
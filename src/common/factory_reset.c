@@ -30,14 +30,29 @@
 #define FACTORY_RESET_POWER_CNT_THRESHOLD		4	//times
 #define FACTORY_RESET_TIMEOUT					5	//second
 
+/* The power-cycle counter lives in an analog register that keeps its value through
+ * short supply interruptions and resets. The high nibble marks the content as valid,
+ * after a long outage the register reads back cleared and the NV copy is used instead.
+ * Flash is only written when the brown-out monitor sees the supply fail inside the
+ * counting window, and cleared again only after such a write.
+ */
+#define FACTORY_RESET_ANA_REG					DEEP_ANA_REG1
+#define FACTORY_RESET_ANA_MAGIC					0xA0
+#define FACTORY_RESET_ANA_MAGIC_MASK			0xF0
+#define FACTORY_RESET_ANA_CNT_MASK				0x0F
+
 ev_timer_event_t *factoryRst_timerEvt = NULL;
 u8 factoryRst_powerCnt = 0;
 bool factoryRst_exist = FALSE;
+static u8 factoryRst_nvCnt = 0; // count held in NV_ITEM_APP_POWER_CNT
 
 nv_sts_t factoryRst_powerCntSave(void){
 	nv_sts_t st = NV_SUCC;
 #if NV_ENABLE
 	st = nv_flashWriteNew(1, NV_MODULE_APP, NV_ITEM_APP_POWER_CNT, 1, &factoryRst_powerCnt);
+	if(st == NV_SUCC){
+		factoryRst_nvCnt = factoryRst_powerCnt;
+	}
 #else
 	st = NV_ENABLE_PROTECT_ERROR;
 #endif
@@ -47,13 +62,47 @@ nv_sts_t factoryRst_powerCntSave(void){
 nv_sts_t factoryRst_powerCntRestore(void){
 	nv_sts_t st = NV_SUCC;
 #if NV_ENABLE
-	st = nv_flashReadNew(1, NV_MODULE_APP, NV_ITEM_APP_POWER_CNT, 1, &factoryRst_powerCnt);
+	factoryRst_nvCnt = 0;
+	st = nv_flashReadNew(1, NV_MODULE_APP, NV_ITEM_APP_POWER_CNT, 1, &factoryRst_nvCnt);
+	if(st != NV_SUCC){
+		factoryRst_nvCnt = 0;
+	}
 #else
 	st = NV_ENABLE_PROTECT_ERROR;
 #endif
 	return st;
 }
 
+static bool factoryRst_anaCntRestore(void){
+	u8 val = analog_read(FACTORY_RESET_ANA_REG);
+
+	if((val & FACTORY_RESET_ANA_MAGIC_MASK) != FACTORY_RESET_ANA_MAGIC){
+		return FALSE;
+	}
+
+	factoryRst_powerCnt = val & FACTORY_RESET_ANA_CNT_MASK;
+	return TRUE;
+}
+
+static void factoryRst_anaCntSave(void){
+	u8 cnt = (factoryRst_powerCnt > FACTORY_RESET_ANA_CNT_MASK) ? FACTORY_RESET_ANA_CNT_MASK : factoryRst_powerCnt;
+
+	analog_write(FACTORY_RESET_ANA_REG, FACTORY_RESET_ANA_MAGIC | cnt);
+}
+
+/* Only touches flash when a count was written there */
+static void factoryRst_nvCntClear(void){
+#if NV_ENABLE
+	if(factoryRst_nvCnt){
+		u8 cnt = 0;
+
+		if(nv_flashWriteNew(1, NV_MODULE_APP, NV_ITEM_APP_POWER_CNT, 1, &cnt) == NV_SUCC){
+			factoryRst_nvCnt = 0;
+		}
+	}
+#endif
+}
+
 static s32 factoryRst_timerCb(void *arg){
 	if(factoryRst_powerCnt >= FACTORY_RESET_POWER_CNT_THRESHOLD){
 		/* here is just a mark, wait for device announce and then perform factory reset. */
@@ -61,7 +110,8 @@ static s32 factoryRst_timerCb(void *arg){
 	}
 
 	factoryRst_powerCnt = 0;
-	factoryRst_powerCntSave();
+	factoryRst_anaCntSave();
+	factoryRst_nvCntClear();
 
 	factoryRst_timerEvt = NULL;
 	return -1;
@@ -76,10 +126,28 @@ void factoryRst_handler(void){
 	}
 }
 
+void factoryRst_powerFail(void){
+	/* supply lost inside the counting window, keep the count in case retention does not survive */
+	if(factoryRst_timerEvt && factoryRst_powerCnt && (factoryRst_powerCnt != factoryRst_nvCnt)){
+		factoryRst_powerCntSave();
+	}
+}
+
 void factoryRst_init(void){
+	/* only a read, it tells the window timer whether there is a count to clear */
 	factoryRst_powerCntRestore();
-	factoryRst_powerCnt++;
-	factoryRst_powerCntSave();
+
+	if(factoryRst_anaCntRestore()){
+		factoryRst_powerCnt++;
+	}else{
+		/* retention lost, count on from what factoryRst_powerFail() left in flash */
+		factoryRst_powerCnt = factoryRst_nvCnt + 1;
+#if !LIGHT_BROWN_OUT_ENABLE
+		/* nothing sees the supply fail, so the count has to be in flash up front */
+		factoryRst_powerCntSave();
+#endif
+	}
+	factoryRst_anaCntSave();
 
 	if(factoryRst_timerEvt){
 		TL_ZB_TIMER_CANCEL(&factoryRst_timerEvt);
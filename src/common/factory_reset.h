@@ -28,5 +28,6 @@
 
 void factoryRst_init(void);
 void factoryRst_handler(void);
+void factoryRst_powerFail(void);
 
 #endif	/* FACTORY_RESET_H */
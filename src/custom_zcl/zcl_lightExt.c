@@ -0,0 +1,298 @@
+/********************************************************************************************************
+ * @file    zcl_lightExt.c
+ *
+ * @brief   This is the source file for zcl_lightExt
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zcl_include.h"
+#include "zcl_lightExt.h"
+
+#ifdef ZCL_LIGHT_EXT
+
+/**********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static status_t zcl_lightExt_cmdHandler(zclIncoming_t *pInMsg);
+
+/*********************************************************************
+ * @fn      zcl_lightExt_register
+ *
+ * @brief
+ *
+ * @param   endpoint
+ * @param   manuCode
+ * @param   attrNum
+ * @param   attrTbl
+ * @param   cb
+ *
+ * @return  status_t
+ */
+status_t zcl_lightExt_register(u8 endpoint, u16 manuCode, u8 attrNum, const zclAttrInfo_t attrTbl[], cluster_forAppCb_t cb)
+{
+	return zcl_registerCluster(endpoint, ZCL_CLUSTER_LIGHT_EXT, manuCode, attrNum, attrTbl, zcl_lightExt_cmdHandler, cb);
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_setStateParse
+ *
+ * @brief   Decode ZCL_LIGHT_EXT_SET_STATE_LEN bytes of set state payload,
+ *          also the layout of a keyframe in an animation upload
+ *
+ * @param   pData
+ * @param   pCmd
+ *
+ * @return  None
+ */
+void zcl_lightExt_setStateParse(u8 *pData, zcl_lightExt_setStateCmd_t *pCmd)
+{
+	pCmd->fields = *pData++;
+	pCmd->onOff = *pData++;
+	pCmd->level = *pData++;
+	pCmd->x = BUILD_U16(pData[0], pData[1]);
+	pData += 2;
+	pCmd->y = BUILD_U16(pData[0], pData[1]);
+	pData += 2;
+	pCmd->enhancedHue = BUILD_U16(pData[0], pData[1]);
+	pData += 2;
+	pCmd->saturation = *pData++;
+	pCmd->mireds = BUILD_U16(pData[0], pData[1]);
+	pData += 2;
+	pCmd->transTime = BUILD_U16(pData[0], pData[1]);
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_setStatePrc
+ *
+ * @brief   Parse the set state command and hand it to the application
+ *
+ * @param   pInMsg
+ *
+ * @return  status_t
+ */
+static status_t zcl_lightExt_setStatePrc(zclIncoming_t *pInMsg)
+{
+	zcl_lightExt_setStateCmd_t cmd;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_SET_STATE_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	zcl_lightExt_setStateParse(pInMsg->pData, &cmd);
+
+	if (pInMsg->clusterAppCb)
+	{
+		return pInMsg->clusterAppCb(&(pInMsg->addrInfo), pInMsg->hdr.cmd, &cmd);
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_streamPrc
+ *
+ * @brief   Check the stream frame length, the samples are passed through unparsed
+ *
+ * @param   pInMsg
+ *
+ * @return  status_t
+ */
+static status_t zcl_lightExt_streamPrc(zclIncoming_t *pInMsg)
+{
+	zcl_lightExt_streamCmd_t cmd;
+	u8 *pData = pInMsg->pData;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_STREAM_HDR_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	cmd.flags = *pData++;
+	cmd.count = *pData++;
+	cmd.pSamples = pData;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_STREAM_HDR_LEN + (u16)cmd.count * ZCL_LIGHT_EXT_STREAM_SAMPLE_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	if (pInMsg->clusterAppCb)
+	{
+		return pInMsg->clusterAppCb(&(pInMsg->addrInfo), pInMsg->hdr.cmd, &cmd);
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_animUploadPrc
+ *
+ * @brief   Check the upload length, the keyframes are passed through unparsed
+ *
+ * @param   pInMsg
+ *
+ * @return  status_t
+ */
+static status_t zcl_lightExt_animUploadPrc(zclIncoming_t *pInMsg)
+{
+	zcl_lightExt_animUploadCmd_t cmd;
+	u8 *pData = pInMsg->pData;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_ANIM_UPLOAD_HDR_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	cmd.index = *pData++;
+	cmd.total = *pData++;
+	cmd.loopCount = *pData++;
+	cmd.count = *pData++;
+	cmd.pFrames = pData;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_ANIM_UPLOAD_HDR_LEN + (u16)cmd.count * ZCL_LIGHT_EXT_ANIM_FRAME_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	if (pInMsg->clusterAppCb)
+	{
+		return pInMsg->clusterAppCb(&(pInMsg->addrInfo), pInMsg->hdr.cmd, &cmd);
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_animControlPrc
+ *
+ * @brief
+ *
+ * @param   pInMsg
+ *
+ * @return  status_t
+ */
+static status_t zcl_lightExt_animControlPrc(zclIncoming_t *pInMsg)
+{
+	zcl_lightExt_animControlCmd_t cmd;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_ANIM_CONTROL_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	cmd.action = pInMsg->pData[0];
+	cmd.seq = pInMsg->pData[1];
+
+	if (pInMsg->clusterAppCb)
+	{
+		return pInMsg->clusterAppCb(&(pInMsg->addrInfo), pInMsg->hdr.cmd, &cmd);
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_circadianSetPrc
+ *
+ * @brief   Check the schedule length, the points are passed through unparsed
+ *
+ * @param   pInMsg
+ *
+ * @return  status_t
+ */
+static status_t zcl_lightExt_circadianSetPrc(zclIncoming_t *pInMsg)
+{
+	zcl_lightExt_circadianSetCmd_t cmd;
+	u8 *pData = pInMsg->pData;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_CIRCADIAN_HDR_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	cmd.enable = *pData++;
+	cmd.count = *pData++;
+	cmd.pPoints = pData;
+
+	if (pInMsg->dataLen < ZCL_LIGHT_EXT_CIRCADIAN_HDR_LEN + (u16)cmd.count * ZCL_LIGHT_EXT_CIRCADIAN_POINT_LEN)
+	{
+		return ZCL_STA_MALFORMED_COMMAND;
+	}
+
+	if (pInMsg->clusterAppCb)
+	{
+		return pInMsg->clusterAppCb(&(pInMsg->addrInfo), pInMsg->hdr.cmd, &cmd);
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_clientCmdHandler
+ *
+ * @brief
+ *
+ * @param   pInMsg
+ *
+ * @return  status_t
+ */
+static status_t zcl_lightExt_clientCmdHandler(zclIncoming_t *pInMsg)
+{
+	switch (pInMsg->hdr.cmd)
+	{
+	case ZCL_CMD_LIGHT_EXT_SET_STATE:
+		return zcl_lightExt_setStatePrc(pInMsg);
+	case ZCL_CMD_LIGHT_EXT_STREAM:
+		return zcl_lightExt_streamPrc(pInMsg);
+	case ZCL_CMD_LIGHT_EXT_ANIM_UPLOAD:
+		return zcl_lightExt_animUploadPrc(pInMsg);
+	case ZCL_CMD_LIGHT_EXT_ANIM_CONTROL:
+		return zcl_lightExt_animControlPrc(pInMsg);
+	case ZCL_CMD_LIGHT_EXT_CIRCADIAN_SET:
+		return zcl_lightExt_circadianSetPrc(pInMsg);
+	default:
+		return ZCL_STA_UNSUP_MANU_CLUSTER_COMMAND;
+	}
+}
+
+/*********************************************************************
+ * @fn      zcl_lightExt_cmdHandler
+ *
+ * @brief
+ *
+ * @param   pInMsg
+ *
+ * @return  status_t
+ */
+static status_t zcl_lightExt_cmdHandler(zclIncoming_t *pInMsg)
+{
+	if (pInMsg->hdr.frmCtrl.bf.dir == ZCL_FRAME_CLIENT_SERVER_DIR)
+	{
+		return zcl_lightExt_clientCmdHandler(pInMsg);
+	}
+
+	return ZCL_STA_UNSUP_MANU_CLUSTER_COMMAND;
+}
+
+#endif /* ZCL_LIGHT_EXT */
@@ -0,0 +1,166 @@
+/********************************************************************************************************
+ * @file    zcl_lightExt.h
+ *
+ * @brief   This is the header file for zcl_lightExt
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef ZCL_LIGHT_EXT_H
+#define ZCL_LIGHT_EXT_H
+
+#if ZCL_LIGHT_EXT_SUPPORT
+#define ZCL_LIGHT_EXT
+#endif
+
+/**********************************************************************
+ * CONSTANT
+ */
+/**
+ *  @brief Manufacturer specific light extension cluster
+ */
+#define ZCL_CLUSTER_LIGHT_EXT 0xFC01
+#define ZCL_LIGHT_EXT_MANU_CODE MANUFACTURER_CODE_TELINK
+
+/**
+ *  @brief Attribute IDs
+ */
+#define ZCL_ATTRID_LIGHT_EXT_OTA_BLOCK_PERIOD 0x0000 // u16 ms, current pacing of the OTA download
+#define ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_TRIP_MV 0x0010 // u16 mV, writable, see sampleLightBrownOut.h
+#define ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_RECOVER_MV 0x0011
+#define ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_INTERVAL_MS 0x0012
+#define ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_TRIP_SAMPLES 0x0013 // u8
+
+/**
+ *  @brief Command IDs, client to server
+ */
+#define ZCL_CMD_LIGHT_EXT_SET_STATE 0x00
+#define ZCL_CMD_LIGHT_EXT_STREAM 0x01
+#define ZCL_CMD_LIGHT_EXT_ANIM_UPLOAD 0x02
+#define ZCL_CMD_LIGHT_EXT_ANIM_CONTROL 0x03
+#define ZCL_CMD_LIGHT_EXT_CIRCADIAN_SET 0x04
+
+/**
+ *  @brief Animation control actions
+ */
+#define LIGHT_EXT_ANIM_STOP 0x00
+#define LIGHT_EXT_ANIM_START 0x01
+#define LIGHT_EXT_ANIM_PAUSE 0x02
+#define LIGHT_EXT_ANIM_RESUME 0x03
+
+/**
+ *  @brief Fields of the set state command taking effect, at most one color group
+ */
+#define LIGHT_EXT_FIELD_ON_OFF BIT(0)
+#define LIGHT_EXT_FIELD_LEVEL BIT(1)
+#define LIGHT_EXT_FIELD_XY BIT(2)
+#define LIGHT_EXT_FIELD_HUE_SAT BIT(3) // enhanced hue and saturation
+#define LIGHT_EXT_FIELD_MIREDS BIT(4)
+
+#define ZCL_LIGHT_EXT_SET_STATE_LEN 14
+
+#define ZCL_LIGHT_EXT_STREAM_HDR_LEN 2
+#define ZCL_LIGHT_EXT_STREAM_SAMPLE_LEN 5
+
+#define ZCL_LIGHT_EXT_ANIM_UPLOAD_HDR_LEN 4
+#define ZCL_LIGHT_EXT_ANIM_FRAME_LEN (ZCL_LIGHT_EXT_SET_STATE_LEN + 2) // set state payload + u16 hold time
+#define ZCL_LIGHT_EXT_ANIM_CONTROL_LEN 2
+
+#define ZCL_LIGHT_EXT_CIRCADIAN_HDR_LEN 2
+#define ZCL_LIGHT_EXT_CIRCADIAN_POINT_LEN 5
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Light extension attributes
+ */
+typedef struct
+{
+	u16 otaBlockPeriod;
+	u16 brownOutTripMv;
+	u16 brownOutRecoverMv;
+	u16 brownOutIntervalMs;
+	u8 brownOutTripSamples;
+} zcl_lightExtAttr_t;
+
+/**
+ *  @brief Set state command, every field is present on air, 'fields' selects the ones applied
+ */
+typedef struct
+{
+	u8 fields; // LIGHT_EXT_FIELD_xxx
+	u8 onOff;
+	u8 level;
+	u16 x;
+	u16 y;
+	u16 enhancedHue;
+	u8 saturation;
+	u16 mireds;
+	u16 transTime; // 1/10 second
+} zcl_lightExt_setStateCmd_t;
+
+/**
+ *  @brief Stream command, a burst of timestamped samples
+ */
+typedef struct
+{
+	u8 flags;
+	u8 count;
+	u8 *pSamples; // count * ZCL_LIGHT_EXT_STREAM_SAMPLE_LEN bytes: u16 timestamp in ms, 3 bytes of color
+} zcl_lightExt_streamCmd_t;
+
+/**
+ *  @brief Animation upload command, one chunk of a keyframe program
+ */
+typedef struct
+{
+	u8 index;	  // position of the first keyframe of this chunk, 0 starts a new program
+	u8 total;	  // keyframes in the whole program
+	u8 loopCount; // 0 repeats forever
+	u8 count;	  // keyframes in this chunk
+	u8 *pFrames;  // count * ZCL_LIGHT_EXT_ANIM_FRAME_LEN bytes
+} zcl_lightExt_animUploadCmd_t;
+
+/**
+ *  @brief Animation control command
+ */
+typedef struct
+{
+	u8 action; // LIGHT_EXT_ANIM_xxx
+	u8 seq;	   // keyframe to start from, see lightAnim_start()
+} zcl_lightExt_animControlCmd_t;
+
+/**
+ *  @brief Circadian set command, the daily color temperature schedule
+ */
+typedef struct
+{
+	u8 enable;
+	u8 count;	  // 0 keeps the current table, only 'enable' changes
+	u8 *pPoints; // count * ZCL_LIGHT_EXT_CIRCADIAN_POINT_LEN bytes: u16 minute of the day, u16 mireds, u8 level
+} zcl_lightExt_circadianSetCmd_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void zcl_lightExt_setStateParse(u8 *pData, zcl_lightExt_setStateCmd_t *pCmd);
+status_t zcl_lightExt_register(u8 endpoint, u16 manuCode, u8 attrNum, const zclAttrInfo_t attrTbl[], cluster_forAppCb_t cb);
+
+#endif /* ZCL_LIGHT_EXT_H */
@@ -34,6 +34,13 @@
 #include "gp.h"
 #include "sampleLight.h"
 #include "sampleLightCtrl.h"
+#include "sampleLightNv.h"
+#include "sampleLightBrownOut.h"
+#include "sampleLightReport.h"
+#include "zcl_lightExt.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
+#include "sampleLightOta.h"
 #include "app_ui.h"
 #include "factory_reset.h"
 #if ZBHCI_EN
@@ -108,6 +115,11 @@ bdb_commissionSetting_t g_bdbCommissionSetting = {
  */
 ev_timer_event_t *sampleLightAttrsStoreTimerEvt = NULL;
 
+#ifdef ZCL_LIGHT_EXT
+/* OnOff as last seen, a change is persisted even while an animation plays */
+static u8 sampleLightAnimOnOff = ZCL_ONOFF_STATUS_OFF;
+#endif
+
 /**********************************************************************
  * FUNCTIONS
  */
@@ -149,15 +161,19 @@ void user_app_init(void)
 	zcl_init(sampleLight_zclProcessIncomingMsg);
 
 	/* Register endPoint */
+#ifdef ZCL_OTA
+	/* the OTA pacing sees the frames before the ZCL layer */
+	af_endpointRegister(SAMPLE_LIGHT_ENDPOINT, (af_simple_descriptor_t *)&sampleLight_simpleDesc, lightOta_rxHandler, NULL);
+#else
 	af_endpointRegister(SAMPLE_LIGHT_ENDPOINT, (af_simple_descriptor_t *)&sampleLight_simpleDesc, zcl_rx_handler, NULL);
+#endif
 #if AF_TEST_ENABLE
 	/* A sample of AF data handler. */
 	af_endpointRegister(SAMPLE_TEST_ENDPOINT, (af_simple_descriptor_t *)&sampleTestDesc, afTest_rx_handler, afTest_dataSendConfirm);
 #endif
 
-	/* Initialize or restore attributes, 
-	   this must be done before 'zcl_register()' as it is in charge of restoring the correct values */
-	zcl_sampleLightAttrsInit();
+	/* Attributes are restored in user_init() before the stack comes up,
+	   which also keeps this ahead of 'zcl_register()' */
 	zcl_reportingTabInit();
 
 	/* Register ZCL specific cluster information */
@@ -171,6 +187,7 @@ void user_app_init(void)
 #if ZCL_OTA_SUPPORT
 	/* Initialize OTA */
 	ota_init(OTA_TYPE_CLIENT, (af_simple_descriptor_t *)&sampleLight_simpleDesc, &sampleLight_otaInfo, &sampleLight_otaCb);
+	lightOta_resumeInit();
 #endif
 
 #if ZCL_WWAH_SUPPORT
@@ -181,9 +198,8 @@ void user_app_init(void)
 
 s32 sampleLightAttrsStoreTimerCb(void *arg)
 {
-	zcl_onOffAttr_save();
-	zcl_levelAttr_save();
-	zcl_colorCtrlAttr_save();
+	/* Flash access is deferred to the idle loop, one item per pass */
+	lightNv_enqueue(LIGHT_NV_OP_STATE);
 
 	sampleLightAttrsStoreTimerEvt = NULL;
 	return -1;
@@ -198,58 +214,71 @@ void sampleLightAttrsStoreTimerStart(void)
 	sampleLightAttrsStoreTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLightAttrsStoreTimerCb, NULL, 200);
 }
 
-void sampleLightAttrsChk(void)
+void sampleLightAttrsStoreNow(void)
 {
-	if (gLightCtx.lightAttrsChanged)
+	/* Skip the debounce, the supply is going away */
+	if (sampleLightAttrsStoreTimerEvt)
 	{
-		gLightCtx.lightAttrsChanged = FALSE;
-		if (zb_isDeviceJoinedNwk())
-		{
-			sampleLightAttrsStoreTimerStart();
-		}
+		TL_ZB_TIMER_CANCEL(&sampleLightAttrsStoreTimerEvt);
 	}
+	gLightCtx.lightAttrsChanged = FALSE;
+
+	lightNv_enqueue(LIGHT_NV_OP_STATE);
+	lightNv_flush();
 }
 
-void report_handler(void)
+void sampleLightAttrsChk(void)
 {
-	if (zb_isDeviceJoinedNwk())
+	/* A playing animation is persisted once it stops, not on every keyframe,
+	 * only switching on or off is stored right away */
+#ifdef ZCL_LIGHT_EXT
+	zcl_onOffAttr_t *pOnOff = zcl_onoffAttrGet();
+	bool onOffChanged = (pOnOff->onOff != sampleLightAnimOnOff);
+
+	sampleLightAnimOnOff = pOnOff->onOff;
+	if (lightAnim_active())
 	{
-		if (zcl_reportingEntryActiveNumGet())
+		if (!onOffChanged)
 		{
-			u16 second = 1; // TODO: fix me
-
-			reportNoMinLimit();
-
-			// start report timer
-			reportAttrTimerStart(second);
+			return;
 		}
-		else
+		gLightCtx.lightAttrsChanged = TRUE;
+	}
+#endif
+
+	if (gLightCtx.lightAttrsChanged)
+	{
+		gLightCtx.lightAttrsChanged = FALSE;
+		if (zb_isDeviceJoinedNwk())
 		{
-			// stop report timer
-			reportAttrTimerStop();
+			sampleLightAttrsStoreTimerStart();
 		}
 	}
 }
 
 void app_task(void)
 {
+#ifdef ZCL_OTA
+	lightOta_paceLoop();
+#endif
 	app_key_handler();
 	localPermitJoinState();
 	if (BDB_STATE_GET() == BDB_STATE_IDLE)
 	{
-		// factroyRst_handler();
+		factoryRst_handler();
 
-		report_handler();
+		lightReport_process();
 
 		sampleLightAttrsChk();
+
+		lightNv_process();
 	}
 }
 
 static void sampleLightSysException(void)
 {
-	zcl_onOffAttr_save();
-	zcl_levelAttr_save();
-	zcl_colorCtrlAttr_save();
+	lightNv_enqueue(LIGHT_NV_OP_STATE);
+	lightNv_flush();
 
 	SYSTEM_RESET();
 	// led_on(LED_POWER);
@@ -273,7 +302,18 @@ void user_init(bool isRetention)
 	led_init();
 	hwLight_init();
 
-	// factroyRst_init();
+	/* Instant on: restore the persisted light state and drive the PWM channels
+	   right away, instead of staying dark through stack and ZCL initialization */
+	zcl_sampleLightAttrsInit();
+	light_adjust();
+#ifdef ZCL_LIGHT_EXT
+	lightAnim_init();
+#endif
+#if LIGHT_CIRCADIAN_ENABLE
+	lightCircadian_init();
+#endif
+
+	factoryRst_init();
 
 	/* Initialize Stack */
 	stack_init();
@@ -281,12 +321,14 @@ void user_init(bool isRetention)
 	/* Initialize user application */
 	user_app_init();
 
+#if LIGHT_BROWN_OUT_ENABLE
+	/* Watch the supply rail so pending state is committed before power is lost */
+	lightBrownOut_init();
+#endif
+
 	/* Register except handler for test */
 	sys_exceptHandlerRegister(sampleLightSysException);
 
-	/* Adjust light state to default attributes*/
-	light_adjust();
-
 	/* User's Task */
 #if ZBHCI_EN
 	zbhciInit();
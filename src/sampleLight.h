@@ -42,6 +42,9 @@
 // Map the required time to our internal steps
 #define INTERP_STEPS_FROM_ONE_TENTH(remTime, base) ((remTime * ZCL_REMAINING_TIME_INTERVAL)/base)
 
+// Map a move rate in units per second to the 8.8 fixed point step of one interval
+#define INTERP_STEP256_FROM_RATE(rate, base) ((((s32)(rate)) << 8) * (base) / 1000)
+
 /**********************************************************************
  * TYPEDEFS
  */
@@ -162,6 +165,21 @@ typedef struct
 	u16 startUpColorTemperatureMireds;
 } zcl_lightColorCtrlAttr_t;
 
+/**
+ *  @brief Defined for time cluster attributes
+ */
+typedef struct
+{
+	u32 time; // UTC, seconds since 2000-01-01
+	u8 timeStatus;
+	s32 timeZone;
+	u32 dstStart;
+	u32 dstEnd;
+	s32 dstShift;
+	u32 standardTime;
+	u32 localTime;
+} zcl_timeAttr_t;
+
 /**
  *  @brief Defined for saving on/off attributes
  */
@@ -189,6 +207,36 @@ typedef struct
 	u16 lastMireds;
 } zcl_nv_colorCtrl_t;
 
+/**
+ *  @brief Version of light_state_record_t, bump on any layout change
+ */
+#define LIGHT_STATE_RECORD_VERSION 1
+
+/**
+ *  @brief Defined for saving on/off, level and color attributes as a single NV item
+ */
+typedef struct
+{
+	u32 crc; // covers every field below
+	u8 version;
+
+	bool onOff;
+	u8 startUpOnOff;
+
+	u8 level;
+	u8 startUpLevel;
+
+	u8 colorMode;
+	u8 enhancedColorMode;
+	u8 hue;
+	u8 saturation;
+	u16 enhancedHue;
+	u16 x;
+	u16 y;
+	u16 mireds;
+	u16 startUpMireds;
+} light_state_record_t;
+
 /**********************************************************************
  * GLOBAL VARIABLES
  */
@@ -211,11 +259,17 @@ extern zcl_sceneAttr_t g_zcl_sceneAttrs;
 extern zcl_onOffAttr_t g_zcl_onOffAttrs;
 extern zcl_levelAttr_t g_zcl_levelAttrs;
 extern zcl_lightColorCtrlAttr_t g_zcl_colorCtrlAttrs;
+extern zcl_timeAttr_t g_zcl_timeAttrs;
+#ifdef ZCL_LIGHT_EXT
+extern zcl_lightExtAttr_t g_zcl_lightExtAttrs;
+#endif
 
-#define zcl_sceneAttrGet() &g_zcl_sceneAttrs
-#define zcl_onoffAttrGet() &g_zcl_onOffAttrs
-#define zcl_levelAttrGet() &g_zcl_levelAttrs
-#define zcl_colorAttrGet() &g_zcl_colorCtrlAttrs
+#define zcl_sceneAttrGet() (&g_zcl_sceneAttrs)
+#define zcl_onoffAttrGet() (&g_zcl_onOffAttrs)
+#define zcl_levelAttrGet() (&g_zcl_levelAttrs)
+#define zcl_colorAttrGet() (&g_zcl_colorCtrlAttrs)
+#define zcl_timeAttrGet() (&g_zcl_timeAttrs)
+#define zcl_lightExtAttrGet() (&g_zcl_lightExtAttrs)
 
 /**********************************************************************
  * FUNCTIONS
@@ -228,6 +282,10 @@ status_t sampleLight_sceneCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *c
 status_t sampleLight_onOffCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload);
 status_t sampleLight_levelCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload);
 status_t sampleLight_colorCtrlCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload);
+status_t sampleLight_lightExtCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload);
+#ifdef ZCL_LIGHT_EXT
+void sampleLight_lightExtStateApply(zcl_lightExt_setStateCmd_t *cmd);
+#endif
 
 void sampleLight_leaveCnfHandler(nlme_leave_cnf_t *pLeaveCnf);
 void sampleLight_leaveIndHandler(nlme_leave_ind_t *pLeaveInd);
@@ -236,10 +294,12 @@ u8 sampleLight_nwkUpdateIndicateHandler(nwkCmd_nwkUpdate_t *pNwkUpdate);
 
 void sampleLight_onoff(u8 cmd);
 
+void sampleLightAttrsStoreNow(void);
+
 void zcl_sampleLightAttrsInit(void);
-nv_sts_t zcl_onOffAttr_save(void);
-nv_sts_t zcl_levelAttr_save(void);
-nv_sts_t zcl_colorCtrlAttr_save(void);
+void zcl_sampleLightAttrsReset(void);
+nv_sts_t zcl_lightStateAttr_save(void);
+nv_sts_t zcl_lightStateAttr_restore(void);
 
 #if AF_TEST_ENABLE
 void afTest_rx_handler(void *arg);
@@ -0,0 +1,380 @@
+/********************************************************************************************************
+ * @file    sampleLightAnim.c
+ *
+ * @brief   This is the source file for sampleLightAnim
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "zcl_lightExt.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightNv.h"
+#include "sampleLightAnim.h"
+
+#ifdef ZCL_LIGHT_EXT
+
+/**********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static s32 lightAnim_timerCb(void *arg);
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+static light_animProgram_t lightAnimProgram;
+
+/* Keyframes received so far of an upload in progress, and its announced length */
+static u8 lightAnimUploaded = 0;
+static u8 lightAnimUploadTotal = 0;
+
+static u8 lightAnimFrame = 0;
+static u8 lightAnimLoopsLeft = 0;
+static bool lightAnimPaused = FALSE;
+
+/* Start of the current keyframe, and how far into it a pause stopped */
+static u32 lightAnimStepTick = 0;
+static u32 lightAnimPausedMs = 0;
+
+static ev_timer_event_t *lightAnimTimerEvt = NULL;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightAnim_stepMs
+ *
+ * @brief
+ *
+ * @param   pFrame
+ *
+ * @return  transition plus hold time of a keyframe in ms
+ */
+static u32 lightAnim_stepMs(light_animFrame_t *pFrame)
+{
+	u32 ms = ((u32)pFrame->state.transTime + pFrame->holdTime) * 100;
+
+	return (ms < LIGHT_ANIM_STEP_MIN_MS) ? LIGHT_ANIM_STEP_MIN_MS : ms;
+}
+
+/*********************************************************************
+ * @fn      lightAnim_enter
+ *
+ * @brief   Start a keyframe from its beginning, or part way in after a pause
+ *
+ * @param   elapsedMs - time already spent in the keyframe
+ *
+ * @return  None
+ */
+static void lightAnim_enter(u32 elapsedMs)
+{
+	light_animFrame_t *pFrame = &lightAnimProgram.frames[lightAnimFrame];
+	u32 transMs = (u32)pFrame->state.transTime * 100;
+
+	if ((elapsedMs == 0) || (elapsedMs < transMs))
+	{
+		zcl_lightExt_setStateCmd_t state;
+
+		memcpy((u8 *)&state, (u8 *)&pFrame->state, sizeof(zcl_lightExt_setStateCmd_t));
+		state.transTime = (transMs - elapsedMs) / 100;
+		sampleLight_lightExtStateApply(&state);
+	}
+
+	lightAnimStepTick = clock_time() - elapsedMs * CLOCK_16M_SYS_TIMER_CLK_1MS;
+	lightAnimTimerEvt = TL_ZB_TIMER_SCHEDULE(lightAnim_timerCb, NULL, lightAnim_stepMs(pFrame) - elapsedMs);
+}
+
+/*********************************************************************
+ * @fn      lightAnim_timerCb
+ *
+ * @brief   End of a keyframe, move on to the next one
+ *
+ * @param   arg
+ *
+ * @return  -1: each keyframe schedules its own timer
+ */
+static s32 lightAnim_timerCb(void *arg)
+{
+	lightAnimTimerEvt = NULL;
+
+	if (++lightAnimFrame >= lightAnimProgram.frameNum)
+	{
+		lightAnimFrame = 0;
+
+		if (lightAnimProgram.loopCount && (--lightAnimLoopsLeft == 0))
+		{
+			/* stays on the last keyframe, which is now worth persisting */
+			gLightCtx.lightAttrsChanged = TRUE;
+			return -1;
+		}
+	}
+
+	lightAnim_enter(0);
+	return -1;
+}
+
+/*********************************************************************
+ * @fn      lightAnim_init
+ *
+ * @brief   Load the keyframe program kept in NV
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightAnim_init(void)
+{
+	memset((u8 *)&lightAnimProgram, 0, sizeof(light_animProgram_t));
+
+#if NV_ENABLE
+	if ((nv_flashReadNew(1, NV_MODULE_APP, NV_ITEM_APP_LIGHT_ANIM, sizeof(light_animProgram_t), (u8 *)&lightAnimProgram) != NV_SUCC) ||
+		(lightAnimProgram.frameNum > LIGHT_ANIM_FRAME_MAX))
+	{
+		memset((u8 *)&lightAnimProgram, 0, sizeof(light_animProgram_t));
+	}
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightAnim_upload
+ *
+ * @brief   Store one chunk of a keyframe program. Chunks must arrive in
+ *          order and agree on the total, index 0 discards the current
+ *          program. The program is playable and persisted once the last
+ *          keyframe is in, a further chunk must then start at index 0 again.
+ *
+ * @param   index     - position of the first keyframe in the chunk
+ * @param   total     - keyframes in the whole program
+ * @param   loopCount - 0 repeats forever
+ * @param   count     - keyframes in the chunk
+ * @param   pFrames   - ZCL_LIGHT_EXT_ANIM_FRAME_LEN bytes each
+ *
+ * @return  status_t
+ */
+status_t lightAnim_upload(u8 index, u8 total, u8 loopCount, u8 count, u8 *pFrames)
+{
+	if ((total == 0) || (total > LIGHT_ANIM_FRAME_MAX) || (index + count > total))
+	{
+		return ZCL_STA_INVALID_VALUE;
+	}
+
+	if (index == 0)
+	{
+		lightAnim_stop();
+		lightAnimProgram.frameNum = 0;
+		lightAnimUploaded = 0;
+		lightAnimUploadTotal = total;
+	}
+	else if ((index != lightAnimUploaded) || (total != lightAnimUploadTotal))
+	{
+		/* a chunk went missing or belongs to another upload, the sender has to start over */
+		return ZCL_STA_FAILURE;
+	}
+
+	for (u8 i = 0; i < count; i++, pFrames += ZCL_LIGHT_EXT_ANIM_FRAME_LEN)
+	{
+		light_animFrame_t *pFrame = &lightAnimProgram.frames[index + i];
+
+		zcl_lightExt_setStateParse(pFrames, &pFrame->state);
+		pFrame->holdTime = BUILD_U16(pFrames[ZCL_LIGHT_EXT_SET_STATE_LEN], pFrames[ZCL_LIGHT_EXT_SET_STATE_LEN + 1]);
+	}
+	lightAnimUploaded = index + count;
+
+	if (lightAnimUploaded == total)
+	{
+		lightAnimProgram.frameNum = total;
+		lightAnimProgram.loopCount = loopCount;
+		lightNv_enqueue(LIGHT_NV_OP_ANIM);
+
+		lightAnimUploaded = 0;
+		lightAnimUploadTotal = 0;
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      lightAnim_start
+ *
+ * @brief   Play the program from keyframe 'seq' modulo its length.
+ *          A group is pulled back in step by groupcasting the keyframe it
+ *          should be at, lamps already playing that keyframe carry on
+ *          untouched so repeated starts do not restart the fade.
+ *
+ * @param   seq - keyframe sequence number
+ *
+ * @return  status_t
+ */
+status_t lightAnim_start(u8 seq)
+{
+	if (lightAnimProgram.frameNum == 0)
+	{
+		return ZCL_STA_FAILURE;
+	}
+
+	u8 frame = seq % lightAnimProgram.frameNum;
+
+	if (lightAnim_active() && !lightAnimPaused && (frame == lightAnimFrame))
+	{
+		return ZCL_STA_SUCCESS;
+	}
+
+	lightAnim_stop();
+
+	lightAnimFrame = frame;
+	lightAnimLoopsLeft = lightAnimProgram.loopCount;
+	lightAnim_enter(0);
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      lightAnim_stop
+ *
+ * @brief   Stop playback, the light stays where it is
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightAnim_stop(void)
+{
+	if (!lightAnim_active())
+	{
+		return;
+	}
+
+	if (lightAnimTimerEvt)
+	{
+		TL_ZB_TIMER_CANCEL(&lightAnimTimerEvt);
+	}
+	lightAnimPaused = FALSE;
+
+	/* the state it stopped at is persisted now */
+	gLightCtx.lightAttrsChanged = TRUE;
+}
+
+/*********************************************************************
+ * @fn      lightAnim_pause
+ *
+ * @brief   Freeze the current keyframe part way, lightAnim_resume() continues it
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightAnim_pause(void)
+{
+	if (!lightAnimTimerEvt)
+	{
+		return;
+	}
+
+	TL_ZB_TIMER_CANCEL(&lightAnimTimerEvt);
+	light_transitionStop();
+
+	lightAnimPausedMs = (clock_time() - lightAnimStepTick) / CLOCK_16M_SYS_TIMER_CLK_1MS;
+	lightAnimPaused = TRUE;
+}
+
+/*********************************************************************
+ * @fn      lightAnim_resume
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightAnim_resume(void)
+{
+	if (!lightAnimPaused)
+	{
+		return;
+	}
+
+	lightAnimPaused = FALSE;
+
+	u32 stepMs = lightAnim_stepMs(&lightAnimProgram.frames[lightAnimFrame]);
+	lightAnim_enter((lightAnimPausedMs < stepMs) ? lightAnimPausedMs : (stepMs - 1));
+}
+
+/*********************************************************************
+ * @fn      lightAnim_active
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  TRUE while a program is playing or paused
+ */
+bool lightAnim_active(void)
+{
+	return (lightAnimTimerEvt != NULL) || lightAnimPaused;
+}
+
+/*********************************************************************
+ * @fn      lightAnim_clear
+ *
+ * @brief   Stop playback and forget the program, for factory reset
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightAnim_clear(void)
+{
+	lightAnim_stop();
+
+	memset((u8 *)&lightAnimProgram, 0, sizeof(light_animProgram_t));
+	lightAnimUploaded = 0;
+	lightAnimUploadTotal = 0;
+
+	lightNv_enqueue(LIGHT_NV_OP_ANIM);
+}
+
+/*********************************************************************
+ * @fn      lightAnim_save
+ *
+ * @brief   Write the program to NV, run from the deferred NV queue
+ *
+ * @param   None
+ *
+ * @return  nv_sts_t
+ */
+nv_sts_t lightAnim_save(void)
+{
+#if NV_ENABLE
+	return nv_flashWriteNew(1, NV_MODULE_APP, NV_ITEM_APP_LIGHT_ANIM, sizeof(light_animProgram_t), (u8 *)&lightAnimProgram);
+#else
+	return NV_ENABLE_PROTECT_ERROR;
+#endif
+}
+
+#endif /* ZCL_LIGHT_EXT */
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
@@ -0,0 +1,70 @@
+/********************************************************************************************************
+ * @file    sampleLightAnim.h
+ *
+ * @brief   This is the header file for sampleLightAnim
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_ANIM_H_
+#define _SAMPLE_LIGHT_ANIM_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+#define LIGHT_ANIM_FRAME_MAX 16
+#define LIGHT_ANIM_STEP_MIN_MS ZCL_LEVEL_CHANGE_INTERVAL // keyframes with no transition and no hold
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief One keyframe: the state to move to, then how long to stay there
+ */
+typedef struct
+{
+	zcl_lightExt_setStateCmd_t state; // state.transTime is the transition into this keyframe
+	u16 holdTime;					  // 1/10 second
+} light_animFrame_t;
+
+/**
+ *  @brief Keyframe program, stored in NV_ITEM_APP_LIGHT_ANIM
+ */
+typedef struct
+{
+	u8 frameNum;  // 0 while no complete program is loaded
+	u8 loopCount; // 0 repeats forever
+	u8 reserved[2];
+	light_animFrame_t frames[LIGHT_ANIM_FRAME_MAX];
+} light_animProgram_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void lightAnim_init(void);
+status_t lightAnim_upload(u8 index, u8 total, u8 loopCount, u8 count, u8 *pFrames);
+status_t lightAnim_start(u8 seq);
+void lightAnim_stop(void);
+void lightAnim_pause(void);
+void lightAnim_resume(void);
+bool lightAnim_active(void);
+void lightAnim_clear(void);
+nv_sts_t lightAnim_save(void);
+
+#endif /* _SAMPLE_LIGHT_ANIM_H_ */
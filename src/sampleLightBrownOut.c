@@ -0,0 +1,282 @@
+/********************************************************************************************************
+ * @file    sampleLightBrownOut.c
+ *
+ * @brief   This is the source file for sampleLightBrownOut
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "zcl_lightExt.h"
+#include "sampleLight.h"
+#include "sampleLightNv.h"
+#include "sampleLightBrownOut.h"
+#include "factory_reset.h"
+
+#if LIGHT_BROWN_OUT_ENABLE
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+static light_brownOutCfg_t lightBrownOutCfg = {
+	.tripMv = LIGHT_BROWN_OUT_TRIP_MV_DEFAULT,
+	.recoverMv = LIGHT_BROWN_OUT_RECOVER_MV_DEFAULT,
+	.sampleIntervalMs = LIGHT_BROWN_OUT_INTERVAL_MS_DEFAULT,
+	.tripSamples = LIGHT_BROWN_OUT_TRIP_SAMPLES_DEFAULT,
+};
+
+static ev_timer_event_t *lightBrownOutTimerEvt = NULL;
+static u8 lightBrownOutLowCnt = 0;
+static bool lightBrownOutTripped = FALSE;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightBrownOut_cfgValid
+ *
+ * @brief
+ *
+ * @param   pCfg
+ *
+ * @return  TRUE if every parameter is within its LIGHT_BROWN_OUT_xxx_MIN/MAX range
+ */
+static bool lightBrownOut_cfgValid(const light_brownOutCfg_t *pCfg)
+{
+	return (pCfg->tripMv >= LIGHT_BROWN_OUT_MV_MIN) && (pCfg->tripMv <= LIGHT_BROWN_OUT_MV_MAX) &&
+		   (pCfg->recoverMv >= pCfg->tripMv) && (pCfg->recoverMv <= LIGHT_BROWN_OUT_MV_MAX) &&
+		   (pCfg->sampleIntervalMs >= LIGHT_BROWN_OUT_INTERVAL_MS_MIN) && (pCfg->sampleIntervalMs <= LIGHT_BROWN_OUT_INTERVAL_MS_MAX) &&
+		   (pCfg->tripSamples >= LIGHT_BROWN_OUT_TRIP_SAMPLES_MIN) && (pCfg->tripSamples <= LIGHT_BROWN_OUT_TRIP_SAMPLES_MAX);
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_attrSync
+ *
+ * @brief   Mirror the parameters in use into the light extension attributes
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightBrownOut_attrSync(void)
+{
+#ifdef ZCL_LIGHT_EXT
+	zcl_lightExtAttr_t *pExt = zcl_lightExtAttrGet();
+
+	pExt->brownOutTripMv = lightBrownOutCfg.tripMv;
+	pExt->brownOutRecoverMv = lightBrownOutCfg.recoverMv;
+	pExt->brownOutIntervalMs = lightBrownOutCfg.sampleIntervalMs;
+	pExt->brownOutTripSamples = lightBrownOutCfg.tripSamples;
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_timerCb
+ *
+ * @brief   Samples the rail. On a falling rail the pending light state is
+ *          committed at once and further flash activity is halted until
+ *          the rail is back above the recover level.
+ *
+ * @param   arg
+ *
+ * @return  0: timer continue on
+ */
+static s32 lightBrownOut_timerCb(void *arg)
+{
+	u16 mv = drv_get_adc_data();
+
+	if (!lightBrownOutTripped)
+	{
+		if (mv >= lightBrownOutCfg.tripMv)
+		{
+			lightBrownOutLowCnt = 0;
+		}
+		else if (++lightBrownOutLowCnt >= lightBrownOutCfg.tripSamples)
+		{
+			lightBrownOutTripped = TRUE;
+
+			sampleLightAttrsStoreNow();
+			factoryRst_powerFail();
+			lightNv_halt(TRUE);
+		}
+	}
+	else if (mv >= lightBrownOutCfg.recoverMv)
+	{
+		/* Only a dip, carry on with whatever was queued meanwhile */
+		lightBrownOutTripped = FALSE;
+		lightBrownOutLowCnt = 0;
+
+		lightNv_halt(FALSE);
+	}
+
+	return 0;
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_timerStart
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightBrownOut_timerStart(void)
+{
+	if (lightBrownOutTimerEvt)
+	{
+		TL_ZB_TIMER_CANCEL(&lightBrownOutTimerEvt);
+	}
+	lightBrownOutTimerEvt = TL_ZB_TIMER_SCHEDULE(lightBrownOut_timerCb, NULL, lightBrownOutCfg.sampleIntervalMs);
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_init
+ *
+ * @brief   Loads the parameters from NV, sets up the ADC on
+ *          VOLTAGE_DETECT_ADC_PIN and starts sampling. A stored
+ *          set out of range is ignored, the defaults apply.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightBrownOut_init(void)
+{
+#if NV_ENABLE
+	light_brownOutCfg_t cfg;
+
+	if ((nv_flashReadNew(1, NV_MODULE_APP, NV_ITEM_APP_BROWN_OUT_CFG, sizeof(light_brownOutCfg_t), (u8 *)&cfg) == NV_SUCC) &&
+		lightBrownOut_cfgValid(&cfg))
+	{
+		memcpy((u8 *)&lightBrownOutCfg, (u8 *)&cfg, sizeof(light_brownOutCfg_t));
+	}
+#endif
+	lightBrownOut_attrSync();
+
+	drv_adc_init();
+	drv_adc_mode_pin_set(DRV_ADC_VBAT_MODE, VOLTAGE_DETECT_ADC_PIN);
+	drv_adc_enable(1);
+
+	lightBrownOut_timerStart();
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_cfgSet
+ *
+ * @brief   Applies new parameters and queues them for NV
+ *
+ * @param   pCfg
+ *
+ * @return  ZCL_STA_SUCCESS, or ZCL_STA_INVALID_VALUE if a parameter is out of range
+ */
+status_t lightBrownOut_cfgSet(const light_brownOutCfg_t *pCfg)
+{
+	if (!lightBrownOut_cfgValid(pCfg))
+	{
+		return ZCL_STA_INVALID_VALUE;
+	}
+
+	memcpy((u8 *)&lightBrownOutCfg, (u8 *)pCfg, sizeof(light_brownOutCfg_t));
+	lightBrownOutCfg.reserved = 0;
+	lightBrownOut_attrSync();
+	lightBrownOut_timerStart();
+
+	lightNv_enqueue(LIGHT_NV_OP_BROWN_OUT_CFG);
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_cfgGet
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  the parameters in use
+ */
+const light_brownOutCfg_t *lightBrownOut_cfgGet(void)
+{
+	return &lightBrownOutCfg;
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_save
+ *
+ * @brief   Write the parameters to NV, run from the deferred NV queue
+ *
+ * @param   None
+ *
+ * @return  nv_sts_t
+ */
+nv_sts_t lightBrownOut_save(void)
+{
+#if NV_ENABLE
+	return nv_flashWriteNew(1, NV_MODULE_APP, NV_ITEM_APP_BROWN_OUT_CFG, sizeof(light_brownOutCfg_t), (u8 *)&lightBrownOutCfg);
+#else
+	return NV_ENABLE_PROTECT_ERROR;
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightBrownOut_attrWritten
+ *
+ * @brief   Called after a Write Attributes on the light extension cluster.
+ *          The attributes form one parameter set, a set out of range is
+ *          dropped and the attributes show the parameters in use again.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightBrownOut_attrWritten(void)
+{
+#ifdef ZCL_LIGHT_EXT
+	zcl_lightExtAttr_t *pExt = zcl_lightExtAttrGet();
+	light_brownOutCfg_t cfg;
+
+	cfg.tripMv = pExt->brownOutTripMv;
+	cfg.recoverMv = pExt->brownOutRecoverMv;
+	cfg.sampleIntervalMs = pExt->brownOutIntervalMs;
+	cfg.tripSamples = pExt->brownOutTripSamples;
+	cfg.reserved = 0;
+
+	if (!memcmp((u8 *)&cfg, (u8 *)&lightBrownOutCfg, sizeof(light_brownOutCfg_t)))
+	{
+		return;
+	}
+
+	if (lightBrownOut_cfgSet(&cfg) != ZCL_STA_SUCCESS)
+	{
+		lightBrownOut_attrSync();
+	}
+#endif
+}
+
+#endif /* LIGHT_BROWN_OUT_ENABLE */
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
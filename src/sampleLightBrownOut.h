@@ -0,0 +1,70 @@
+/********************************************************************************************************
+ * @file    sampleLightBrownOut.h
+ *
+ * @brief   This is the header file for sampleLightBrownOut
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_BROWN_OUT_H_
+#define _SAMPLE_LIGHT_BROWN_OUT_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+#define LIGHT_BROWN_OUT_TRIP_MV_DEFAULT 3000
+#define LIGHT_BROWN_OUT_RECOVER_MV_DEFAULT 3150
+#define LIGHT_BROWN_OUT_INTERVAL_MS_DEFAULT 20
+#define LIGHT_BROWN_OUT_TRIP_SAMPLES_DEFAULT 2
+
+/**
+ *  @brief Accepted ranges of the parameters, the recover level must not be below the trip level
+ */
+#define LIGHT_BROWN_OUT_MV_MIN 1800 // supply range of the chip
+#define LIGHT_BROWN_OUT_MV_MAX 3600
+#define LIGHT_BROWN_OUT_INTERVAL_MS_MIN 10
+#define LIGHT_BROWN_OUT_INTERVAL_MS_MAX 1000
+#define LIGHT_BROWN_OUT_TRIP_SAMPLES_MIN 1
+#define LIGHT_BROWN_OUT_TRIP_SAMPLES_MAX 50
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Brown-out monitor parameters, stored in NV_ITEM_APP_BROWN_OUT_CFG
+ */
+typedef struct
+{
+	u16 tripMv;			  // rail voltage regarded as falling
+	u16 recoverMv;		  // rail voltage at which flash access is allowed again
+	u16 sampleIntervalMs; // ADC sampling period
+	u8 tripSamples;		  // consecutive low samples before the monitor trips
+	u8 reserved;
+} light_brownOutCfg_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void lightBrownOut_init(void);
+status_t lightBrownOut_cfgSet(const light_brownOutCfg_t *pCfg);
+const light_brownOutCfg_t *lightBrownOut_cfgGet(void);
+nv_sts_t lightBrownOut_save(void);
+void lightBrownOut_attrWritten(void);
+
+#endif /* _SAMPLE_LIGHT_BROWN_OUT_H_ */
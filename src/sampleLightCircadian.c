@@ -0,0 +1,373 @@
+/********************************************************************************************************
+ * @file    sampleLightCircadian.c
+ *
+ * @brief   This is the source file for sampleLightCircadian
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "zcl_lightExt.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightNv.h"
+#include "sampleLightTransition.h"
+#include "sampleLightStream.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
+
+#if LIGHT_CIRCADIAN_ENABLE
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+static light_circadianTable_t lightCircadianTable;
+
+/* Set by a manual level or color command, cleared when the light is switched on */
+static bool lightCircadianOverridden = FALSE;
+
+/* System tick matching the current value of the Time attribute */
+static u32 lightCircadianTick = 0;
+
+static ev_timer_event_t *lightCircadianTimerEvt = NULL;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightCircadian_clockUpdate
+ *
+ * @brief   Advance the Time attribute by the whole seconds passed. Must
+ *          run more often than the 32 bit system tick wraps.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightCircadian_clockUpdate(void)
+{
+	zcl_timeAttr_t *pTime = zcl_timeAttrGet();
+	u32 secs = (clock_time() - lightCircadianTick) / CLOCK_16M_SYS_TIMER_CLK_1S;
+
+	lightCircadianTick += secs * CLOCK_16M_SYS_TIMER_CLK_1S;
+	pTime->time += secs;
+
+	pTime->standardTime = pTime->time + pTime->timeZone;
+	pTime->localTime = pTime->standardTime;
+	if ((pTime->time >= pTime->dstStart) && (pTime->time < pTime->dstEnd))
+	{
+		pTime->localTime += pTime->dstShift;
+	}
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_interp
+ *
+ * @brief   Schedule value at a time of day, linear between the points
+ *          around it, wrapping from the last point of the day to the first
+ *
+ * @param   pTable
+ * @param   secOfDay - local time of day in seconds
+ * @param   pLevel   - level at that time, 0 if the schedule leaves it alone
+ *
+ * @return  mireds
+ */
+u16 lightCircadian_interp(const light_circadianTable_t *pTable, u32 secOfDay, u8 *pLevel)
+{
+	const light_circadianPoint_t *pPrev = &pTable->points[pTable->pointNum - 1];
+	const light_circadianPoint_t *pNext = &pTable->points[0];
+
+	for (u8 i = 0; i < pTable->pointNum; i++)
+	{
+		if ((u32)pTable->points[i].minute * 60 > secOfDay)
+		{
+			pNext = &pTable->points[i];
+			pPrev = &pTable->points[(i == 0) ? (pTable->pointNum - 1) : (i - 1)];
+			break;
+		}
+	}
+
+	u32 span = ((u32)pNext->minute * 60 + LIGHT_CIRCADIAN_DAY_S - (u32)pPrev->minute * 60) % LIGHT_CIRCADIAN_DAY_S;
+	u32 pos = (secOfDay + LIGHT_CIRCADIAN_DAY_S - (u32)pPrev->minute * 60) % LIGHT_CIRCADIAN_DAY_S;
+
+	if (span == 0)
+	{
+		/* a single point holds all day */
+		*pLevel = pPrev->level;
+		return pPrev->mireds;
+	}
+
+	*pLevel = (pPrev->level && pNext->level) ? (u8)(pPrev->level + ((s32)pNext->level - pPrev->level) * (s32)pos / (s32)span) : pPrev->level;
+
+	/* a table loaded from NV is not range checked, the mireds product needs 64 bits */
+	return (u16)(pPrev->mireds + ((s64)pNext->mireds - pPrev->mireds) * (s32)pos / (s32)span);
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_step
+ *
+ * @brief   Fade to the schedule value for the current local time
+ *
+ * @param   fadeTime - 1/10 second
+ *
+ * @return  None
+ */
+static void lightCircadian_step(u16 fadeTime)
+{
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+	light_transTarget_t target;
+	u8 level;
+
+	/* the clock runs once the Time attribute has been written, switching on catches up */
+	if (!lightCircadianTable.enable || !lightCircadianTable.pointNum || lightCircadianOverridden ||
+		!lightCircadianTimerEvt || !zcl_onoffAttrGet()->onOff || lightAnim_active() || lightStream_active())
+	{
+		return;
+	}
+
+	memset((u8 *)&target, 0, sizeof(light_transTarget_t));
+
+	target.mireds = lightCircadian_interp(&lightCircadianTable, zcl_timeAttrGet()->localTime % LIGHT_CIRCADIAN_DAY_S, &level);
+	if (target.mireds < pColor->colorTempPhysicalMinMireds)
+	{
+		target.mireds = pColor->colorTempPhysicalMinMireds;
+	}
+	else if (target.mireds > pColor->colorTempPhysicalMaxMireds)
+	{
+		target.mireds = pColor->colorTempPhysicalMaxMireds;
+	}
+	if ((pColor->colorMode != ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS) || (target.mireds != pColor->colorTemperatureMireds))
+	{
+		target.fields |= LIGHT_TRANS_MIREDS;
+	}
+
+	if (level && (level != zcl_levelAttrGet()->curLevel))
+	{
+		target.fields |= LIGHT_TRANS_LEVEL;
+		target.level = level;
+	}
+
+	if (target.fields)
+	{
+		lightTrans_start(&target, fadeTime);
+	}
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_timerCb
+ *
+ * @brief
+ *
+ * @param   arg
+ *
+ * @return  0: timer continue on; -1: timer will be canceled
+ */
+static s32 lightCircadian_timerCb(void *arg)
+{
+	lightCircadian_clockUpdate();
+	lightCircadian_step(LIGHT_CIRCADIAN_FADE_TIME);
+
+	return 0;
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_init
+ *
+ * @brief   Load the schedule kept in NV, it is followed once the time is set
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightCircadian_init(void)
+{
+	memset((u8 *)&lightCircadianTable, 0, sizeof(light_circadianTable_t));
+
+#if NV_ENABLE
+	if ((nv_flashReadNew(1, NV_MODULE_APP, NV_ITEM_APP_CIRCADIAN, sizeof(light_circadianTable_t), (u8 *)&lightCircadianTable) != NV_SUCC) ||
+		(lightCircadianTable.pointNum > LIGHT_CIRCADIAN_POINT_MAX))
+	{
+		memset((u8 *)&lightCircadianTable, 0, sizeof(light_circadianTable_t));
+	}
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_set
+ *
+ * @brief   Replace the schedule table and/or switch following on or off
+ *
+ * @param   enable  - follow the schedule
+ * @param   count   - points in pPoints, 0 keeps the current table
+ * @param   pPoints - LIGHT_CIRCADIAN_POINT_LEN bytes each, any order,
+ *                    mireds within the physical min/max
+ *
+ * @return  status_t
+ */
+status_t lightCircadian_set(u8 enable, u8 count, u8 *pPoints)
+{
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+	light_circadianPoint_t points[LIGHT_CIRCADIAN_POINT_MAX];
+
+	if (count > LIGHT_CIRCADIAN_POINT_MAX)
+	{
+		return ZCL_STA_INSUFFICIENT_SPACE;
+	}
+
+	for (u8 i = 0; i < count; i++, pPoints += LIGHT_CIRCADIAN_POINT_LEN)
+	{
+		light_circadianPoint_t point;
+
+		point.minute = BUILD_U16(pPoints[0], pPoints[1]);
+		point.mireds = BUILD_U16(pPoints[2], pPoints[3]);
+		point.level = pPoints[4];
+		point.reserved = 0;
+
+		if ((point.minute >= LIGHT_CIRCADIAN_DAY_S / 60) ||
+			(point.mireds < pColor->colorTempPhysicalMinMireds) || (point.mireds > pColor->colorTempPhysicalMaxMireds))
+		{
+			return ZCL_STA_INVALID_VALUE;
+		}
+
+		/* insertion sort by minute */
+		u8 j = i;
+		while ((j > 0) && (points[j - 1].minute > point.minute))
+		{
+			points[j] = points[j - 1];
+			j--;
+		}
+		points[j] = point;
+	}
+
+	if (count)
+	{
+		memcpy((u8 *)lightCircadianTable.points, (u8 *)points, count * sizeof(light_circadianPoint_t));
+		lightCircadianTable.pointNum = count;
+	}
+	lightCircadianTable.enable = enable ? TRUE : FALSE;
+
+	lightNv_enqueue(LIGHT_NV_OP_CIRCADIAN);
+
+	lightCircadianOverridden = FALSE;
+	lightCircadian_step(LIGHT_CIRCADIAN_FADE_TIME);
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_timeSync
+ *
+ * @brief   A Time cluster attribute was written, restart the local clock from it
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightCircadian_timeSync(void)
+{
+	lightCircadianTick = clock_time();
+	lightCircadian_clockUpdate();
+
+	if (!lightCircadianTimerEvt)
+	{
+		lightCircadianTimerEvt = TL_ZB_TIMER_SCHEDULE(lightCircadian_timerCb, NULL, LIGHT_CIRCADIAN_STEP_S * 1000);
+	}
+
+	lightCircadian_step(LIGHT_CIRCADIAN_FADE_TIME);
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_override
+ *
+ * @brief   A manual command took over, stop following until the light is next switched on
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightCircadian_override(void)
+{
+	lightCircadianOverridden = TRUE;
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_resume
+ *
+ * @brief   The light is being switched on, jump straight to the schedule
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightCircadian_resume(void)
+{
+	lightCircadianOverridden = FALSE;
+
+	if (lightCircadianTimerEvt)
+	{
+		lightCircadian_clockUpdate();
+	}
+	lightCircadian_step(0);
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_clear
+ *
+ * @brief   Forget the schedule, for factory reset
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightCircadian_clear(void)
+{
+	memset((u8 *)&lightCircadianTable, 0, sizeof(light_circadianTable_t));
+	lightCircadianOverridden = FALSE;
+
+	lightNv_enqueue(LIGHT_NV_OP_CIRCADIAN);
+}
+
+/*********************************************************************
+ * @fn      lightCircadian_save
+ *
+ * @brief   Write the schedule to NV, run from the deferred NV queue
+ *
+ * @param   None
+ *
+ * @return  nv_sts_t
+ */
+nv_sts_t lightCircadian_save(void)
+{
+#if NV_ENABLE
+	return nv_flashWriteNew(1, NV_MODULE_APP, NV_ITEM_APP_CIRCADIAN, sizeof(light_circadianTable_t), (u8 *)&lightCircadianTable);
+#else
+	return NV_ENABLE_PROTECT_ERROR;
+#endif
+}
+
+#endif /* LIGHT_CIRCADIAN_ENABLE */
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
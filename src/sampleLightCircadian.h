@@ -0,0 +1,83 @@
+/********************************************************************************************************
+ * @file    sampleLightCircadian.h
+ *
+ * @brief   This is the header file for sampleLightCircadian
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_CIRCADIAN_H_
+#define _SAMPLE_LIGHT_CIRCADIAN_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+/* Needs the light extension cluster to load the table, the Time cluster as clock and color temperature */
+#if defined(ZCL_LIGHT_EXT) && defined(ZCL_TIME) && defined(ZCL_LIGHT_COLOR_CONTROL)
+#define LIGHT_CIRCADIAN_ENABLE 1
+#else
+#define LIGHT_CIRCADIAN_ENABLE 0
+#endif
+
+#define LIGHT_CIRCADIAN_POINT_MAX 8
+#define LIGHT_CIRCADIAN_STEP_S 60	 // the schedule is followed in steps this far apart
+#define LIGHT_CIRCADIAN_FADE_TIME 20 // 1/10 second, fade of each step
+#define LIGHT_CIRCADIAN_DAY_S 86400
+
+#define LIGHT_CIRCADIAN_POINT_LEN 5 // u16 minute of the day, u16 mireds, u8 level
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Point of the daily schedule, the light moves linearly from one point to the next
+ */
+typedef struct
+{
+	u16 minute; // local time, 0..1439
+	u16 mireds;
+	u8 level; // 0 leaves the level alone
+	u8 reserved;
+} light_circadianPoint_t;
+
+/**
+ *  @brief Schedule table, stored in NV_ITEM_APP_CIRCADIAN
+ */
+typedef struct
+{
+	u8 enable;
+	u8 pointNum;
+	u8 reserved[2];
+	light_circadianPoint_t points[LIGHT_CIRCADIAN_POINT_MAX]; // sorted by minute
+} light_circadianTable_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void lightCircadian_init(void);
+status_t lightCircadian_set(u8 enable, u8 count, u8 *pPoints);
+void lightCircadian_timeSync(void);
+void lightCircadian_override(void);
+void lightCircadian_resume(void);
+void lightCircadian_clear(void);
+nv_sts_t lightCircadian_save(void);
+
+u16 lightCircadian_interp(const light_circadianTable_t *pTable, u32 secOfDay, u8 *pLevel);
+
+#endif /* _SAMPLE_LIGHT_CIRCADIAN_H_ */
@@ -30,6 +30,9 @@
 #include "zcl_include.h"
 #include "sampleLight.h"
 #include "sampleLightCtrl.h"
+#include "sampleLightTransition.h"
+#include "sampleLightReport.h"
+#include "sampleLightStream.h"
 #include "helpers.h"
 
 /**********************************************************************
@@ -56,6 +59,12 @@ extern void sampleLight_updateColor(void);
 extern void sampleLight_onOffInit(void);
 extern void sampleLight_colorInit(void);
 
+extern bool sampleLight_levelTransitionActive(void);
+extern bool sampleLight_colorTransitionActive(void);
+extern bool sampleLight_colorFadeActive(void);
+extern void sampleLight_levelTransitionStop(void);
+extern void sampleLight_colorTransitionStop(void);
+
 /*********************************************************************
  * @fn      pwmSetDuty
  *
@@ -404,9 +413,94 @@ void light_adjust(void)
  */
 void light_fresh(void)
 {
+	/* rendering the attributes takes the light back from a stream */
+	lightStream_stop();
+
 	sampleLight_updateColor();
 	sampleLight_updateOnOff();
 	gLightCtx.lightAttrsChanged = TRUE;
+	lightReport_attrChanged();
+}
+
+/*********************************************************************
+ * @fn      light_transitionActive
+ *
+ * @brief   whether any level or color transition is in progress
+ *
+ * @param   None
+ *
+ * @return  TRUE while the light is fading
+ */
+bool light_transitionActive(void)
+{
+	if (lightTrans_active() || lightStream_active())
+	{
+		return TRUE;
+	}
+#ifdef ZCL_LEVEL_CTRL
+	if (sampleLight_levelTransitionActive())
+	{
+		return TRUE;
+	}
+#endif
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+	if (sampleLight_colorTransitionActive())
+	{
+		return TRUE;
+	}
+#endif
+	return FALSE;
+}
+
+/*********************************************************************
+ * @fn      light_fadeActive
+ *
+ * @brief   whether a level or color fade with an end point is in progress.
+ *          Color loops and streams run until stopped and are not counted.
+ *
+ * @param   None
+ *
+ * @return  TRUE while the light is fading towards a target
+ */
+bool light_fadeActive(void)
+{
+	if (lightTrans_active())
+	{
+		return TRUE;
+	}
+#ifdef ZCL_LEVEL_CTRL
+	if (sampleLight_levelTransitionActive())
+	{
+		return TRUE;
+	}
+#endif
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+	if (sampleLight_colorFadeActive())
+	{
+		return TRUE;
+	}
+#endif
+	return FALSE;
+}
+
+/*********************************************************************
+ * @fn      light_transitionStop
+ *
+ * @brief   abort every level and color transition in progress
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void light_transitionStop(void)
+{
+	lightTrans_stop();
+#ifdef ZCL_LEVEL_CTRL
+	sampleLight_levelTransitionStop();
+#endif
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+	sampleLight_colorTransitionStop();
+#endif
 }
 
 /*********************************************************************
@@ -444,6 +538,13 @@ void light_applyUpdate(u8 *curLevel, u16 *curLevel256, s32 *stepLevel256, u16 *r
 		*curLevel = *curLevel256 / 256;
 	}
 
+	// A move without wrap ends at the limit it runs into, it would keep the timer going forever otherwise
+	if (!wrap && (*remainingTime == 0xFFFF) &&
+		(((*stepLevel256 > 0) && (*curLevel >= maxLevel)) || ((*stepLevel256 < 0) && (*curLevel <= minLevel))))
+	{
+		*remainingTime = 0;
+	}
+
 	if (*remainingTime == 0)
 	{
 		*curLevel256 = ((u16)*curLevel) * 256;
@@ -497,6 +598,13 @@ void light_applyUpdate_16(u16 *curLevel, u32 *curLevel256, s32 *stepLevel256, u1
 {
 	light_computeUpdate_16(curLevel, curLevel256, stepLevel256, minLevel, maxLevel, wrap);
 
+	// See light_applyUpdate
+	if (!wrap && (*remainingTime == 0xFFFF) &&
+		(((*stepLevel256 > 0) && (*curLevel >= maxLevel)) || ((*stepLevel256 < 0) && (*curLevel <= minLevel))))
+	{
+		*remainingTime = 0;
+	}
+
 	if (*remainingTime == 0)
 	{
 		*curLevel256 = ((u32)*curLevel) * 256;
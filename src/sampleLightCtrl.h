@@ -40,6 +40,9 @@ void hwLight_colorUpdate_XY2RGB(u16 x, u16 y, u8 level);
 
 void light_adjust(void);
 void light_fresh(void);
+bool light_transitionActive(void);
+bool light_fadeActive(void);
+void light_transitionStop(void);
 void light_applyUpdate(u8 *curLevel, u16 *curLevel256, s32 *stepLevel256, u16 *remainingTime, u8 minLevel, u8 maxLevel, bool wrap);
 void light_applyUpdate_16(u16 *curLevel, u32 *curLevel256, s32 *stepLevel256, u16 *remainingTime, u16 minLevel, u16 maxLevel, bool wrap);
 void light_applyXYUpdate_16(u16 *curX, u32 *curX256, s32 *stepX256, u16 *curY, u32 *curY256, s32 *stepY256, u16 *remainingTime, u16 minLevel, u16 maxLevel, bool wrap);
@@ -29,6 +29,14 @@
 #include "tl_common.h"
 #include "zcl_include.h"
 #include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightNv.h"
+#include "zcl_lightExt.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
+#include "sampleLightBrownOut.h"
+
+extern void sampleLight_colorInit(void);
 
 /**********************************************************************
  * LOCAL CONSTANTS
@@ -91,6 +99,12 @@ const u16 sampleLight_inClusterList[] =
 #ifdef ZCL_WWAH
 		ZCL_CLUSTER_WWAH,
 #endif
+#ifdef ZCL_TIME
+		ZCL_CLUSTER_GEN_TIME,
+#endif
+#ifdef ZCL_LIGHT_EXT
+		ZCL_CLUSTER_LIGHT_EXT,
+#endif
 };
 
 /**
@@ -310,6 +324,64 @@ const zclAttrInfo_t lightColorCtrl_attrTbl[] =
 
 #define ZCL_COLOR_ATTR_NUM sizeof(lightColorCtrl_attrTbl) / sizeof(zclAttrInfo_t)
 
+#ifdef ZCL_TIME
+/* Time, written by the coordinator, then kept running locally */
+zcl_timeAttr_t g_zcl_timeAttrs =
+	{
+		.time = 0,
+		.timeStatus = 0,
+		.timeZone = 0,
+		.dstStart = 0,
+		.dstEnd = 0,
+		.dstShift = 0,
+		.standardTime = 0,
+		.localTime = 0,
+};
+
+const zclAttrInfo_t time_attrTbl[] =
+	{
+		{ZCL_ATTRID_TIME, ZCL_DATA_TYPE_UTC, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_timeAttrs.time},
+		{ZCL_ATTRID_TIME_STATUS, ZCL_DATA_TYPE_BITMAP8, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_timeAttrs.timeStatus},
+		{ZCL_ATTRID_TIME_ZONE, ZCL_DATA_TYPE_INT32, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_timeAttrs.timeZone},
+		{ZCL_ATTRID_DST_START, ZCL_DATA_TYPE_UINT32, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_timeAttrs.dstStart},
+		{ZCL_ATTRID_DST_END, ZCL_DATA_TYPE_UINT32, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_timeAttrs.dstEnd},
+		{ZCL_ATTRID_DST_SHIFT, ZCL_DATA_TYPE_INT32, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_timeAttrs.dstShift},
+		{ZCL_ATTRID_STANDARD_TIME, ZCL_DATA_TYPE_UINT32, ACCESS_CONTROL_READ, (u8 *)&g_zcl_timeAttrs.standardTime},
+		{ZCL_ATTRID_LOCAL_TIME, ZCL_DATA_TYPE_UINT32, ACCESS_CONTROL_READ, (u8 *)&g_zcl_timeAttrs.localTime},
+
+		{ZCL_ATTRID_GLOBAL_CLUSTER_REVISION, ZCL_DATA_TYPE_UINT16, ACCESS_CONTROL_READ, (u8 *)&zcl_attr_global_clusterRevision},
+};
+
+#define ZCL_TIME_ATTR_NUM sizeof(time_attrTbl) / sizeof(zclAttrInfo_t)
+#endif
+
+#ifdef ZCL_LIGHT_EXT
+/* Light extension, manufacturer specific */
+zcl_lightExtAttr_t g_zcl_lightExtAttrs =
+	{
+		.otaBlockPeriod = 0,
+		.brownOutTripMv = LIGHT_BROWN_OUT_TRIP_MV_DEFAULT,
+		.brownOutRecoverMv = LIGHT_BROWN_OUT_RECOVER_MV_DEFAULT,
+		.brownOutIntervalMs = LIGHT_BROWN_OUT_INTERVAL_MS_DEFAULT,
+		.brownOutTripSamples = LIGHT_BROWN_OUT_TRIP_SAMPLES_DEFAULT,
+};
+
+const zclAttrInfo_t lightExt_attrTbl[] =
+	{
+		{ZCL_ATTRID_LIGHT_EXT_OTA_BLOCK_PERIOD, ZCL_DATA_TYPE_UINT16, ACCESS_CONTROL_READ | ACCESS_CONTROL_REPORTABLE, (u8 *)&g_zcl_lightExtAttrs.otaBlockPeriod},
+#if LIGHT_BROWN_OUT_ENABLE
+		{ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_TRIP_MV, ZCL_DATA_TYPE_UINT16, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_lightExtAttrs.brownOutTripMv},
+		{ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_RECOVER_MV, ZCL_DATA_TYPE_UINT16, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_lightExtAttrs.brownOutRecoverMv},
+		{ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_INTERVAL_MS, ZCL_DATA_TYPE_UINT16, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_lightExtAttrs.brownOutIntervalMs},
+		{ZCL_ATTRID_LIGHT_EXT_BROWN_OUT_TRIP_SAMPLES, ZCL_DATA_TYPE_UINT8, ACCESS_CONTROL_READ | ACCESS_CONTROL_WRITE, (u8 *)&g_zcl_lightExtAttrs.brownOutTripSamples},
+#endif
+
+		{ZCL_ATTRID_GLOBAL_CLUSTER_REVISION, ZCL_DATA_TYPE_UINT16, ACCESS_CONTROL_READ, (u8 *)&zcl_attr_global_clusterRevision},
+};
+
+#define ZCL_LIGHT_EXT_ATTR_NUM sizeof(lightExt_attrTbl) / sizeof(zclAttrInfo_t)
+#endif
+
 /**
  *  @brief Definition for simple light ZCL specific cluster
  */
@@ -322,74 +394,161 @@ const zcl_specClusterInfo_t g_sampleLightClusterList[] =
 		{ZCL_CLUSTER_GEN_ON_OFF, MANUFACTURER_CODE_NONE, ZCL_ONOFF_ATTR_NUM, onOff_attrTbl, zcl_onOff_register, sampleLight_onOffCb},
 		{ZCL_CLUSTER_GEN_LEVEL_CONTROL, MANUFACTURER_CODE_NONE, ZCL_LEVEL_ATTR_NUM, level_attrTbl, zcl_level_register, sampleLight_levelCb},
 		{ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, MANUFACTURER_CODE_NONE, ZCL_COLOR_ATTR_NUM, lightColorCtrl_attrTbl, zcl_lightColorCtrl_register, sampleLight_colorCtrlCb},
+#ifdef ZCL_TIME
+		{ZCL_CLUSTER_GEN_TIME, MANUFACTURER_CODE_NONE, ZCL_TIME_ATTR_NUM, time_attrTbl, zcl_time_register, NULL},
+#endif
+#ifdef ZCL_LIGHT_EXT
+		{ZCL_CLUSTER_LIGHT_EXT, ZCL_LIGHT_EXT_MANU_CODE, ZCL_LIGHT_EXT_ATTR_NUM, lightExt_attrTbl, zcl_lightExt_register, sampleLight_lightExtCb},
+#endif
 };
 
 u8 SAMPLELIGHT_CB_CLUSTER_NUM = (sizeof(g_sampleLightClusterList) / sizeof(g_sampleLightClusterList[0]));
 
+/**
+ *  @brief Factory default attribute values, captured from the initializers above before any restore
+ */
+static u8 zcl_basicDevEnableDefault;
+static zcl_onOffAttr_t zcl_onOffAttrsDefault;
+static zcl_levelAttr_t zcl_levelAttrsDefault;
+static zcl_lightColorCtrlAttr_t zcl_colorCtrlAttrsDefault;
+
+#if NV_ENABLE
+/**
+ *  @brief Copy of the record last committed to (or restored from) flash
+ */
+static light_state_record_t lightStateShadow;
+static bool lightStateShadowValid = FALSE;
+#endif
+
 /**********************************************************************
  * FUNCTIONS
  */
 
 /*********************************************************************
- * @fn      zcl_onOffAttr_save
+ * @fn      zcl_lightStateRecordBuild
  *
- * @brief
+ * @brief   Packs the current on/off, level and color attributes into a record
  *
- * @param   None
+ * @param   pRec - record to fill in, including version and crc
  *
- * @return
+ * @return  None
  */
-nv_sts_t zcl_onOffAttr_save(void)
+static void zcl_lightStateRecordBuild(light_state_record_t *pRec)
 {
-	nv_sts_t st = NV_SUCC;
+	memset((u8 *)pRec, 0, sizeof(light_state_record_t));
 
-#if NV_ENABLE
-	zcl_nv_onOff_t zcl_nv_onOff;
+	pRec->version = LIGHT_STATE_RECORD_VERSION;
+
+	pRec->onOff = g_zcl_onOffAttrs.onOff;
+	pRec->startUpOnOff = g_zcl_onOffAttrs.startUpOnOff;
+
+	pRec->level = g_zcl_levelAttrs.curLevel;
+	pRec->startUpLevel = g_zcl_levelAttrs.startUpCurrentLevel;
 
-	st = nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_ON_OFF, sizeof(zcl_nv_onOff_t), (u8 *)&zcl_nv_onOff);
+	pRec->colorMode = g_zcl_colorCtrlAttrs.colorMode;
+	pRec->enhancedColorMode = g_zcl_colorCtrlAttrs.enhancedColorMode;
+	pRec->hue = g_zcl_colorCtrlAttrs.currentHue;
+	pRec->saturation = g_zcl_colorCtrlAttrs.currentSaturation;
+	pRec->enhancedHue = g_zcl_colorCtrlAttrs.enhancedCurrentHue;
+	pRec->x = g_zcl_colorCtrlAttrs.currentX;
+	pRec->y = g_zcl_colorCtrlAttrs.currentY;
+	pRec->mireds = g_zcl_colorCtrlAttrs.colorTemperatureMireds;
+	pRec->startUpMireds = g_zcl_colorCtrlAttrs.startUpColorTemperatureMireds;
 
-	bool onOffAttrsDiffer = st == NV_ITEM_NOT_FOUND ||
-							(st == NV_SUCC && (zcl_nv_onOff.startUp != g_zcl_onOffAttrs.startUpOnOff || zcl_nv_onOff.lastState != g_zcl_onOffAttrs.onOff));
+	pRec->crc = xcrc32((u8 *)pRec + sizeof(pRec->crc), sizeof(light_state_record_t) - sizeof(pRec->crc), 0xffffffff);
+}
 
-	if (onOffAttrsDiffer)
+/*********************************************************************
+ * @fn      zcl_lightStateRecordValid
+ *
+ * @brief   Checks version and crc of a record read back from flash
+ *
+ * @param   pRec
+ *
+ * @return  TRUE if the record can be applied
+ */
+static bool zcl_lightStateRecordValid(const light_state_record_t *pRec)
+{
+	if (pRec->version != LIGHT_STATE_RECORD_VERSION)
 	{
-		zcl_nv_onOff.startUp = g_zcl_onOffAttrs.startUpOnOff;
-		zcl_nv_onOff.lastState = g_zcl_onOffAttrs.onOff;
-		st = nv_flashWriteNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_ON_OFF, sizeof(zcl_nv_onOff_t), (u8 *)&zcl_nv_onOff);
+		return FALSE;
 	}
 
-#else
-	st = NV_ENABLE_PROTECT_ERROR;
-#endif
+	return pRec->crc == xcrc32((u8 *)pRec + sizeof(pRec->crc), sizeof(light_state_record_t) - sizeof(pRec->crc), 0xffffffff);
+}
 
-	return st;
+/*********************************************************************
+ * @fn      zcl_lightStateRecordApply
+ *
+ * @brief   Unpacks a record into the on/off, level and color attributes
+ *
+ * @param   pRec
+ *
+ * @return  None
+ */
+static void zcl_lightStateRecordApply(const light_state_record_t *pRec)
+{
+	g_zcl_onOffAttrs.onOff = pRec->onOff;
+	g_zcl_onOffAttrs.startUpOnOff = pRec->startUpOnOff;
+
+	g_zcl_levelAttrs.curLevel = pRec->level;
+	g_zcl_levelAttrs.startUpCurrentLevel = pRec->startUpLevel;
+
+	g_zcl_colorCtrlAttrs.colorMode = pRec->colorMode;
+	g_zcl_colorCtrlAttrs.enhancedColorMode = pRec->enhancedColorMode;
+	g_zcl_colorCtrlAttrs.currentHue = pRec->hue;
+	g_zcl_colorCtrlAttrs.currentSaturation = pRec->saturation;
+	g_zcl_colorCtrlAttrs.enhancedCurrentHue = pRec->enhancedHue;
+	g_zcl_colorCtrlAttrs.currentX = pRec->x;
+	g_zcl_colorCtrlAttrs.currentY = pRec->y;
+	g_zcl_colorCtrlAttrs.colorTemperatureMireds = pRec->mireds;
+	g_zcl_colorCtrlAttrs.startUpColorTemperatureMireds = pRec->startUpMireds;
 }
 
 /*********************************************************************
- * @fn      zcl_onOffAttr_restore
+ * @fn      zcl_lightStateAttr_save
  *
- * @brief   Restores the on/off behavior on startup according to the zigbee specs.
+ * @brief   Saves on/off, level and color attributes as one record.
+ *          Flash is written only when the record differs from the shadow.
  *
  * @param   None
  *
- * @return
+ * @return  the result of the flash operation
  */
-nv_sts_t zcl_onOffAttr_restore(void)
+nv_sts_t zcl_lightStateAttr_save(void)
 {
 	nv_sts_t st = NV_SUCC;
 
 #if NV_ENABLE
-	zcl_nv_onOff_t zcl_nv_onOff;
+	light_state_record_t rec;
+	light_nvStats_t *pStats = lightNv_statsGet();
 
-	st = nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_ON_OFF, sizeof(zcl_nv_onOff_t), (u8 *)&zcl_nv_onOff);
+	zcl_lightStateRecordBuild(&rec);
 
-	if (st != NV_SUCC)
+	/* Dirty check against the RAM shadow, flash is never read back here */
+	if (lightStateShadowValid)
 	{
-		return st;
+		pStats->flashReadsSaved++;
+
+		if (!memcmp((u8 *)&lightStateShadow, (u8 *)&rec, sizeof(light_state_record_t)))
+		{
+			pStats->flashWritesSaved++;
+			return NV_SUCC;
+		}
+	}
+
+#if LIGHT_JOURNAL_ENABLE
+	st = lightJournal_append(&rec);
+#else
+	st = nv_flashWriteNew(1, NV_MODULE_APP, NV_ITEM_APP_LIGHT_STATE, sizeof(light_state_record_t), (u8 *)&rec);
+#endif
+	pStats->flashWrites++;
+
+	if (st == NV_SUCC)
+	{
+		memcpy((u8 *)&lightStateShadow, (u8 *)&rec, sizeof(light_state_record_t));
+		lightStateShadowValid = TRUE;
 	}
-		
-	g_zcl_onOffAttrs.startUpOnOff = zcl_nv_onOff.startUp;
-	g_zcl_onOffAttrs.onOff = zcl_nv_onOff.lastState;
 #else
 	st = NV_ENABLE_PROTECT_ERROR;
 #endif
@@ -398,33 +557,50 @@ nv_sts_t zcl_onOffAttr_restore(void)
 }
 
 /*********************************************************************
- * @fn      zcl_levelAttr_save
+ * @fn      zcl_lightStateAttr_restore
  *
- * @brief
+ * @brief   Restores on/off, level and color attributes from one record,
+ *          taken from the journal first and the NV module otherwise
  *
  * @param   None
  *
- * @return
+ * @return  NV_SUCC if a valid record was applied
  */
-nv_sts_t zcl_levelAttr_save(void)
+nv_sts_t zcl_lightStateAttr_restore(void)
 {
 	nv_sts_t st = NV_SUCC;
 
 #if NV_ENABLE
-	zcl_nv_level_t zcl_nv_level;
+	light_state_record_t rec;
 
-	st = nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_LEVEL, sizeof(zcl_nv_level_t), (u8 *)&zcl_nv_level);
-
-	bool levelAttrsNeedsUpdate = st == NV_ITEM_NOT_FOUND || (st == NV_SUCC && (zcl_nv_level.startUp != g_zcl_levelAttrs.startUpCurrentLevel || zcl_nv_level.lastLevel != g_zcl_levelAttrs.curLevel));
-
-	if (levelAttrsNeedsUpdate)
+#if LIGHT_JOURNAL_ENABLE
+	if (!lightJournal_init(&rec))
+#endif
 	{
-		zcl_nv_level.startUp = g_zcl_levelAttrs.startUpCurrentLevel;
-		zcl_nv_level.lastLevel = g_zcl_levelAttrs.curLevel;
-
-		st = nv_flashWriteNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_LEVEL, sizeof(zcl_nv_level_t), (u8 *)&zcl_nv_level);
+		st = nv_flashReadNew(1, NV_MODULE_APP, NV_ITEM_APP_LIGHT_STATE, sizeof(light_state_record_t), (u8 *)&rec);
+
+		if (st != NV_SUCC)
+		{
+			return st;
+		}
+
+		if (!zcl_lightStateRecordValid(&rec))
+		{
+			return NV_ITEM_NOT_FOUND;
+		}
+
+#if LIGHT_JOURNAL_ENABLE
+		/* record from the NV module, move it into the journal */
+		lightNv_enqueue(LIGHT_NV_OP_STATE);
+		zcl_lightStateRecordApply(&rec);
+		return st;
+#endif
 	}
 
+	zcl_lightStateRecordApply(&rec);
+
+	memcpy((u8 *)&lightStateShadow, (u8 *)&rec, sizeof(light_state_record_t));
+	lightStateShadowValid = TRUE;
 #else
 	st = NV_ENABLE_PROTECT_ERROR;
 #endif
@@ -432,71 +608,105 @@ nv_sts_t zcl_levelAttr_save(void)
 	return st;
 }
 
+#if NV_ENABLE
 /*********************************************************************
- * @fn      zcl_levelAttr_restore
+ * @fn      zcl_lightStateAttr_migrate
  *
- * @brief
+ * @brief   Reads the per-cluster items written by older firmware.
+ *          They are no longer updated once the consolidated record exists.
  *
  * @param   None
  *
- * @return
+ * @return  TRUE if at least one of the old items was found
  */
-nv_sts_t zcl_levelAttr_restore(void)
+static bool zcl_lightStateAttr_migrate(void)
 {
-	nv_sts_t st = NV_SUCC;
-
-#if NV_ENABLE
+	bool found = FALSE;
+	zcl_nv_onOff_t zcl_nv_onOff;
 	zcl_nv_level_t zcl_nv_level;
+	zcl_nv_colorCtrl_t zcl_nv_colorCtrl;
 
-	st = nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_LEVEL, sizeof(zcl_nv_level_t), (u8 *)&zcl_nv_level);
+	if (nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_ON_OFF, sizeof(zcl_nv_onOff_t), (u8 *)&zcl_nv_onOff) == NV_SUCC)
+	{
+		g_zcl_onOffAttrs.startUpOnOff = zcl_nv_onOff.startUp;
+		g_zcl_onOffAttrs.onOff = zcl_nv_onOff.lastState;
+		found = TRUE;
+	}
 
-	if (st == NV_SUCC)
+	if (nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_LEVEL, sizeof(zcl_nv_level_t), (u8 *)&zcl_nv_level) == NV_SUCC)
 	{
 		g_zcl_levelAttrs.startUpCurrentLevel = zcl_nv_level.startUp;
 		g_zcl_levelAttrs.curLevel = zcl_nv_level.lastLevel;
+		found = TRUE;
 	}
-#else
-	st = NV_ENABLE_PROTECT_ERROR;
-#endif
 
-	return st;
+	if (nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_COLOR_CTRL, sizeof(zcl_nv_colorCtrl_t), (u8 *)&zcl_nv_colorCtrl) == NV_SUCC)
+	{
+		g_zcl_colorCtrlAttrs.startUpColorTemperatureMireds = zcl_nv_colorCtrl.startUpMireds;
+		g_zcl_colorCtrlAttrs.colorTemperatureMireds = zcl_nv_colorCtrl.lastMireds;
+		found = TRUE;
+	}
+
+	return found;
 }
+#endif
 
 /*********************************************************************
- * @fn      zcl_colorCtrlAttr_save
+ * @fn      zcl_lightStartUpApply
  *
- * @brief   Saves the color attribute to nvram to later estore them
+ * @brief   Applies the StartUpOnOff, StartUpCurrentLevel and
+ *          StartUpColorTemperatureMireds attributes to the restored state
  *
  * @param   None
  *
- * @return the result of the flash write operation
+ * @return  None
  */
-nv_sts_t zcl_colorCtrlAttr_save(void)
+static void zcl_lightStartUpApply(void)
 {
-	nv_sts_t st = NV_SUCC;
-
-#if NV_ENABLE
-	zcl_nv_colorCtrl_t nv;
-	st = nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_COLOR_CTRL, sizeof(zcl_nv_colorCtrl_t), (u8 *)&nv);
-
-	zcl_lightColorCtrlAttr_t c = g_zcl_colorCtrlAttrs;
-
-	// Check if the item does not exist in nvram, or the values differ
-	bool colorAttrsDiffer = st == NV_ITEM_NOT_FOUND || (st == NV_SUCC && (nv.startUpMireds != c.startUpColorTemperatureMireds || nv.lastMireds != c.colorTemperatureMireds));
+#ifdef ZCL_ON_OFF
+	switch (g_zcl_onOffAttrs.startUpOnOff)
+	{
+	case ZCL_START_UP_ONOFF_SET_ONOFF_TO_OFF:
+		g_zcl_onOffAttrs.onOff = ZCL_ONOFF_STATUS_OFF;
+		break;
+	case ZCL_START_UP_ONOFF_SET_ONOFF_TO_ON:
+		g_zcl_onOffAttrs.onOff = ZCL_ONOFF_STATUS_ON;
+		break;
+	case ZCL_START_UP_ONOFF_SET_ONOFF_TOGGLE:
+		g_zcl_onOffAttrs.onOff = (g_zcl_onOffAttrs.onOff == ZCL_ONOFF_STATUS_ON) ? ZCL_ONOFF_STATUS_OFF : ZCL_ONOFF_STATUS_ON;
+		/* the next power cycle toggles from this state, not from the stored one */
+		lightNv_enqueue(LIGHT_NV_OP_STATE);
+		break;
+	default:
+		// ZCL_START_UP_ONOFF_SET_ONOFF_TO_PREVIOUS
+		break;
+	}
+#endif
 
-	if (colorAttrsDiffer)
+#ifdef ZCL_LEVEL_CTRL
+	if (g_zcl_levelAttrs.startUpCurrentLevel == ZCL_START_UP_CURRENT_LEVEL_TO_MIN)
+	{
+		g_zcl_levelAttrs.curLevel = ZCL_LEVEL_ATTR_MIN_LEVEL;
+	}
+	else if (g_zcl_levelAttrs.startUpCurrentLevel != ZCL_START_UP_CURRENT_LEVEL_TO_PREVIOUS)
 	{
-		nv.startUpMireds = c.startUpColorTemperatureMireds;
-		nv.lastMireds = c.colorTemperatureMireds;
-		st = nv_flashWriteNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_COLOR_CTRL, sizeof(zcl_nv_colorCtrl_t), (u8 *)&nv);
+		g_zcl_levelAttrs.curLevel = g_zcl_levelAttrs.startUpCurrentLevel;
 	}
 #endif
 
-	return st;
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+	// A fixed start up temperature also selects the color temperature mode, otherwise the whole color state is kept
+	if (g_zcl_colorCtrlAttrs.startUpColorTemperatureMireds != ZCL_START_UP_COLOR_TEMPERATURE_MIREDS_TO_PREVIOUS)
+	{
+		g_zcl_colorCtrlAttrs.colorTemperatureMireds = g_zcl_colorCtrlAttrs.startUpColorTemperatureMireds;
+		g_zcl_colorCtrlAttrs.colorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
+		g_zcl_colorCtrlAttrs.enhancedColorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
+	}
+#endif
 }
 
 /*********************************************************************
- * @fn      zcl_colorCtrlAttr_restore
+ * @fn      zcl_sampleLightAttrsInit
  *
  * @brief
  *
@@ -504,41 +714,67 @@ nv_sts_t zcl_colorCtrlAttr_save(void)
  *
  * @return
  */
-nv_sts_t zcl_colorCtrlAttr_restore(void)
+void zcl_sampleLightAttrsInit(void)
 {
-	nv_sts_t st = NV_SUCC;
-
-#if NV_ENABLE
-	zcl_nv_colorCtrl_t zcl_nv_colorCtrl;
-
-	st = nv_flashReadNew(1, NV_MODULE_ZCL, NV_ITEM_ZCL_COLOR_CTRL, sizeof(zcl_nv_colorCtrl_t), (u8 *)&zcl_nv_colorCtrl);
+	zcl_basicDevEnableDefault = g_zcl_basicAttrs.deviceEnable;
+	memcpy((u8 *)&zcl_onOffAttrsDefault, (u8 *)&g_zcl_onOffAttrs, sizeof(zcl_onOffAttr_t));
+	memcpy((u8 *)&zcl_levelAttrsDefault, (u8 *)&g_zcl_levelAttrs, sizeof(zcl_levelAttr_t));
+	memcpy((u8 *)&zcl_colorCtrlAttrsDefault, (u8 *)&g_zcl_colorCtrlAttrs, sizeof(zcl_lightColorCtrlAttr_t));
 
-	if (st == NV_SUCC)
+	if (zcl_lightStateAttr_restore() != NV_SUCC)
 	{
-		g_zcl_colorCtrlAttrs.startUpColorTemperatureMireds = zcl_nv_colorCtrl.startUpMireds;
-		g_zcl_colorCtrlAttrs.colorTemperatureMireds = zcl_nv_colorCtrl.lastMireds;
-	}
-#else
-	st = NV_ENABLE_PROTECT_ERROR;
+#if NV_ENABLE
+		/* First boot after an upgrade: take over the old items and write them as one record */
+		if (zcl_lightStateAttr_migrate())
+		{
+			lightNv_enqueue(LIGHT_NV_OP_STATE);
+		}
 #endif
+	}
 
-	return st;
+	zcl_lightStartUpApply();
 }
 
 /*********************************************************************
- * @fn      zcl_sampleLightAttrsInit
+ * @fn      zcl_sampleLightAttrsReset
  *
- * @brief
+ * @brief   Basic cluster Reset to Factory Defaults. Every application
+ *          attribute goes back to its default, the light is rendered once
+ *          and the state is persisted with a single record write.
+ *          Network, group and scene table contents and the time are
+ *          kept, the animation program and circadian schedule are erased.
  *
  * @param   None
  *
- * @return
+ * @return  None
  */
-void zcl_sampleLightAttrsInit(void)
+void zcl_sampleLightAttrsReset(void)
 {
-	zcl_onOffAttr_restore();
-	zcl_levelAttr_restore();
-	zcl_colorCtrlAttr_restore();
+#ifdef ZCL_LIGHT_EXT
+	lightAnim_clear();
+#endif
+#if LIGHT_CIRCADIAN_ENABLE
+	lightCircadian_clear();
+#endif
+	light_transitionStop();
+
+	g_zcl_basicAttrs.deviceEnable = zcl_basicDevEnableDefault;
+	g_zcl_identifyAttrs.identifyTime = 0;
+
+#ifdef ZCL_SCENE
+	g_zcl_sceneAttrs.currentScene = 0;
+	g_zcl_sceneAttrs.currentGroup = 0x0000;
+	g_zcl_sceneAttrs.sceneValid = FALSE;
+#endif
+
+	memcpy((u8 *)&g_zcl_onOffAttrs, (u8 *)&zcl_onOffAttrsDefault, sizeof(zcl_onOffAttr_t));
+	memcpy((u8 *)&g_zcl_levelAttrs, (u8 *)&zcl_levelAttrsDefault, sizeof(zcl_levelAttr_t));
+	memcpy((u8 *)&g_zcl_colorCtrlAttrs, (u8 *)&zcl_colorCtrlAttrsDefault, sizeof(zcl_lightColorCtrlAttr_t));
+
+	/* Resyncs the color engine with the new values, its single light_fresh() renders color and on/off together */
+	sampleLight_colorInit();
+
+	lightNv_enqueue(LIGHT_NV_OP_STATE);
 }
 
 #endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
@@ -0,0 +1,539 @@
+/********************************************************************************************************
+ * @file    sampleLightNv.c
+ *
+ * @brief   This is the source file for sampleLightNv
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightNv.h"
+#include "zcl_lightExt.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
+#include "sampleLightBrownOut.h"
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+/* One bit per light_nvOp_e. Queueing the same item twice collapses into one write. */
+static u8 lightNvPending = 0;
+
+/* Set while the supply is failing, no flash access is started */
+static bool lightNvHalted = FALSE;
+
+/* Start of the current fade deferral, 0 while nothing is deferred */
+static u32 lightNvDeferTick = 0;
+
+static light_nvStats_t lightNvStats = {0};
+
+#if LIGHT_JOURNAL_ENABLE
+/* The OTA image of the SDK flash map must end below the journal */
+typedef char lightJournal_mapCheck_t[(FLASH_ADDR_OF_OTA_IMAGE + FLASH_OTA_IMAGE_MAX_SIZE <= LIGHT_JOURNAL_BASE) ? 1 : -1];
+
+/* Active sector and the next free slot in it */
+static u8 lightJournalSector = 0;
+static u8 lightJournalSlot = 0;
+static u32 lightJournalSeq = 0;
+
+/* The sector after the active one is erased already */
+static bool lightJournalSpareErased = FALSE;
+
+static void lightJournal_spareErase(void);
+#endif
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightNv_popCount
+ *
+ * @brief   Number of pending operations
+ *
+ * @param   mask - pending operation bits
+ *
+ * @return  queue depth
+ */
+static u8 lightNv_popCount(u8 mask)
+{
+	u8 cnt = 0;
+
+	while (mask)
+	{
+		mask &= mask - 1;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/*********************************************************************
+ * @fn      lightNv_execute
+ *
+ * @brief   Run one NV operation and account for the time it blocked
+ *
+ * @param   op - light_nvOp_e
+ *
+ * @return  None
+ */
+static void lightNv_execute(u8 op)
+{
+	u32 startTick = clock_time();
+
+	switch (op)
+	{
+	case LIGHT_NV_OP_STATE:
+		zcl_lightStateAttr_save();
+		break;
+#ifdef ZCL_LIGHT_EXT
+	case LIGHT_NV_OP_ANIM:
+		lightAnim_save();
+		break;
+#endif
+#if LIGHT_CIRCADIAN_ENABLE
+	case LIGHT_NV_OP_CIRCADIAN:
+		lightCircadian_save();
+		break;
+#endif
+#if LIGHT_BROWN_OUT_ENABLE
+	case LIGHT_NV_OP_BROWN_OUT_CFG:
+		lightBrownOut_save();
+		break;
+#endif
+#if LIGHT_JOURNAL_ENABLE
+	case LIGHT_NV_OP_JOURNAL_ERASE:
+		lightJournal_spareErase();
+		break;
+#endif
+	default:
+		break;
+	}
+
+	lightNvStats.lastBlockUs = (clock_time() - startTick) / CLOCK_16M_SYS_TIMER_CLK_1US;
+	if (lightNvStats.lastBlockUs > lightNvStats.worstBlockUs)
+	{
+		lightNvStats.worstBlockUs = lightNvStats.lastBlockUs;
+	}
+	lightNvStats.opsDone++;
+}
+
+/*********************************************************************
+ * @fn      lightNv_enqueue
+ *
+ * @brief   Schedule an NV operation to be run from the idle loop
+ *
+ * @param   op - light_nvOp_e
+ *
+ * @return  None
+ */
+void lightNv_enqueue(u8 op)
+{
+	if (op >= LIGHT_NV_OP_MAX)
+	{
+		return;
+	}
+
+	lightNvPending |= BIT(op);
+
+	lightNvStats.queueDepth = lightNv_popCount(lightNvPending);
+	if (lightNvStats.queueDepth > lightNvStats.maxQueueDepth)
+	{
+		lightNvStats.maxQueueDepth = lightNvStats.queueDepth;
+	}
+}
+
+/*********************************************************************
+ * @fn      lightNv_noErase
+ *
+ * @brief   Whether an operation is a plain record write that cannot erase
+ *          a sector. Only such operations may be forced during a fade.
+ *
+ * @param   op - light_nvOp_e
+ *
+ * @return  TRUE if the operation never erases flash
+ */
+static bool lightNv_noErase(u8 op)
+{
+#if LIGHT_JOURNAL_ENABLE
+	if (op == LIGHT_NV_OP_STATE)
+	{
+		/* a full active sector moves on to the spare, which may still need an erase */
+		return (lightJournalSlot < LIGHT_JOURNAL_SLOTS_PER_SECTOR) || lightJournalSpareErased;
+	}
+#endif
+
+	/* the spare erase itself, and the NV module, which erases whenever a sector fills up */
+	return FALSE;
+}
+
+/*********************************************************************
+ * @fn      lightNv_process
+ *
+ * @brief   Run at most one pending NV operation. Called once per idle slot.
+ *          A write may trigger a sector erase inside the NV module, so nothing
+ *          is done while the stack has work to do or the light is fading.
+ *          A fade holds record writes for at most LIGHT_NV_DEFER_MAX_MS, an
+ *          operation that may erase waits for the end of the fade. Color
+ *          loops and streams never end on their own and do not hold it.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightNv_process(void)
+{
+	bool forced = FALSE;
+
+	if (!lightNvPending || lightNvHalted)
+	{
+		lightNvDeferTick = 0;
+		return;
+	}
+
+	if (tl_stackBusy() || !zb_isTaskDone())
+	{
+		lightNvStats.opsDeferred++;
+		return;
+	}
+
+	if (light_fadeActive())
+	{
+		if (!lightNvDeferTick)
+		{
+			lightNvDeferTick = clock_time() | 1;
+		}
+
+		if (!clock_time_exceed(lightNvDeferTick, LIGHT_NV_DEFER_MAX_MS * 1000))
+		{
+			lightNvStats.opsDeferred++;
+			return;
+		}
+
+		forced = TRUE;
+	}
+
+	for (u8 op = 0; op < LIGHT_NV_OP_MAX; op++)
+	{
+		if ((lightNvPending & BIT(op)) && (!forced || lightNv_noErase(op)))
+		{
+			lightNvPending &= ~BIT(op);
+			lightNvStats.queueDepth = lightNv_popCount(lightNvPending);
+
+			if (forced)
+			{
+				lightNvStats.opsForced++;
+			}
+			lightNvDeferTick = 0;
+
+			lightNv_execute(op);
+			return;
+		}
+	}
+
+	/* only operations that may erase are left, they wait for the fade to end */
+	lightNvStats.opsDeferred++;
+}
+
+/*********************************************************************
+ * @fn      lightNv_flush
+ *
+ * @brief   Run every pending NV operation right now, regardless of load.
+ *          Only meant for paths that are about to reset the chip. The spare
+ *          journal sector is not erased here, the supply may be failing.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightNv_flush(void)
+{
+	if (lightNvHalted)
+	{
+		return;
+	}
+
+	for (u8 op = 0; op < LIGHT_NV_OP_MAX; op++)
+	{
+		if ((op != LIGHT_NV_OP_JOURNAL_ERASE) && (lightNvPending & BIT(op)))
+		{
+			lightNvPending &= ~BIT(op);
+			lightNv_execute(op);
+		}
+	}
+
+	lightNvStats.queueDepth = lightNv_popCount(lightNvPending);
+}
+
+/*********************************************************************
+ * @fn      lightNv_halt
+ *
+ * @brief   Stop or resume all light NV activity. Pending operations
+ *          are kept and run once the halt is lifted.
+ *
+ * @param   halt
+ *
+ * @return  None
+ */
+void lightNv_halt(bool halt)
+{
+	lightNvHalted = halt;
+}
+
+/*********************************************************************
+ * @fn      lightNv_queueDepth
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  number of NV operations waiting for an idle slot
+ */
+u8 lightNv_queueDepth(void)
+{
+	return lightNvStats.queueDepth;
+}
+
+/*********************************************************************
+ * @fn      lightNv_statsGet
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  pointer to the NV queue statistics
+ */
+light_nvStats_t *lightNv_statsGet(void)
+{
+	return &lightNvStats;
+}
+
+#if LIGHT_JOURNAL_ENABLE
+/*********************************************************************
+ * @fn      lightJournal_slotAddr
+ *
+ * @brief
+ *
+ * @param   sector - journal sector index
+ * @param   slot   - slot index inside the sector
+ *
+ * @return  flash address of the slot
+ */
+static u32 lightJournal_slotAddr(u8 sector, u8 slot)
+{
+	return LIGHT_JOURNAL_BASE + (u32)sector * LIGHT_JOURNAL_SECTOR_SIZE + (u32)slot * LIGHT_JOURNAL_SLOT_SIZE;
+}
+
+/*********************************************************************
+ * @fn      lightJournal_spareErase
+ *
+ * @brief   Erase the sector the journal moves to once the active one is full.
+ *          Queued as LIGHT_NV_OP_JOURNAL_ERASE while the supply is good, so a
+ *          record flushed on brown-out never waits for an erase.
+ *          The active sector must hold a valid record before this is queued.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightJournal_spareErase(void)
+{
+	if (lightJournalSpareErased)
+	{
+		return;
+	}
+
+	flash_erase(lightJournal_slotAddr((lightJournalSector + 1) % LIGHT_JOURNAL_SECTOR_NUM, 0));
+	lightNvStats.journalErases++;
+
+	lightJournalSpareErased = TRUE;
+}
+
+/*********************************************************************
+ * @fn      lightJournal_sectorStart
+ *
+ * @brief   Stamp a sector with the next sequence number, erasing it first
+ *          unless it is the spare erased ahead of time
+ *
+ * @param   sector - journal sector index
+ *
+ * @return  None
+ */
+static void lightJournal_sectorStart(u8 sector)
+{
+	light_journalHdr_t hdr;
+
+	if (!lightJournalSpareErased || (sector != (lightJournalSector + 1) % LIGHT_JOURNAL_SECTOR_NUM))
+	{
+		flash_erase(lightJournal_slotAddr(sector, 0));
+		lightNvStats.journalErases++;
+	}
+	lightJournalSpareErased = FALSE;
+
+	hdr.magic = LIGHT_JOURNAL_MAGIC;
+	hdr.seq = ++lightJournalSeq;
+	flash_write(lightJournal_slotAddr(sector, 0), sizeof(light_journalHdr_t), (u8 *)&hdr);
+
+	lightJournalSector = sector;
+	lightJournalSlot = 1;
+}
+
+/*********************************************************************
+ * @fn      lightJournal_scan
+ *
+ * @brief   Scan one sector for its newest valid record.
+ *          Records torn by a reset are skipped.
+ *
+ * @param   sector - journal sector index
+ * @param   pRec   - filled with the newest record when one is found
+ * @param   pFound - set TRUE when a record with a matching version and crc was found
+ *
+ * @return  first free slot of the sector
+ */
+static u8 lightJournal_scan(u8 sector, light_state_record_t *pRec, bool *pFound)
+{
+	light_state_record_t rec;
+	u8 slot;
+
+	for (slot = 1; slot < LIGHT_JOURNAL_SLOTS_PER_SECTOR; slot++)
+	{
+		flash_read(lightJournal_slotAddr(sector, slot), sizeof(light_state_record_t), (u8 *)&rec);
+
+		if ((rec.crc == 0xffffffff) && (rec.version == 0xff))
+		{
+			break;
+		}
+
+		if ((rec.version == LIGHT_STATE_RECORD_VERSION) &&
+			(rec.crc == xcrc32((u8 *)&rec + sizeof(rec.crc), sizeof(light_state_record_t) - sizeof(rec.crc), 0xffffffff)))
+		{
+			memcpy((u8 *)pRec, (u8 *)&rec, sizeof(light_state_record_t));
+			*pFound = TRUE;
+		}
+	}
+
+	return slot;
+}
+
+/*********************************************************************
+ * @fn      lightJournal_init
+ *
+ * @brief   Locate the active sector and scan it for the newest valid record.
+ *          A reset between the header of a new sector and its first record
+ *          leaves the active sector without one, the previous sector still
+ *          holds the last state then. The next append goes after the torn
+ *          records of the active sector.
+ *
+ * @param   pRec - filled with the newest record when one is found
+ *
+ * @return  TRUE if a record with a matching version and crc was found
+ */
+bool lightJournal_init(light_state_record_t *pRec)
+{
+	light_journalHdr_t hdr;
+	u8 sectorNum = 0;
+	u8 prevSector = 0;
+	bool found = FALSE;
+
+	lightJournalSpareErased = FALSE;
+
+	for (u8 sector = 0; sector < LIGHT_JOURNAL_SECTOR_NUM; sector++)
+	{
+		flash_read(lightJournal_slotAddr(sector, 0), sizeof(light_journalHdr_t), (u8 *)&hdr);
+
+		if (hdr.magic != LIGHT_JOURNAL_MAGIC)
+		{
+			continue;
+		}
+
+		/* wrap-safe compare of the sequence numbers */
+		if (!sectorNum || (s32)(hdr.seq - lightJournalSeq) > 0)
+		{
+			prevSector = lightJournalSector;
+			lightJournalSector = sector;
+			lightJournalSeq = hdr.seq;
+		}
+		else
+		{
+			prevSector = sector;
+		}
+		sectorNum++;
+	}
+
+	if (!sectorNum)
+	{
+		lightJournal_sectorStart(0);
+		return FALSE;
+	}
+
+	lightJournalSlot = lightJournal_scan(lightJournalSector, pRec, &found);
+
+	if (found)
+	{
+		/* The other sector holds older records only, clear it once idle */
+		lightNv_enqueue(LIGHT_NV_OP_JOURNAL_ERASE);
+	}
+	else if (sectorNum > 1)
+	{
+		/* kept until the active sector holds a record of its own */
+		lightJournal_scan(prevSector, pRec, &found);
+	}
+
+	return found;
+}
+
+/*********************************************************************
+ * @fn      lightJournal_append
+ *
+ * @brief   Write a record into the next free slot. When the active sector
+ *          is full the oldest sector is erased and becomes the active one.
+ *
+ * @param   pRec - record with version and crc already set
+ *
+ * @return  NV_SUCC
+ */
+nv_sts_t lightJournal_append(light_state_record_t *pRec)
+{
+	if (lightJournalSlot >= LIGHT_JOURNAL_SLOTS_PER_SECTOR)
+	{
+		lightJournal_sectorStart((lightJournalSector + 1) % LIGHT_JOURNAL_SECTOR_NUM);
+	}
+
+	flash_write(lightJournal_slotAddr(lightJournalSector, lightJournalSlot), sizeof(light_state_record_t), (u8 *)pRec);
+	lightJournalSlot++;
+
+	/* First record of a new sector, the previous one is not needed any more */
+	if (lightJournalSlot == 2)
+	{
+		lightNv_enqueue(LIGHT_NV_OP_JOURNAL_ERASE);
+	}
+
+	return NV_SUCC;
+}
+#endif
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
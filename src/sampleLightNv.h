@@ -0,0 +1,125 @@
+/********************************************************************************************************
+ * @file    sampleLightNv.h
+ *
+ * @brief   This is the header file for sampleLightNv
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_NV_H_
+#define _SAMPLE_LIGHT_NV_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+/**
+ *  @brief NV items of the application module used by the light
+ */
+#define NV_ITEM_APP_LIGHT_STATE NV_ITEM_APP_USER_CFG
+#define NV_ITEM_APP_BROWN_OUT_CFG (NV_ITEM_APP_USER_CFG + 1)
+#define NV_ITEM_APP_LIGHT_ANIM (NV_ITEM_APP_USER_CFG + 2)
+#define NV_ITEM_APP_CIRCADIAN (NV_ITEM_APP_USER_CFG + 3)
+#define NV_ITEM_APP_OTA_RESUME (NV_ITEM_APP_USER_CFG + 4)
+
+/**
+ *  @brief Flash region holding the light state journal.
+ *         The 512K normal mode map in the SDK's proj/drivers/drv_nv.h puts the
+ *         OTA image at FLASH_ADDR_OF_OTA_IMAGE (0x40000), FLASH_OTA_IMAGE_MAX_SIZE
+ *         (0x34000) long, and the MAC address at 0x76000. Nothing in that map
+ *         claims the two sectors in between, sampleLightNv.c fails the build
+ *         if the OTA image grows into them. Other flash sizes and the boot
+ *         loader map keep the record in the NV module.
+ */
+#if !FLASH_CAP_SIZE_1M && !BOOT_LOADER_MODE
+#define LIGHT_JOURNAL_ENABLE 1
+#define LIGHT_JOURNAL_BASE 0x74000
+#else
+#define LIGHT_JOURNAL_ENABLE 0
+#endif
+
+#define LIGHT_JOURNAL_SECTOR_SIZE 0x1000
+#define LIGHT_JOURNAL_SECTOR_NUM 2
+#define LIGHT_JOURNAL_SLOT_SIZE 32 // slot 0 of every sector holds light_journalHdr_t
+#define LIGHT_JOURNAL_SLOTS_PER_SECTOR (LIGHT_JOURNAL_SECTOR_SIZE / LIGHT_JOURNAL_SLOT_SIZE)
+#define LIGHT_JOURNAL_MAGIC 0x4c4a524e // "LJRN"
+
+/**
+ *  @brief Longest time a pending operation waits for a fade to finish
+ */
+#define LIGHT_NV_DEFER_MAX_MS 5000
+
+/**
+ *  @brief Deferred NV operations, each one is a single bounded flash access
+ */
+typedef enum
+{
+	LIGHT_NV_OP_STATE,
+	LIGHT_NV_OP_ANIM,
+	LIGHT_NV_OP_CIRCADIAN,
+	LIGHT_NV_OP_BROWN_OUT_CFG,
+	LIGHT_NV_OP_JOURNAL_ERASE, // erase the spare journal sector, never run by lightNv_flush()
+	LIGHT_NV_OP_MAX,
+} light_nvOp_e;
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Header at the start of each journal sector, the highest sequence is the active one
+ */
+typedef struct
+{
+	u32 magic;
+	u32 seq;
+} light_journalHdr_t;
+
+/**
+ *  @brief Statistics of the deferred NV queue
+ */
+typedef struct
+{
+	u32 worstBlockUs; // longest time a single operation blocked the main loop
+	u32 lastBlockUs;
+	u16 opsDone;
+	u16 opsDeferred; // idle slots skipped because a fade or the radio was busy
+	u16 opsForced;   // operations run during a fade after LIGHT_NV_DEFER_MAX_MS
+	u16 flashWrites;
+	u16 flashWritesSaved; // saves dropped because the RAM shadow already matched
+	u16 flashReadsSaved;  // read-back compares replaced by the RAM shadow
+	u16 journalErases;
+	u8 queueDepth;
+	u8 maxQueueDepth;
+} light_nvStats_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void lightNv_enqueue(u8 op);
+void lightNv_process(void);
+void lightNv_flush(void);
+void lightNv_halt(bool halt);
+u8 lightNv_queueDepth(void);
+light_nvStats_t *lightNv_statsGet(void);
+
+#if LIGHT_JOURNAL_ENABLE
+bool lightJournal_init(light_state_record_t *pRec);
+nv_sts_t lightJournal_append(light_state_record_t *pRec);
+#endif
+
+#endif /* _SAMPLE_LIGHT_NV_H_ */
@@ -0,0 +1,1138 @@
+/********************************************************************************************************
+ * @file    sampleLightOta.c
+ *
+ * @brief   This is the source file for sampleLightOta
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "ota.h"
+#include "zcl_lightExt.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightReport.h"
+#include "sampleLightNv.h"
+#include "sampleLightOta.h"
+
+#ifdef ZCL_OTA
+
+#ifndef ZCL_ATTRID_MIN_BLOCK_PERIOD
+#define ZCL_ATTRID_MIN_BLOCK_PERIOD 0x0009 // MinimumBlockPeriod of the OTA client
+#endif
+#ifndef ZCL_ATTRID_FILE_OFFSET
+#define ZCL_ATTRID_FILE_OFFSET 0x0001 // FileOffset of the OTA client
+#endif
+#ifndef ZCL_ATTRID_DOWNLOAD_FILE_VER
+#define ZCL_ATTRID_DOWNLOAD_FILE_VER 0x0002 // DownloadedFileVersion of the OTA client
+#endif
+
+#ifndef ZCL_CMD_OTA_IMAGE_BLOCK_RSP
+#define ZCL_CMD_OTA_IMAGE_BLOCK_RSP 0x05 // Image Block Response, server to client
+#endif
+
+/* ZCL frame control of an incoming frame, see zcl.h */
+#define LIGHT_OTA_ZCL_FRAME_TYPE_MASK 0x03
+#define LIGHT_OTA_ZCL_FRAME_TYPE_SPECIFIC 0x01
+#define LIGHT_OTA_ZCL_FRAME_MANUF 0x04
+#define LIGHT_OTA_ZCL_FRAME_SERVER_TO_CLIENT 0x08
+
+#if LIGHT_OTA_RESUME_ENABLE
+/* The whole download record of the SDK OTA client goes into the checkpoint, see ota.h */
+typedef char lightOta_resumeClientCheck_t[(sizeof(otaClientInfo) <= LIGHT_OTA_RESUME_CLIENT_MAX) ? 1 : -1];
+#endif
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Output of the unpacker, written page by page into the standby bank
+ */
+typedef struct
+{
+	u32 base;
+	u32 offset; // bytes produced so far
+	u32 size;	// expected image size
+	u16 fill;	// bytes waiting in the page buffer
+	u8 flag;	// real value of the start-up flag byte, kept out of flash
+	u8 page[LIGHT_OTA_PAGE_SIZE];
+} light_otaWriter_t;
+
+/**
+ *  @brief Packed data, read from flash through a small buffer
+ */
+typedef struct
+{
+	u32 addr; // next flash address to fetch, everything below it has been read
+	u32 end;
+	u16 len;
+	u16 pos;
+	u8 buf[64];
+} light_otaReader_t;
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+#if LIGHT_OTA_PACK_ENABLE
+static light_otaWriter_t lightOtaWriter;
+static light_otaReader_t lightOtaReader;
+static u8 lightOtaBuf[LIGHT_OTA_PAGE_SIZE];
+#endif
+
+static ev_timer_event_t *lightOtaPaceTimerEvt = NULL;
+static light_otaPaceStats_t lightOtaPaceStats;
+static u16 lightOtaPaceLoopCnt = 0;
+static u32 lightOtaPaceTxCnt = 0;
+static u32 lightOtaPaceRetryCnt = 0;
+static void *lightOtaPaceHeldInd = NULL; // Image Block Response held back during a fade
+static u32 lightOtaPaceHeldTick = 0;
+
+#if LIGHT_OTA_RESUME_ENABLE
+static light_otaResume_t lightOtaResume;
+static bool lightOtaResumePending = FALSE; // lightOtaResume holds a checkpoint validated at start-up
+#endif
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightOta_standbyAddr
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  flash address of the bank the OTA client downloads into
+ */
+static u32 lightOta_standbyAddr(void)
+{
+	return (mcuBootAddrGet() == FLASH_ADDR_OF_OTA_IMAGE) ? FLASH_ADDR_OF_APP_FW : FLASH_ADDR_OF_OTA_IMAGE;
+}
+
+#if LIGHT_OTA_PACK_ENABLE
+/*********************************************************************
+ * @fn      lightOta_read32
+ *
+ * @brief
+ *
+ * @param   addr - flash address
+ *
+ * @return  little endian u32 at that address
+ */
+static u32 lightOta_read32(u32 addr)
+{
+	u8 buf[4];
+
+	flash_read(addr, 4, buf);
+
+	return buf[0] | ((u32)buf[1] << 8) | ((u32)buf[2] << 16) | ((u32)buf[3] << 24);
+}
+#endif
+
+#if (LIGHT_OTA_PACK_ENABLE || LIGHT_OTA_RESUME_ENABLE)
+/*********************************************************************
+ * @fn      lightOta_crc
+ *
+ * @brief   Running crc of a flash region, same scheme as tools/tl_check_fw.py
+ *
+ * @param   addr - flash address of the region
+ * @param   len
+ * @param   flag - value used for the start-up flag byte, the region must
+ *                 start at an image base when it covers that byte
+ * @param   crc  - crc so far, 0xffffffff to start
+ *
+ * @return  crc
+ */
+static u32 lightOta_crc(u32 addr, u32 len, s16 flag, u32 crc)
+{
+	u8 buf[64];
+
+	for (u32 offset = 0; offset < len; offset += sizeof(buf))
+	{
+		u16 chunk = (len - offset > sizeof(buf)) ? sizeof(buf) : (len - offset);
+
+		flash_read(addr + offset, chunk, buf);
+		if ((flag >= 0) && (offset <= LIGHT_OTA_FW_FLAG_OFFSET) && (offset + chunk > LIGHT_OTA_FW_FLAG_OFFSET))
+		{
+			buf[LIGHT_OTA_FW_FLAG_OFFSET - offset] = (u8)flag;
+		}
+		crc = xcrc32(buf, chunk, crc);
+	}
+
+	return crc;
+}
+#endif
+
+#if LIGHT_OTA_PACK_ENABLE
+/*********************************************************************
+ * @fn      lightOta_dataMove
+ *
+ * @brief   Move the packed data to the end of the standby bank, last
+ *          sector first. The destination sector being erased never holds
+ *          data still to be copied as long as the move is at least one
+ *          sector long.
+ *
+ * @param   srcAddr
+ * @param   dstAddr - sector aligned, at least one sector above srcAddr
+ * @param   len
+ *
+ * @return  None
+ */
+static void lightOta_dataMove(u32 srcAddr, u32 dstAddr, u32 len)
+{
+	for (s32 sector = (len - 1) & ~(LIGHT_OTA_SECTOR_SIZE - 1); sector >= 0; sector -= LIGHT_OTA_SECTOR_SIZE)
+	{
+		flash_erase(dstAddr + sector);
+
+		for (u32 offset = sector; (offset < sector + LIGHT_OTA_SECTOR_SIZE) && (offset < len); offset += sizeof(lightOtaBuf))
+		{
+			u16 chunk = (len - offset > sizeof(lightOtaBuf)) ? sizeof(lightOtaBuf) : (len - offset);
+
+			flash_read(srcAddr + offset, chunk, lightOtaBuf);
+			flash_write(dstAddr + offset, chunk, lightOtaBuf);
+		}
+	}
+}
+
+/*********************************************************************
+ * @fn      lightOta_writerFlush
+ *
+ * @brief   Write the page buffer, erasing each sector on its first page.
+ *          The start-up flag byte stays erased, ota_mcuReboot() sets it
+ *          once the whole image has been checked.
+ *
+ * @param   None
+ *
+ * @return  FALSE if the sector to erase still holds packed data not read yet
+ */
+static bool lightOta_writerFlush(void)
+{
+	light_otaWriter_t *w = &lightOtaWriter;
+	u32 pageAddr = w->base + w->offset - w->fill;
+
+	if (!w->fill)
+	{
+		return TRUE;
+	}
+
+	if ((pageAddr % LIGHT_OTA_SECTOR_SIZE) == 0)
+	{
+		/* the image may be unpacked over its own packed data, never overtake the reader */
+		if ((lightOtaReader.addr < lightOtaReader.end) &&
+			(lightOtaReader.addr < pageAddr + LIGHT_OTA_SECTOR_SIZE) && (lightOtaReader.end > pageAddr))
+		{
+			return FALSE;
+		}
+		flash_erase(pageAddr);
+	}
+
+	if (pageAddr == w->base)
+	{
+		w->flag = w->page[LIGHT_OTA_FW_FLAG_OFFSET];
+		w->page[LIGHT_OTA_FW_FLAG_OFFSET] = 0xff;
+	}
+
+	flash_write(pageAddr, w->fill, w->page);
+	w->fill = 0;
+
+	return TRUE;
+}
+
+/*********************************************************************
+ * @fn      lightOta_writerPut
+ *
+ * @brief
+ *
+ * @param   pData - NULL to write 'len' times the byte 'value'
+ * @param   len
+ * @param   value
+ *
+ * @return  FALSE if the image would grow past its declared size
+ */
+static bool lightOta_writerPut(const u8 *pData, u16 len, u8 value)
+{
+	light_otaWriter_t *w = &lightOtaWriter;
+
+	if (w->offset + len > w->size)
+	{
+		return FALSE;
+	}
+
+	while (len)
+	{
+		u16 chunk = LIGHT_OTA_PAGE_SIZE - w->fill;
+
+		if (chunk > len)
+		{
+			chunk = len;
+		}
+
+		if (pData)
+		{
+			memcpy(&w->page[w->fill], pData, chunk);
+			pData += chunk;
+		}
+		else
+		{
+			memset(&w->page[w->fill], value, chunk);
+		}
+
+		w->fill += chunk;
+		w->offset += chunk;
+		len -= chunk;
+
+		if ((w->fill == LIGHT_OTA_PAGE_SIZE) && !lightOta_writerFlush())
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/*********************************************************************
+ * @fn      lightOta_writerRead
+ *
+ * @brief   Read back output already produced, from flash or the page buffer
+ *
+ * @param   offset - offset in the image
+ * @param   pBuf
+ * @param   len
+ *
+ * @return  None
+ */
+static void lightOta_writerRead(u32 offset, u8 *pBuf, u16 len)
+{
+	light_otaWriter_t *w = &lightOtaWriter;
+	u32 flushed = w->offset - w->fill;
+
+	if (offset < flushed)
+	{
+		u16 chunk = (flushed - offset > len) ? len : (flushed - offset);
+
+		flash_read(w->base + offset, chunk, pBuf);
+		if ((offset <= LIGHT_OTA_FW_FLAG_OFFSET) && (offset + chunk > LIGHT_OTA_FW_FLAG_OFFSET))
+		{
+			pBuf[LIGHT_OTA_FW_FLAG_OFFSET - offset] = w->flag;
+		}
+		offset += chunk;
+		pBuf += chunk;
+		len -= chunk;
+	}
+
+	memcpy(pBuf, &w->page[offset - flushed], len);
+}
+
+/*********************************************************************
+ * @fn      lightOta_readerGet
+ *
+ * @brief
+ *
+ * @param   pBuf - NULL to fetch a single byte into the return value
+ * @param   len
+ *
+ * @return  -1 past the end of the data, the byte or 0 otherwise
+ */
+static s16 lightOta_readerGet(u8 *pBuf, u16 len)
+{
+	light_otaReader_t *r = &lightOtaReader;
+	u8 byte = 0;
+
+	if (!pBuf)
+	{
+		pBuf = &byte;
+		len = 1;
+	}
+
+	while (len)
+	{
+		if (r->pos == r->len)
+		{
+			if (r->addr >= r->end)
+			{
+				return -1;
+			}
+			r->len = (r->end - r->addr > sizeof(r->buf)) ? sizeof(r->buf) : (r->end - r->addr);
+			r->pos = 0;
+			flash_read(r->addr, r->len, r->buf);
+			r->addr += r->len;
+		}
+
+		*pBuf++ = r->buf[r->pos++];
+		len--;
+	}
+
+	return byte;
+}
+
+/*********************************************************************
+ * @fn      lightOta_readerU16
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  little endian u16 from the data, -1 past its end
+ */
+static s32 lightOta_readerU16(void)
+{
+	u8 buf[2];
+
+	if (lightOta_readerGet(buf, 2) < 0)
+	{
+		return -1;
+	}
+
+	return BUILD_U16(buf[0], buf[1]);
+}
+#endif
+
+#if LIGHT_OTA_DELTA_ENABLE
+/*********************************************************************
+ * @fn      lightOta_deltaRun
+ *
+ * @brief   Rebuild the new image from the running one and the patch operations
+ *
+ * @param   pHdr
+ *
+ * @return  TRUE if every operation was valid
+ */
+static bool lightOta_deltaRun(const light_otaPackHdr_t *pHdr)
+{
+	u32 baseAddr = mcuBootAddrGet();
+	s32 op;
+
+	/* the patch only fits the exact image it was made from */
+	if ((lightOta_read32(baseAddr + LIGHT_OTA_FW_SIZE_OFFSET) != pHdr->baseSize) ||
+		(lightOta_read32(baseAddr + pHdr->baseSize - 4) != pHdr->baseCrc))
+	{
+		return FALSE;
+	}
+
+	while ((op = lightOta_readerGet(NULL, 0)) >= 0)
+	{
+		if (op == LIGHT_OTA_DELTA_OP_END)
+		{
+			return TRUE;
+		}
+
+		if (op == LIGHT_OTA_DELTA_OP_COPY)
+		{
+			u8 buf[4];
+			s32 len;
+
+			if (lightOta_readerGet(buf, 4) < 0 || (len = lightOta_readerU16()) < 0)
+			{
+				return FALSE;
+			}
+
+			u32 src = buf[0] | ((u32)buf[1] << 8) | ((u32)buf[2] << 16) | ((u32)buf[3] << 24);
+			if (src + len > pHdr->baseSize)
+			{
+				return FALSE;
+			}
+
+			while (len)
+			{
+				u16 chunk = (len > sizeof(lightOtaBuf)) ? sizeof(lightOtaBuf) : len;
+
+				flash_read(baseAddr + src, chunk, lightOtaBuf);
+				if (!lightOta_writerPut(lightOtaBuf, chunk, 0))
+				{
+					return FALSE;
+				}
+				src += chunk;
+				len -= chunk;
+			}
+		}
+		else if (op == LIGHT_OTA_DELTA_OP_LITERAL)
+		{
+			s32 len = lightOta_readerU16();
+
+			if (len < 0)
+			{
+				return FALSE;
+			}
+
+			while (len)
+			{
+				u16 chunk = (len > sizeof(lightOtaBuf)) ? sizeof(lightOtaBuf) : len;
+
+				if (lightOta_readerGet(lightOtaBuf, chunk) < 0 || !lightOta_writerPut(lightOtaBuf, chunk, 0))
+				{
+					return FALSE;
+				}
+				len -= chunk;
+			}
+		}
+		else if (op == LIGHT_OTA_DELTA_OP_FILL)
+		{
+			s32 len = lightOta_readerU16();
+			s16 value = lightOta_readerGet(NULL, 0);
+
+			if ((len < 0) || (value < 0) || !lightOta_writerPut(NULL, len, (u8)value))
+			{
+				return FALSE;
+			}
+		}
+		else
+		{
+			return FALSE;
+		}
+	}
+
+	return FALSE;
+}
+#endif
+
+#if LIGHT_OTA_LZ_ENABLE
+/*********************************************************************
+ * @fn      lightOta_lzRun
+ *
+ * @brief   Decompress the image. Matches are read back from the output
+ *          itself, so no window is kept in RAM.
+ *
+ * @param   pHdr
+ *
+ * @return  TRUE if the data was valid
+ */
+static bool lightOta_lzRun(const light_otaPackHdr_t *pHdr)
+{
+	while (lightOtaWriter.offset < pHdr->newSize)
+	{
+		s16 flags = lightOta_readerGet(NULL, 0);
+
+		if (flags < 0)
+		{
+			return FALSE;
+		}
+
+		for (u8 bit = 0; (bit < 8) && (lightOtaWriter.offset < pHdr->newSize); bit++)
+		{
+			if (flags & BIT(bit))
+			{
+				s32 token = lightOta_readerU16();
+				u16 dist = (token & (LIGHT_OTA_LZ_WINDOW - 1)) + 1;
+				u16 len = (token >> 12) + LIGHT_OTA_LZ_MIN_MATCH;
+
+				if ((token < 0) || (dist > lightOtaWriter.offset))
+				{
+					return FALSE;
+				}
+
+				if ((token >> 12) == LIGHT_OTA_LZ_LEN_EXT)
+				{
+					s16 ext = lightOta_readerGet(NULL, 0);
+
+					if (ext < 0)
+					{
+						return FALSE;
+					}
+					len += ext;
+				}
+
+				/* a match may overlap its own output, copy at most 'dist' bytes at a time */
+				while (len)
+				{
+					u16 chunk = (len > dist) ? dist : len;
+
+					if (chunk > sizeof(lightOtaBuf))
+					{
+						chunk = sizeof(lightOtaBuf);
+					}
+
+					lightOta_writerRead(lightOtaWriter.offset - dist, lightOtaBuf, chunk);
+					if (!lightOta_writerPut(lightOtaBuf, chunk, 0))
+					{
+						return FALSE;
+					}
+					len -= chunk;
+				}
+			}
+			else
+			{
+				s16 value = lightOta_readerGet(NULL, 0);
+
+				if ((value < 0) || !lightOta_writerPut(NULL, 1, (u8)value))
+				{
+					return FALSE;
+				}
+			}
+		}
+	}
+
+	return TRUE;
+}
+#endif
+
+#if LIGHT_OTA_PACK_ENABLE
+/*********************************************************************
+ * @fn      lightOta_unpack
+ *
+ * @brief   The standby bank holds a packed container. Its data is first
+ *          moved to the end of the bank, then the full image is unpacked
+ *          from the start of the bank and checked against the crc of the
+ *          firmware header scheme. A compressed image may be unpacked over
+ *          its own data, the writer never erases a sector still to be read.
+ *          Nothing here sets the start-up flag, a reset half way leaves the
+ *          running image in charge and the download simply starts over.
+ *
+ * @param   standbyAddr
+ * @param   pHdr - header read from the container
+ *
+ * @return  ZCL_STA_SUCCESS if the standby bank now holds the checked new image
+ */
+static status_t lightOta_unpack(u32 standbyAddr, const light_otaPackHdr_t *pHdr)
+{
+	u32 dataAddr = standbyAddr + LIGHT_OTA_FW_HDR_LEN + sizeof(light_otaPackHdr_t);
+	u32 dataAlloc = (pHdr->dataLen + LIGHT_OTA_SECTOR_SIZE - 1) & ~(LIGHT_OTA_SECTOR_SIZE - 1);
+	u32 movedAddr = standbyAddr + FLASH_OTA_IMAGE_MAX_SIZE - dataAlloc;
+	bool ok = FALSE;
+
+	if ((pHdr->version != LIGHT_OTA_PACK_VERSION) ||
+		(pHdr->newSize <= LIGHT_OTA_FW_HDR_LEN) || (pHdr->newSize > FLASH_OTA_IMAGE_MAX_SIZE) ||
+		(dataAlloc + LIGHT_OTA_SECTOR_SIZE > FLASH_OTA_IMAGE_MAX_SIZE) ||
+		(movedAddr < dataAddr + LIGHT_OTA_SECTOR_SIZE))
+	{
+		return ZCL_STA_INVALID_IMAGE;
+	}
+
+	if (lightOta_crc(dataAddr, pHdr->dataLen, -1, 0xffffffff) != pHdr->dataCrc)
+	{
+		return ZCL_STA_INVALID_IMAGE;
+	}
+
+	lightOta_dataMove(dataAddr, movedAddr, pHdr->dataLen);
+
+	memset((u8 *)&lightOtaReader, 0, sizeof(light_otaReader_t));
+	lightOtaReader.addr = movedAddr;
+	lightOtaReader.end = movedAddr + pHdr->dataLen;
+
+	memset((u8 *)&lightOtaWriter, 0, sizeof(light_otaWriter_t));
+	lightOtaWriter.base = standbyAddr;
+	lightOtaWriter.size = pHdr->newSize;
+
+#if LIGHT_OTA_DELTA_ENABLE
+	if (pHdr->magic == LIGHT_OTA_DELTA_MAGIC)
+	{
+		ok = lightOta_deltaRun(pHdr);
+	}
+#endif
+#if LIGHT_OTA_LZ_ENABLE
+	if (pHdr->magic == LIGHT_OTA_LZ_MAGIC)
+	{
+		ok = lightOta_lzRun(pHdr);
+	}
+#endif
+
+	if (!ok || !lightOta_writerFlush() || (lightOtaWriter.offset != pHdr->newSize))
+	{
+		return ZCL_STA_INVALID_IMAGE;
+	}
+
+	if ((lightOta_read32(standbyAddr + LIGHT_OTA_FW_SIZE_OFFSET) != pHdr->newSize) ||
+		(lightOta_read32(standbyAddr + pHdr->newSize - 4) != pHdr->newCrc) ||
+		((lightOta_crc(standbyAddr, pHdr->newSize - 4, lightOtaWriter.flag, 0xffffffff) != pHdr->newCrc)))
+	{
+		return ZCL_STA_INVALID_IMAGE;
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+#endif
+
+/*********************************************************************
+ * @fn      lightOta_imageFinalize
+ *
+ * @brief   Called once the OTA client has received and checked the whole
+ *          image, before ota_mcuReboot(). A full image is left as it is,
+ *          a delta or compressed container is unpacked first.
+ *
+ * @param   None
+ *
+ * @return  ZCL_STA_SUCCESS if the standby bank holds an image to boot
+ */
+status_t lightOta_imageFinalize(void)
+{
+	u32 standbyAddr = lightOta_standbyAddr();
+	light_otaPackHdr_t hdr;
+	status_t status = ZCL_STA_INVALID_IMAGE;
+
+	flash_read(standbyAddr + LIGHT_OTA_FW_HDR_LEN, sizeof(light_otaPackHdr_t), (u8 *)&hdr);
+
+	if ((hdr.magic != LIGHT_OTA_DELTA_MAGIC) && (hdr.magic != LIGHT_OTA_LZ_MAGIC))
+	{
+		/* plain image */
+		return ZCL_STA_SUCCESS;
+	}
+
+#if LIGHT_OTA_PACK_ENABLE
+	status = lightOta_unpack(standbyAddr, &hdr);
+#endif
+
+	if (status != ZCL_STA_SUCCESS)
+	{
+		/* never leave a half unpacked image behind */
+		flash_erase(standbyAddr);
+	}
+
+	return status;
+}
+
+#if LIGHT_OTA_RESUME_ENABLE
+/*********************************************************************
+ * @fn      lightOta_resumeAttrGet
+ *
+ * @brief
+ *
+ * @param   attrId - ZCL_ATTRID_FILE_OFFSET or ZCL_ATTRID_DOWNLOAD_FILE_VER
+ *
+ * @return  value of the u32 attribute of the OTA client
+ */
+static u32 lightOta_resumeAttrGet(u16 attrId)
+{
+	u16 len = 0;
+	u8 buf[4] = {0};
+
+	zcl_getAttrVal(SAMPLE_LIGHT_ENDPOINT, ZCL_CLUSTER_OTA, attrId, &len, buf);
+
+	return buf[0] | ((u32)buf[1] << 8) | ((u32)buf[2] << 16) | ((u32)buf[3] << 24);
+}
+
+/*********************************************************************
+ * @fn      lightOta_resumeFlashLen
+ *
+ * @brief
+ *
+ * @param   offset - file offset of the OTA client
+ *
+ * @return  bytes of the standby bank written up to that offset
+ */
+static u32 lightOta_resumeFlashLen(u32 offset)
+{
+	return (offset > LIGHT_OTA_FILE_DATA_OFFSET) ? (offset - LIGHT_OTA_FILE_DATA_OFFSET) : 0;
+}
+
+/*********************************************************************
+ * @fn      lightOta_resumeCheckpoint
+ *
+ * @brief   Takes a checkpoint each time the download has grown by
+ *          LIGHT_OTA_RESUME_GROUP bytes. Only the bytes written since the
+ *          previous checkpoint are read back. The record is written to NV
+ *          right away, it must match the client state it was taken from.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightOta_resumeCheckpoint(void)
+{
+	u32 offset = lightOta_resumeAttrGet(ZCL_ATTRID_FILE_OFFSET);
+	u32 flashLen = lightOta_resumeFlashLen(offset);
+
+	if (lightOtaResume.magic != LIGHT_OTA_RESUME_MAGIC)
+	{
+		lightOtaResume.magic = LIGHT_OTA_RESUME_MAGIC;
+		lightOtaResume.fileVer = lightOta_resumeAttrGet(ZCL_ATTRID_DOWNLOAD_FILE_VER);
+		lightOtaResume.flashLen = 0;
+		lightOtaResume.flashCrc = 0xffffffff;
+	}
+
+	if ((flashLen < lightOtaResume.flashLen + LIGHT_OTA_RESUME_GROUP) || (flashLen > FLASH_OTA_IMAGE_MAX_SIZE))
+	{
+		return;
+	}
+
+	lightOtaResume.flashCrc = lightOta_crc(lightOta_standbyAddr() + lightOtaResume.flashLen, flashLen - lightOtaResume.flashLen, -1, lightOtaResume.flashCrc);
+	lightOtaResume.flashLen = flashLen;
+	lightOtaResume.offset = offset;
+	lightOtaResume.clientLen = sizeof(otaClientInfo);
+	memcpy(lightOtaResume.client, (u8 *)&otaClientInfo, sizeof(otaClientInfo));
+
+	lightOta_resumeSave();
+}
+#endif
+
+/*********************************************************************
+ * @fn      lightOta_resumeInit
+ *
+ * @brief   Loads the checkpoint of an interrupted download and checks the
+ *          partial image in the standby bank against it. Called after ota_init().
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightOta_resumeInit(void)
+{
+#if LIGHT_OTA_RESUME_ENABLE && NV_ENABLE
+	light_otaResume_t *pRes = &lightOtaResume;
+
+	if ((nv_flashReadNew(1, NV_MODULE_APP, NV_ITEM_APP_OTA_RESUME, sizeof(light_otaResume_t), (u8 *)pRes) != NV_SUCC) ||
+		(pRes->magic != LIGHT_OTA_RESUME_MAGIC) || (pRes->clientLen != sizeof(otaClientInfo)))
+	{
+		/* nothing to resume, or taken by a firmware with another OTA client layout */
+		memset((u8 *)pRes, 0, sizeof(light_otaResume_t));
+		return;
+	}
+
+	if ((pRes->flashLen == 0) || (pRes->flashLen > FLASH_OTA_IMAGE_MAX_SIZE) ||
+		(lightOta_crc(lightOta_standbyAddr(), pRes->flashLen, -1, 0xffffffff) != pRes->flashCrc))
+	{
+		/* the partial image is gone or damaged, the next download starts over */
+		lightOta_resumeClear();
+		return;
+	}
+
+	lightOtaResumePending = TRUE;
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightOta_resumeStart
+ *
+ * @brief   Called when the OTA client starts a download. A download of the
+ *          checkpointed file version continues from the checkpoint, any
+ *          other one drops it. The client record is restored as a whole,
+ *          the running crc and the state of the OTA header and tag parsed
+ *          before the checkpoint come back with the file offset.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightOta_resumeStart(void)
+{
+#if LIGHT_OTA_RESUME_ENABLE
+	if (lightOtaResumePending && (lightOta_resumeAttrGet(ZCL_ATTRID_DOWNLOAD_FILE_VER) == lightOtaResume.fileVer))
+	{
+		memcpy((u8 *)&otaClientInfo, lightOtaResume.client, sizeof(otaClientInfo));
+		zcl_setAttrVal(SAMPLE_LIGHT_ENDPOINT, ZCL_CLUSTER_OTA, ZCL_ATTRID_FILE_OFFSET, (u8 *)&lightOtaResume.offset);
+	}
+	else
+	{
+		memset((u8 *)&lightOtaResume, 0, sizeof(light_otaResume_t));
+	}
+
+	lightOtaResumePending = FALSE;
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightOta_resumeClear
+ *
+ * @brief   Drops the checkpoint right away, the caller may reset the chip next
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightOta_resumeClear(void)
+{
+#if LIGHT_OTA_RESUME_ENABLE
+	memset((u8 *)&lightOtaResume, 0, sizeof(light_otaResume_t));
+	lightOtaResumePending = FALSE;
+
+	lightOta_resumeSave();
+	/* and whatever else is pending before that reset */
+	lightNv_flush();
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightOta_resumeSave
+ *
+ * @brief   Write the checkpoint to NV
+ *
+ * @param   None
+ *
+ * @return  nv_sts_t
+ */
+nv_sts_t lightOta_resumeSave(void)
+{
+#if LIGHT_OTA_RESUME_ENABLE && NV_ENABLE
+	return nv_flashWriteNew(1, NV_MODULE_APP, NV_ITEM_APP_OTA_RESUME, sizeof(light_otaResume_t), (u8 *)&lightOtaResume);
+#else
+	return NV_ENABLE_PROTECT_ERROR;
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightOta_queryInterval
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  seconds until the first OTA query, sooner with a download to resume
+ */
+u16 lightOta_queryInterval(void)
+{
+#if LIGHT_OTA_RESUME_ENABLE
+	if (lightOtaResumePending)
+	{
+		return LIGHT_OTA_RESUME_QUERY_INTERVAL;
+	}
+#endif
+
+	return OTA_PERIODIC_QUERY_INTERVAL;
+}
+
+/*********************************************************************
+ * @fn      lightOta_paceRelease
+ *
+ * @brief   Hands a held Image Block Response to the OTA client
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightOta_paceRelease(void)
+{
+	void *arg = lightOtaPaceHeldInd;
+
+	if (arg)
+	{
+		lightOtaPaceHeldInd = NULL;
+		zcl_rx_handler(arg);
+	}
+}
+
+/*********************************************************************
+ * @fn      lightOta_paceApply
+ *
+ * @brief   Publish the block period, to the OTA server through the
+ *          MinimumBlockPeriod of the client and as a light attribute
+ *
+ * @param   period - ms between two image block requests
+ *
+ * @return  None
+ */
+static void lightOta_paceApply(u16 period)
+{
+	zcl_setAttrVal(SAMPLE_LIGHT_ENDPOINT, ZCL_CLUSTER_OTA, ZCL_ATTRID_MIN_BLOCK_PERIOD, (u8 *)&period);
+
+#ifdef ZCL_LIGHT_EXT
+	zcl_lightExtAttr_t *pExt = zcl_lightExtAttrGet();
+
+	if (pExt->otaBlockPeriod != period)
+	{
+		pExt->otaBlockPeriod = period;
+		lightReport_attrChanged();
+	}
+#endif
+}
+
+/*********************************************************************
+ * @fn      lightOta_paceTimerCb
+ *
+ * @brief   Adapts the block period once per interval. A fade holds the
+ *          download, a slow main loop or a high MAC retry rate doubles
+ *          the adaptive period, a quiet interval takes one step off it.
+ *
+ * @param   arg - unused
+ *
+ * @return  0 to keep the timer running
+ */
+static s32 lightOta_paceTimerCb(void *arg)
+{
+	u32 tx = g_sysDiags.macTxUcast - lightOtaPaceTxCnt;
+	u32 retry = g_sysDiags.macTxUcastRetry - lightOtaPaceRetryCnt;
+
+	lightOtaPaceTxCnt = g_sysDiags.macTxUcast;
+	lightOtaPaceRetryCnt = g_sysDiags.macTxUcastRetry;
+
+	lightOtaPaceStats.lastLoopCnt = lightOtaPaceLoopCnt;
+	lightOtaPaceStats.lastTxCnt = (tx > 0xffff) ? 0xffff : tx;
+	lightOtaPaceStats.lastRetryCnt = (retry > 0xffff) ? 0xffff : retry;
+	lightOtaPaceLoopCnt = 0;
+
+	u16 period = lightOtaPaceStats.period;
+
+	if ((lightOtaPaceStats.lastLoopCnt < LIGHT_OTA_PACE_LOOP_MIN) || (retry * LIGHT_OTA_PACE_RETRY_DIV > tx))
+	{
+		lightOtaPaceStats.backoffs++;
+		period = (period < LIGHT_OTA_PACE_STEP_MS) ? LIGHT_OTA_PACE_STEP_MS : (period << 1);
+		if (period > LIGHT_OTA_PACE_MAX_MS)
+		{
+			period = LIGHT_OTA_PACE_MAX_MS;
+		}
+	}
+	else if (period > LIGHT_OTA_PACE_MIN_MS + LIGHT_OTA_PACE_STEP_MS)
+	{
+		period -= LIGHT_OTA_PACE_STEP_MS;
+	}
+	else
+	{
+		period = LIGHT_OTA_PACE_MIN_MS;
+	}
+	lightOtaPaceStats.period = period;
+
+	/* the adaptive period carries on underneath, the fade only holds the requests */
+	if (light_fadeActive())
+	{
+		lightOtaPaceStats.holds++;
+		if (period < LIGHT_OTA_PACE_HOLD_MS)
+		{
+			period = LIGHT_OTA_PACE_HOLD_MS;
+		}
+	}
+
+	lightOta_paceApply(period);
+
+#if LIGHT_OTA_RESUME_ENABLE
+	/* the checkpoint shares the download timer */
+	lightOta_resumeCheckpoint();
+#endif
+
+	return 0;
+}
+
+/*********************************************************************
+ * @fn      lightOta_paceStart
+ *
+ * @brief   Starts pacing, called when the OTA client starts a download
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightOta_paceStart(void)
+{
+	if (lightOtaPaceTimerEvt)
+	{
+		TL_ZB_TIMER_CANCEL(&lightOtaPaceTimerEvt);
+	}
+
+	memset((u8 *)&lightOtaPaceStats, 0, sizeof(light_otaPaceStats_t));
+	lightOtaPaceStats.period = LIGHT_OTA_PACE_MIN_MS;
+	lightOtaPaceLoopCnt = 0;
+	lightOtaPaceTxCnt = g_sysDiags.macTxUcast;
+	lightOtaPaceRetryCnt = g_sysDiags.macTxUcastRetry;
+
+	lightOta_paceApply(light_fadeActive() ? LIGHT_OTA_PACE_HOLD_MS : LIGHT_OTA_PACE_MIN_MS);
+
+	lightOtaPaceTimerEvt = TL_ZB_TIMER_SCHEDULE(lightOta_paceTimerCb, NULL, LIGHT_OTA_PACE_INTERVAL_MS);
+}
+
+/*********************************************************************
+ * @fn      lightOta_paceStop
+ *
+ * @brief   Stops pacing and gives the server its own pace back,
+ *          called when the download completes or fails
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightOta_paceStop(void)
+{
+	if (lightOtaPaceTimerEvt)
+	{
+		TL_ZB_TIMER_CANCEL(&lightOtaPaceTimerEvt);
+	}
+
+	lightOta_paceRelease();
+	lightOta_paceApply(LIGHT_OTA_PACE_MIN_MS);
+}
+
+/*********************************************************************
+ * @fn      lightOta_paceLoop
+ *
+ * @brief   Counts main loop passes, a lamp busy with its own work runs
+ *          the loop less often. Called from app_task.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightOta_paceLoop(void)
+{
+	if (lightOtaPaceTimerEvt && (lightOtaPaceLoopCnt < 0xffff))
+	{
+		lightOtaPaceLoopCnt++;
+	}
+
+	if (lightOtaPaceHeldInd && (!light_fadeActive() || clock_time_exceed(lightOtaPaceHeldTick, LIGHT_OTA_PACE_HOLD_MS * 1000)))
+	{
+		lightOta_paceRelease();
+	}
+}
+
+/*********************************************************************
+ * @fn      lightOta_rxHandler
+ *
+ * @brief   Data handler of the light endpoint, in front of zcl_rx_handler().
+ *          While a download is paced and a fade runs, one Image Block Response
+ *          is held back. The OTA client only requests the next block once it
+ *          has processed the response, so holding it holds the download.
+ *
+ * @param   arg - apsdeDataInd_t, owned by the handler until zcl_rx_handler() frees it
+ *
+ * @return  None
+ */
+void lightOta_rxHandler(void *arg)
+{
+	apsdeDataInd_t *pInd = (apsdeDataInd_t *)arg;
+
+	if (lightOtaPaceTimerEvt && !lightOtaPaceHeldInd && (pInd->indInfo.cluster_id == ZCL_CLUSTER_OTA) && (pInd->asduLen >= 3))
+	{
+		u8 frameCtrl = pInd->asdu[0];
+		u8 cmdIdx = (frameCtrl & LIGHT_OTA_ZCL_FRAME_MANUF) ? 4 : 2;
+
+		if (((frameCtrl & LIGHT_OTA_ZCL_FRAME_TYPE_MASK) == LIGHT_OTA_ZCL_FRAME_TYPE_SPECIFIC) &&
+			(frameCtrl & LIGHT_OTA_ZCL_FRAME_SERVER_TO_CLIENT) && (cmdIdx < pInd->asduLen) &&
+			(pInd->asdu[cmdIdx] == ZCL_CMD_OTA_IMAGE_BLOCK_RSP) && light_fadeActive())
+		{
+			/* released by lightOta_paceLoop() when the fade ends, at the latest after
+			   LIGHT_OTA_PACE_HOLD_MS so the client does not time the request out */
+			lightOtaPaceHeldInd = arg;
+			lightOtaPaceHeldTick = clock_time();
+			return;
+		}
+	}
+
+	zcl_rx_handler(arg);
+}
+
+/*********************************************************************
+ * @fn      lightOta_paceStatsGet
+ *
+ * @brief   Pacing statistics of the current or last download
+ *
+ * @param   None
+ *
+ * @return  light_otaPaceStats_t
+ */
+light_otaPaceStats_t *lightOta_paceStatsGet(void)
+{
+	return &lightOtaPaceStats;
+}
+
+#endif /* ZCL_OTA */
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
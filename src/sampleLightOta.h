@@ -0,0 +1,159 @@
+/********************************************************************************************************
+ * @file    sampleLightOta.h
+ *
+ * @brief   This is the header file for sampleLightOta
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_OTA_H_
+#define _SAMPLE_LIGHT_OTA_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+/* Same layout as the firmware header patched by tools/tl_check_fw.py */
+#define LIGHT_OTA_FW_MARKER_OFFSET 0x06 // u16 0x025d
+#define LIGHT_OTA_FW_MARKER 0x025d
+#define LIGHT_OTA_FW_FLAG_OFFSET 0x08 // start-up flag, only set by ota_mcuReboot()
+#define LIGHT_OTA_FW_SIZE_OFFSET 0x18 // u32 image size, crc included
+#define LIGHT_OTA_FW_HDR_LEN 0x20
+
+#define LIGHT_OTA_SECTOR_SIZE 0x1000
+#define LIGHT_OTA_PAGE_SIZE 256
+
+/**
+ *  @brief Packed images, made by tools/make_ota.py --base (delta) or --compress (LZ).
+ *         The container is a regular upgrade image sub-element to the OTA client: the
+ *         firmware header of the new image with its own size, light_otaPackHdr_t at
+ *         LIGHT_OTA_FW_HDR_LEN, the packed data and a crc trailer. It lands in the
+ *         standby bank like a full image and is unpacked in place once the download completes.
+ */
+#define LIGHT_OTA_PACK_ENABLE (LIGHT_OTA_DELTA_ENABLE || LIGHT_OTA_LZ_ENABLE)
+
+#define LIGHT_OTA_DELTA_MAGIC 0x544c444c // "LDLT"
+#define LIGHT_OTA_LZ_MAGIC 0x535a4c4c	 // "LLZS"
+#define LIGHT_OTA_PACK_VERSION 1
+
+/* Delta data, a list of operations against the running image, see tools/ota_delta.py */
+#define LIGHT_OTA_DELTA_OP_END 0x00
+#define LIGHT_OTA_DELTA_OP_COPY 0x01	// u32 offset in the running image, u16 length
+#define LIGHT_OTA_DELTA_OP_LITERAL 0x02 // u16 length, bytes
+#define LIGHT_OTA_DELTA_OP_FILL 0x03	// u16 length, u8 value
+
+/* LZ data, see tools/ota_lz.py. A flag byte, LSB first, announces the next
+ * eight items: 0 a literal byte, 1 a u16 match of (length - 3) << 12 | (distance - 1).
+ * A length field of 15 is followed by one more byte added to the length.
+ */
+#define LIGHT_OTA_LZ_WINDOW 4096
+#define LIGHT_OTA_LZ_MIN_MATCH 3
+#define LIGHT_OTA_LZ_LEN_EXT 15
+
+/**
+ *  @brief Download pacing. While the OTA client downloads, the MinimumBlockPeriod
+ *         it advertises to the server follows the load of the lamp: it grows
+ *         when the main loop is slow or the MAC retries a lot, shrinks again step
+ *         by step while the lamp is quiet. During a fade the Image Block Responses
+ *         are held back by lightOta_rxHandler(), which holds the client's next request.
+ */
+#define LIGHT_OTA_PACE_INTERVAL_MS 500
+#define LIGHT_OTA_PACE_MIN_MS 0		// no delay of our own, the server's pace
+#define LIGHT_OTA_PACE_STEP_MS 50	// first back-off and recovery step
+#define LIGHT_OTA_PACE_MAX_MS 2000
+#define LIGHT_OTA_PACE_HOLD_MS 1000 // advertised while a fade runs, and the longest a block response is held
+#define LIGHT_OTA_PACE_LOOP_MIN 100 // main loop passes per interval below which the lamp counts as busy
+#define LIGHT_OTA_PACE_RETRY_DIV 8	// back off above one MAC retry per this many unicasts
+
+/**
+ *  @brief Resumable download. Every LIGHT_OTA_RESUME_GROUP bytes the download
+ *         record of the OTA client, and a crc of what it wrote to the standby
+ *         bank, are stored in NV_ITEM_APP_OTA_RESUME. After a reboot the partial
+ *         image is checked against that crc, the next query goes out early and a
+ *         download of the same file version continues from the checkpoint.
+ */
+#define LIGHT_OTA_RESUME_MAGIC 0x524f544c // "LTOR"
+#define LIGHT_OTA_RESUME_GROUP 0x1000
+#define LIGHT_OTA_RESUME_QUERY_INTERVAL 10	 // s, first query after a reboot with a checkpoint
+#define LIGHT_OTA_RESUME_CLIENT_MAX 64	 // room for otaClientInfo
+#define LIGHT_OTA_FILE_DATA_OFFSET (56 + 6) // OTA header and tag of tools/make_ota.py files
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Statistics of the download pacing
+ */
+typedef struct
+{
+	u16 period;		  // adaptive block period, ms
+	u16 backoffs;	  // intervals with a busy main loop or too many retries
+	u16 holds;		  // intervals held for a fade
+	u16 lastLoopCnt;  // main loop passes in the last interval
+	u16 lastRetryCnt; // MAC retries in the last interval
+	u16 lastTxCnt;	  // MAC unicasts in the last interval
+} light_otaPaceStats_t;
+
+/**
+ *  @brief Download checkpoint, stored in NV_ITEM_APP_OTA_RESUME
+ */
+typedef struct
+{
+	u32 magic;
+	u32 fileVer;  // DownloadedFileVersion of the OTA client
+	u32 offset;	  // FileOffset of the OTA client, the next block
+	u32 flashLen; // bytes of the standby bank covered by flashCrc
+	u32 flashCrc;
+	u16 clientLen;							// sizeof(otaClientInfo) when the checkpoint was taken
+	u8 client[LIGHT_OTA_RESUME_CLIENT_MAX]; // otaClientInfo at that offset
+} light_otaResume_t;
+
+/**
+ *  @brief Header of a packed image, follows the firmware header of the container
+ */
+typedef struct
+{
+	u32 magic;
+	u8 version;
+	u8 reserved[3];
+	u32 baseSize; // delta only, size and crc trailer of the running image the patch applies to
+	u32 baseCrc;
+	u32 newSize; // size and crc trailer of the unpacked image
+	u32 newCrc;
+	u32 dataLen; // bytes of packed data following this header
+	u32 dataCrc;
+} light_otaPackHdr_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+status_t lightOta_imageFinalize(void);
+
+void lightOta_paceStart(void);
+void lightOta_paceStop(void);
+void lightOta_paceLoop(void);
+void lightOta_rxHandler(void *arg);
+light_otaPaceStats_t *lightOta_paceStatsGet(void);
+
+void lightOta_resumeInit(void);
+void lightOta_resumeStart(void);
+void lightOta_resumeClear(void);
+nv_sts_t lightOta_resumeSave(void);
+u16 lightOta_queryInterval(void);
+
+#endif /* _SAMPLE_LIGHT_OTA_H_ */
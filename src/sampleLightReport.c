@@ -0,0 +1,392 @@
+/********************************************************************************************************
+ * @file    sampleLightReport.c
+ *
+ * @brief   This is the source file for sampleLightReport
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightReport.h"
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+static ev_timer_event_t *lightReportTimerEvt = NULL;
+
+/* Set by the deadline timer or by an attribute change, the table is only scanned then */
+static bool lightReportDue = FALSE;
+static bool lightReportChanged = FALSE;
+
+/* clock_time() wraps after 268 s, so the scheduler keeps its own ms clock.
+ * lightReportTick is the system tick it was last advanced at, the timer is
+ * never armed for more than LIGHT_REPORT_WAKE_MAX_MS so the delta stays valid. */
+static u32 lightReportTick = 0;
+static u32 lightReportNowMs = 0;
+
+/* Start of the second not yet taken off the minIntCnt/maxIntCnt counters */
+static u32 lightReportSecondMs = 0;
+
+/* Transition coalescing: time of the last report per entry, and the entries
+ * whose final value still has to go out after the transition ended */
+static bool lightReportTransition = FALSE;
+static u32 lightReportSentMs[ZCL_REPORTING_TABLE_NUM] = {0};
+static u32 lightReportFinal = 0;
+
+/* Entries past their reportable change but held back, their deadline is armed already */
+static u32 lightReportHeld = 0;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightReport_timerCb
+ *
+ * @brief
+ *
+ * @param   arg
+ *
+ * @return  -1: one shot, the next deadline is scheduled by the scan
+ */
+static s32 lightReport_timerCb(void *arg)
+{
+	lightReportDue = TRUE;
+
+	lightReportTimerEvt = NULL;
+	return -1;
+}
+
+/*********************************************************************
+ * @fn      lightReport_timerStop
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightReport_timerStop(void)
+{
+	if (lightReportTimerEvt)
+	{
+		TL_ZB_TIMER_CANCEL(&lightReportTimerEvt);
+	}
+}
+
+/*********************************************************************
+ * @fn      lightReport_clockAdvance
+ *
+ * @brief   Move the ms clock on by the system ticks passed, the part of a
+ *          ms left over stays in lightReportTick
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightReport_clockAdvance(void)
+{
+	u32 ms = (clock_time() - lightReportTick) / (CLOCK_16M_SYS_TIMER_CLK_1US * 1000);
+
+	lightReportTick += ms * CLOCK_16M_SYS_TIMER_CLK_1US * 1000;
+	lightReportNowMs += ms;
+}
+
+/*********************************************************************
+ * @fn      lightReport_elapsed
+ *
+ * @brief   Whole seconds passed since the counters were last advanced
+ *
+ * @param   None
+ *
+ * @return  seconds
+ */
+static u16 lightReport_elapsed(void)
+{
+	u16 seconds = 0;
+
+	while (lightReportNowMs - lightReportSecondMs >= 1000)
+	{
+		lightReportSecondMs += 1000;
+		seconds++;
+	}
+
+	return seconds;
+}
+
+/*********************************************************************
+ * @fn      lightReport_changed
+ *
+ * @brief   Whether the attribute moved past the reportable change since the last report
+ *
+ * @param   pEntry
+ * @param   pAttr
+ *
+ * @return  TRUE if a report is wanted once the min interval allows it
+ */
+static bool lightReport_changed(reportCfgInfo_t *pEntry, zclAttrInfo_t *pAttr)
+{
+	if (zcl_analogDataType(pEntry->dataType))
+	{
+		return reportableChangeValueChk(pEntry->dataType, pAttr->data, pEntry->prevData, pEntry->reportableChange);
+	}
+
+	return memcmp(pEntry->prevData, pAttr->data, zcl_getAttrSize(pEntry->dataType, pAttr->data)) != 0;
+}
+
+/*********************************************************************
+ * @fn      lightReport_send
+ *
+ * @brief   Report one entry and restart both of its intervals
+ *
+ * @param   idx    - index in the reporting table
+ * @param   pEntry
+ * @param   pAttr
+ *
+ * @return  None
+ */
+static void lightReport_send(u8 idx, reportCfgInfo_t *pEntry, zclAttrInfo_t *pAttr)
+{
+	u16 len = zcl_getAttrSize(pEntry->dataType, pAttr->data);
+
+	reportAttr(pEntry);
+
+	if (len > sizeof(pEntry->prevData))
+	{
+		len = sizeof(pEntry->prevData);
+	}
+	memcpy(pEntry->prevData, pAttr->data, len);
+
+	pEntry->minIntCnt = pEntry->minInterval;
+	pEntry->maxIntCnt = pEntry->maxInterval;
+
+	lightReportSentMs[idx] = lightReportNowMs;
+	lightReportFinal &= ~BIT(idx);
+}
+
+/*********************************************************************
+ * @fn      lightReport_scan
+ *
+ * @brief   Advance the interval counters, report the entries that are due
+ *
+ * @param   None
+ *
+ * @return  ms until the earliest next deadline, LIGHT_REPORT_NO_DEADLINE if none
+ */
+static u32 lightReport_scan(void)
+{
+	u16 elapsed = lightReport_elapsed();
+	/* the counters are relative to the start of the current second, not to now */
+	u32 passedMs = lightReportNowMs - lightReportSecondMs;
+	u32 next = LIGHT_REPORT_NO_DEADLINE;
+
+	for (u8 i = 0; i < ZCL_REPORTING_TABLE_NUM; i++)
+	{
+		reportCfgInfo_t *pEntry = &reportingTab.reportCfgInfo[i];
+
+		if (!pEntry->used || (pEntry->maxInterval == 0xFFFF))
+		{
+			continue;
+		}
+
+		zclAttrInfo_t *pAttr = zcl_findAttribute(pEntry->endPoint, pEntry->clusterID, pEntry->attrID);
+		if (!pAttr)
+		{
+			continue;
+		}
+
+		pEntry->minIntCnt = (pEntry->minIntCnt > elapsed) ? (pEntry->minIntCnt - elapsed) : 0;
+		pEntry->maxIntCnt = (pEntry->maxIntCnt > elapsed) ? (pEntry->maxIntCnt - elapsed) : 0;
+
+		bool changed = (lightReportFinal & BIT(i)) || lightReport_changed(pEntry, pAttr);
+
+		/* mid-transition steps are coalesced for the rest of the hold time */
+		u32 sinceSentMs = lightReportNowMs - lightReportSentMs[i];
+		u32 holdMs = (lightReportTransition && (sinceSentMs < LIGHT_REPORT_TRANSITION_INTERVAL_MS)) ? (LIGHT_REPORT_TRANSITION_INTERVAL_MS - sinceSentMs) : 0;
+
+		if ((changed && !holdMs && (pEntry->minIntCnt == 0)) || (pEntry->maxInterval && (pEntry->maxIntCnt == 0)))
+		{
+			lightReport_send(i, pEntry, pAttr);
+			changed = FALSE;
+		}
+
+		/* a change held back by the min interval or the hold is due when both run out */
+		if (!changed)
+		{
+			lightReportHeld &= ~BIT(i);
+		}
+		else
+		{
+			lightReportHeld |= BIT(i);
+
+			u32 dueMs = pEntry->minIntCnt ? ((u32)pEntry->minIntCnt * 1000 - passedMs) : 0;
+
+			next = min2(next, max2(dueMs, holdMs));
+		}
+		if (pEntry->maxInterval)
+		{
+			next = min2(next, (u32)pEntry->maxIntCnt * 1000 - passedMs);
+		}
+	}
+
+	return next;
+}
+
+/*********************************************************************
+ * @fn      lightReport_finalMark
+ *
+ * @brief   A transition just ended. Every entry that differs from its last
+ *          report is sent once more, even below the reportable change, so
+ *          the coordinator always ends up with the value the light settled on.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightReport_finalMark(void)
+{
+	for (u8 i = 0; i < ZCL_REPORTING_TABLE_NUM; i++)
+	{
+		reportCfgInfo_t *pEntry = &reportingTab.reportCfgInfo[i];
+
+		if (!pEntry->used)
+		{
+			continue;
+		}
+
+		zclAttrInfo_t *pAttr = zcl_findAttribute(pEntry->endPoint, pEntry->clusterID, pEntry->attrID);
+		if (pAttr && memcmp(pEntry->prevData, pAttr->data, zcl_getAttrSize(pEntry->dataType, pAttr->data)))
+		{
+			lightReportFinal |= BIT(i);
+		}
+	}
+}
+
+/*********************************************************************
+ * @fn      lightReport_attrChanged
+ *
+ * @brief   Called whenever a light attribute changes, up to every fade
+ *          step. The scheduler only wakes early when an entry moves past
+ *          its reportable change, a change it already holds back is due
+ *          at the deadline armed for it.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightReport_attrChanged(void)
+{
+	if (lightReportChanged)
+	{
+		return;
+	}
+
+	for (u8 i = 0; i < ZCL_REPORTING_TABLE_NUM; i++)
+	{
+		reportCfgInfo_t *pEntry = &reportingTab.reportCfgInfo[i];
+
+		if (!pEntry->used || (pEntry->maxInterval == 0xFFFF) || (lightReportHeld & BIT(i)))
+		{
+			continue;
+		}
+
+		zclAttrInfo_t *pAttr = zcl_findAttribute(pEntry->endPoint, pEntry->clusterID, pEntry->attrID);
+		if (pAttr && lightReport_changed(pEntry, pAttr))
+		{
+			lightReportChanged = TRUE;
+			return;
+		}
+	}
+}
+
+/*********************************************************************
+ * @fn      lightReport_cfgChanged
+ *
+ * @brief   Rescan the table at once, called when the reporting configuration changes
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightReport_cfgChanged(void)
+{
+	lightReportChanged = TRUE;
+}
+
+/*********************************************************************
+ * @fn      lightReport_process
+ *
+ * @brief   Deadline driven reporting. Instead of checking every entry once
+ *          a second, the table is scanned only when the earliest min/max
+ *          deadline expires or an attribute changes, and a one shot timer
+ *          is armed for the next deadline. Called from the idle loop.
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightReport_process(void)
+{
+	if (!zb_isDeviceJoinedNwk() || !zcl_reportingEntryActiveNumGet())
+	{
+		lightReport_timerStop();
+		lightReportTick = clock_time();
+		lightReportSecondMs = lightReportNowMs;
+		/* scan once as soon as reporting becomes active */
+		lightReportDue = TRUE;
+		lightReportTransition = FALSE;
+		lightReportFinal = 0;
+		lightReportHeld = 0;
+		return;
+	}
+
+	lightReport_clockAdvance();
+
+	bool transition = light_transitionActive();
+	if (lightReportTransition && !transition)
+	{
+		lightReport_finalMark();
+		lightReportChanged = TRUE;
+	}
+	lightReportTransition = transition;
+
+	if (!lightReportDue && !lightReportChanged)
+	{
+		return;
+	}
+
+	lightReportDue = FALSE;
+	lightReportChanged = FALSE;
+
+	u32 next = lightReport_scan();
+
+	/* wake at least every LIGHT_REPORT_WAKE_MAX_MS to keep the ms clock in step */
+	lightReport_timerStop();
+	lightReportTimerEvt = TL_ZB_TIMER_SCHEDULE(lightReport_timerCb, NULL, min2(next, LIGHT_REPORT_WAKE_MAX_MS) + 1);
+}
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
@@ -0,0 +1,42 @@
+/********************************************************************************************************
+ * @file    sampleLightReport.h
+ *
+ * @brief   This is the header file for sampleLightReport
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_REPORT_H_
+#define _SAMPLE_LIGHT_REPORT_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+#define LIGHT_REPORT_NO_DEADLINE 0xFFFFFFFF
+
+/* Longest the deadline timer is armed for, well below the 268 s clock_time() wrap */
+#define LIGHT_REPORT_WAKE_MAX_MS (60 * 1000)
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void lightReport_attrChanged(void);
+void lightReport_cfgChanged(void);
+void lightReport_process(void);
+
+#endif /* _SAMPLE_LIGHT_REPORT_H_ */
@@ -0,0 +1,375 @@
+/********************************************************************************************************
+ * @file    sampleLightStream.c
+ *
+ * @brief   This is the source file for sampleLightStream
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightStream.h"
+
+/**********************************************************************
+ * LOCAL CONSTANTS
+ */
+#define LIGHT_STREAM_TICKS_PER_MS (CLOCK_16M_SYS_TIMER_CLK_1US * 1000)
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+	u32 due; // local play time in ms
+	u8 v[3]; // R G B, or mireds low, mireds high, level
+} light_streamSample_t;
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+static light_streamSample_t lightStreamBuf[LIGHT_STREAM_BUF_SIZE];
+static u8 lightStreamHead = 0; // oldest sample, the one being played from
+static u8 lightStreamCnt = 0;
+
+static u8 lightStreamFlags = 0;
+
+/* Local millisecond clock, advanced from the system tick on every use so it never wraps in practice */
+static u32 lightStreamNowMs = 0;
+static u32 lightStreamTick = 0;
+
+/* Sender timestamps are u16 ms, unwrapped against the previous one */
+static u16 lightStreamLastTs = 0;
+static u32 lightStreamSenderMs = 0;
+/* Local play time = sender time + offset */
+static u32 lightStreamOffset = 0;
+static u32 lightStreamLastRxMs = 0;
+
+static light_streamStats_t lightStreamStats = {0};
+
+static ev_timer_event_t *lightStreamTimerEvt = NULL;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightStream_nowMs
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  local time in ms
+ */
+static u32 lightStream_nowMs(void)
+{
+	u32 ms = (clock_time() - lightStreamTick) / LIGHT_STREAM_TICKS_PER_MS;
+
+	lightStreamTick += ms * LIGHT_STREAM_TICKS_PER_MS;
+	lightStreamNowMs += ms;
+
+	return lightStreamNowMs;
+}
+
+/*********************************************************************
+ * @fn      lightStream_at
+ *
+ * @brief
+ *
+ * @param   idx - position counted from the oldest sample
+ *
+ * @return  sample
+ */
+static light_streamSample_t *lightStream_at(u8 idx)
+{
+	return &lightStreamBuf[(lightStreamHead + idx) & (LIGHT_STREAM_BUF_SIZE - 1)];
+}
+
+/*********************************************************************
+ * @fn      lightStream_render
+ *
+ * @brief   Drive the PWM straight from a sample, the ZCL attributes are
+ *          left alone so streaming neither reports nor wears the flash
+ *
+ * @param   v - sample values
+ *
+ * @return  None
+ */
+static void lightStream_render(u8 *v)
+{
+	if (lightStreamFlags & LIGHT_STREAM_FLAG_CCT)
+	{
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+		zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+		u16 mireds = BUILD_U16(v[0], v[1]);
+
+		if (mireds < pColor->colorTempPhysicalMinMireds)
+		{
+			mireds = pColor->colorTempPhysicalMinMireds;
+		}
+		else if (mireds > pColor->colorTempPhysicalMaxMireds)
+		{
+			mireds = pColor->colorTempPhysicalMaxMireds;
+		}
+		hwLight_colorUpdate_colorTemperature(mireds, v[2]);
+#endif
+	}
+	else
+	{
+		hwLight_colorUpdate_RGB(v[0], v[1], v[2]);
+	}
+}
+
+/*********************************************************************
+ * @fn      lightStream_timerCb
+ *
+ * @brief   Render tick. Plays the buffer LIGHT_STREAM_DELAY_MS behind the
+ *          sender, interpolating between the two samples around now.
+ *
+ * @param   arg
+ *
+ * @return  0: timer continue on; -1: timer will be canceled
+ */
+static s32 lightStream_timerCb(void *arg)
+{
+	u32 now = lightStream_nowMs();
+
+	if ((now - lightStreamLastRxMs) > LIGHT_STREAM_TIMEOUT_MS)
+	{
+		/* back to the state held in the attributes */
+		lightStreamTimerEvt = NULL;
+		lightStreamCnt = 0;
+		light_fresh();
+		return -1;
+	}
+
+	/* drop samples that are fully played */
+	while ((lightStreamCnt >= 2) && ((s32)(now - lightStream_at(1)->due) >= 0))
+	{
+		lightStreamHead = (lightStreamHead + 1) & (LIGHT_STREAM_BUF_SIZE - 1);
+		lightStreamCnt--;
+	}
+	lightStreamStats.depth = lightStreamCnt;
+
+	light_streamSample_t *pA = lightStream_at(0);
+
+	if ((lightStreamCnt == 0) || ((s32)(now - pA->due) < 0))
+	{
+		/* still inside the playout delay */
+		return 0;
+	}
+
+	if (lightStreamCnt == 1)
+	{
+		lightStreamStats.underruns++;
+		lightStream_render(pA->v);
+		return 0;
+	}
+
+	light_streamSample_t *pB = lightStream_at(1);
+	u32 span = pB->due - pA->due;
+	u32 pos = now - pA->due;
+	u8 v[3];
+
+	if (lightStreamFlags & LIGHT_STREAM_FLAG_CCT)
+	{
+		s32 from = BUILD_U16(pA->v[0], pA->v[1]);
+		s32 to = BUILD_U16(pB->v[0], pB->v[1]);
+		u16 mireds = (u16)(from + (to - from) * (s32)pos / (s32)span);
+
+		v[0] = LO_UINT16(mireds);
+		v[1] = HI_UINT16(mireds);
+		v[2] = (u8)(pA->v[2] + ((s32)pB->v[2] - pA->v[2]) * (s32)pos / (s32)span);
+	}
+	else
+	{
+		for (u8 i = 0; i < 3; i++)
+		{
+			v[i] = (u8)(pA->v[i] + ((s32)pB->v[i] - pA->v[i]) * (s32)pos / (s32)span);
+		}
+	}
+
+	lightStream_render(v);
+	return 0;
+}
+
+/*********************************************************************
+ * @fn      lightStream_start
+ *
+ * @brief   First frame of a stream, anchor the sender clock to the local one
+ *
+ * @param   flags
+ * @param   ts    - timestamp of the first sample
+ *
+ * @return  None
+ */
+static void lightStream_start(u8 flags, u16 ts)
+{
+	lightStream_stop();
+	light_transitionStop();
+
+	lightStreamFlags = flags;
+	lightStreamHead = 0;
+	lightStreamCnt = 0;
+
+	lightStreamTick = clock_time();
+	lightStreamNowMs = 0;
+
+	lightStreamLastTs = ts;
+	lightStreamSenderMs = 0;
+	lightStreamOffset = LIGHT_STREAM_DELAY_MS;
+	lightStreamStats.delayMs = LIGHT_STREAM_DELAY_MS;
+
+	lightStreamTimerEvt = TL_ZB_TIMER_SCHEDULE(lightStream_timerCb, NULL, LIGHT_STREAM_INTERVAL);
+}
+
+/*********************************************************************
+ * @fn      lightStream_put
+ *
+ * @brief   Queue the samples of one stream frame. The first frame starts
+ *          the stream, samples that arrive after their play time push the
+ *          playout delay back by their lateness.
+ *
+ * @param   flags    - LIGHT_STREAM_FLAG_xxx
+ * @param   count    - number of samples
+ * @param   pSamples - LIGHT_STREAM_SAMPLE_LEN bytes each
+ *
+ * @return  None
+ */
+void lightStream_put(u8 flags, u8 count, u8 *pSamples)
+{
+	zcl_onOffAttr_t *pOnOff = zcl_onoffAttrGet();
+
+	if (!count || !pOnOff->onOff)
+	{
+		return;
+	}
+
+	if (!lightStreamTimerEvt || (flags != lightStreamFlags))
+	{
+		lightStream_start(flags, BUILD_U16(pSamples[0], pSamples[1]));
+	}
+
+	u32 now = lightStream_nowMs();
+	lightStreamLastRxMs = now;
+
+	for (u8 i = 0; i < count; i++, pSamples += LIGHT_STREAM_SAMPLE_LEN)
+	{
+		s16 delta = (s16)(BUILD_U16(pSamples[0], pSamples[1]) - lightStreamLastTs);
+
+		if ((lightStreamCnt > 0) && (delta <= 0))
+		{
+			lightStreamStats.stale++;
+			continue;
+		}
+		lightStreamLastTs += delta;
+		lightStreamSenderMs += delta;
+
+		u32 due = lightStreamSenderMs + lightStreamOffset;
+		if ((s32)(now - due) > 0)
+		{
+			lightStreamStats.late++;
+			lightStreamOffset += min2(now - due, LIGHT_STREAM_DELAY_MAX_MS - lightStreamOffset);
+			due = now;
+		}
+		else if ((lightStreamOffset > LIGHT_STREAM_DELAY_MS) && ((s32)(due - now) > LIGHT_STREAM_DELAY_MS))
+		{
+			/* the jitter that grew the delay is gone, give it back 1 ms per sample,
+			 * which keeps the due times in order since timestamps step by 1 ms or more */
+			lightStreamOffset--;
+			due--;
+		}
+		lightStreamStats.delayMs = lightStreamOffset;
+
+		if (lightStreamCnt == LIGHT_STREAM_BUF_SIZE)
+		{
+			lightStreamHead = (lightStreamHead + 1) & (LIGHT_STREAM_BUF_SIZE - 1);
+			lightStreamCnt--;
+			lightStreamStats.overflows++;
+		}
+
+		light_streamSample_t *pS = lightStream_at(lightStreamCnt);
+		pS->due = due;
+		memcpy(pS->v, &pSamples[2], 3);
+		lightStreamCnt++;
+
+		lightStreamStats.samples++;
+	}
+
+	lightStreamStats.depth = lightStreamCnt;
+	if (lightStreamCnt > lightStreamStats.maxDepth)
+	{
+		lightStreamStats.maxDepth = lightStreamCnt;
+	}
+}
+
+/*********************************************************************
+ * @fn      lightStream_stop
+ *
+ * @brief   End the stream without rendering, the caller renders next
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightStream_stop(void)
+{
+	if (lightStreamTimerEvt)
+	{
+		TL_ZB_TIMER_CANCEL(&lightStreamTimerEvt);
+	}
+	lightStreamCnt = 0;
+}
+
+/*********************************************************************
+ * @fn      lightStream_active
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  TRUE while stream samples drive the light
+ */
+bool lightStream_active(void)
+{
+	return (lightStreamTimerEvt != NULL);
+}
+
+/*********************************************************************
+ * @fn      lightStream_statsGet
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  pointer to the jitter buffer statistics
+ */
+light_streamStats_t *lightStream_statsGet(void)
+{
+	return &lightStreamStats;
+}
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
@@ -0,0 +1,68 @@
+/********************************************************************************************************
+ * @file    sampleLightStream.h
+ *
+ * @brief   This is the header file for sampleLightStream
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_STREAM_H_
+#define _SAMPLE_LIGHT_STREAM_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+#define LIGHT_STREAM_INTERVAL ZCL_COLOR_CHANGE_INTERVAL // render tick
+#define LIGHT_STREAM_BUF_SIZE 16						// samples, power of two
+#define LIGHT_STREAM_DELAY_MS 100						// playout delay behind the first sample
+#define LIGHT_STREAM_TIMEOUT_MS 1000					// stream ends when no sample arrives for this long
+#define LIGHT_STREAM_DELAY_MAX_MS 400					// late samples never grow the delay beyond this
+
+/* Stream frame flags */
+#define LIGHT_STREAM_FLAG_CCT BIT(0) // samples are mireds + level, RGB otherwise
+
+#define LIGHT_STREAM_SAMPLE_LEN 5 // u16 timestamp in ms, then R G B or u16 mireds + level
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Statistics of the stream jitter buffer
+ */
+typedef struct
+{
+	u32 samples;	// samples accepted into the buffer
+	u16 late;		// samples that arrived after their play time, the delay grew by their lateness up to the max
+	u16 stale;		// samples not newer than the last one, dropped
+	u16 overflows;	// oldest sample dropped because the buffer was full
+	u16 underruns;	// render ticks with no later sample to move towards
+	u16 delayMs;	// current playout delay
+	u8 depth;		// samples waiting in the buffer
+	u8 maxDepth;
+} light_streamStats_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void lightStream_put(u8 flags, u8 count, u8 *pSamples);
+void lightStream_stop(void);
+bool lightStream_active(void);
+light_streamStats_t *lightStream_statsGet(void);
+
+#endif /* _SAMPLE_LIGHT_STREAM_H_ */
@@ -0,0 +1,248 @@
+/********************************************************************************************************
+ * @file    sampleLightTransition.c
+ *
+ * @brief   This is the source file for sampleLightTransition
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightTransition.h"
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+	light_transTarget_t from;
+	light_transTarget_t to;
+	s32 hueDiff; // shortest way around the hue circle
+	u32 steps; // up to 6553.5 s at one step per LIGHT_TRANS_INTERVAL
+	u32 step;
+} light_transInfo_t;
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+static light_transInfo_t lightTransInfo;
+
+static ev_timer_event_t *lightTransTimerEvt = NULL;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      lightTrans_interp
+ *
+ * @brief   Linear interpolation from the start value, so every field
+ *          lands exactly on its target at the last step
+ *
+ * @param   from
+ * @param   diff - target minus start
+ *
+ * @return  value for the current step
+ */
+static s32 lightTrans_interp(s32 from, s32 diff)
+{
+	/* diff * step leaves s32 for long XY fades */
+	return from + (s32)((s64)diff * lightTransInfo.step / lightTransInfo.steps);
+}
+
+/*********************************************************************
+ * @fn      lightTrans_apply
+ *
+ * @brief   Write all fields of the current step, then render once
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void lightTrans_apply(void)
+{
+	light_transTarget_t *pFrom = &lightTransInfo.from;
+	light_transTarget_t *pTo = &lightTransInfo.to;
+
+#ifdef ZCL_LEVEL_CTRL
+	if (pTo->fields & LIGHT_TRANS_LEVEL)
+	{
+		zcl_levelAttr_t *pLevel = zcl_levelAttrGet();
+
+		pLevel->curLevel = (u8)lightTrans_interp(pFrom->level, (s32)pTo->level - pFrom->level);
+	}
+#endif
+
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+
+	if (pTo->fields & LIGHT_TRANS_XY)
+	{
+		pColor->currentX = (u16)lightTrans_interp(pFrom->x, (s32)pTo->x - pFrom->x);
+		pColor->currentY = (u16)lightTrans_interp(pFrom->y, (s32)pTo->y - pFrom->y);
+	}
+	else if (pTo->fields & LIGHT_TRANS_HUE_SAT)
+	{
+		pColor->enhancedCurrentHue = (u16)lightTrans_interp(pFrom->enhancedHue, lightTransInfo.hueDiff);
+		pColor->currentHue = pColor->enhancedCurrentHue >> 8;
+		pColor->currentSaturation = (u8)lightTrans_interp(pFrom->saturation, (s32)pTo->saturation - pFrom->saturation);
+	}
+	else if (pTo->fields & LIGHT_TRANS_MIREDS)
+	{
+		pColor->colorTemperatureMireds = (u16)lightTrans_interp(pFrom->mireds, (s32)pTo->mireds - pFrom->mireds);
+	}
+#endif
+
+	light_fresh();
+}
+
+/*********************************************************************
+ * @fn      lightTrans_timerCb
+ *
+ * @brief
+ *
+ * @param   arg
+ *
+ * @return  0: timer continue on; -1: timer will be canceled
+ */
+static s32 lightTrans_timerCb(void *arg)
+{
+	lightTransInfo.step++;
+	lightTrans_apply();
+
+	if (lightTransInfo.step < lightTransInfo.steps)
+	{
+		return 0;
+	}
+
+	lightTransTimerEvt = NULL;
+	return -1;
+}
+
+/*********************************************************************
+ * @fn      lightTrans_start
+ *
+ * @brief   Move level and one color group to their targets together.
+ *          All fields share one timer and one step count, so they finish
+ *          on the same tick and the light is rendered once per tick.
+ *          Any running level, color or coordinated transition is stopped.
+ *
+ * @param   pTarget   - values to reach, LIGHT_TRANS_xxx select which
+ * @param   transTime - transition time in 1/10 second
+ *
+ * @return  None
+ */
+void lightTrans_start(const light_transTarget_t *pTarget, u16 transTime)
+{
+	light_transTarget_t *pFrom = &lightTransInfo.from;
+
+	light_transitionStop();
+
+	memcpy((u8 *)&lightTransInfo.to, (u8 *)pTarget, sizeof(light_transTarget_t));
+	memset((u8 *)pFrom, 0, sizeof(light_transTarget_t));
+
+#ifdef ZCL_LEVEL_CTRL
+	pFrom->level = zcl_levelAttrGet()->curLevel;
+#endif
+
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+
+	if (pTarget->fields & LIGHT_TRANS_XY)
+	{
+		pColor->colorMode = ZCL_COLOR_MODE_CURRENT_X_Y;
+		pColor->enhancedColorMode = ZCL_COLOR_MODE_CURRENT_X_Y;
+	}
+	else if (pTarget->fields & LIGHT_TRANS_HUE_SAT)
+	{
+		if (pColor->enhancedColorMode != ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION)
+		{
+			pColor->enhancedCurrentHue = (u16)pColor->currentHue << 8;
+		}
+		pColor->colorMode = ZCL_COLOR_MODE_CURRENT_HUE_SATURATION;
+		pColor->enhancedColorMode = ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION;
+	}
+	else if (pTarget->fields & LIGHT_TRANS_MIREDS)
+	{
+		pColor->colorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
+		pColor->enhancedColorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
+	}
+
+	pFrom->x = pColor->currentX;
+	pFrom->y = pColor->currentY;
+	pFrom->enhancedHue = pColor->enhancedCurrentHue;
+	pFrom->saturation = pColor->currentSaturation;
+	pFrom->mireds = pColor->colorTemperatureMireds;
+
+	lightTransInfo.hueDiff = (s16)(pTarget->enhancedHue - pFrom->enhancedHue);
+#endif
+
+	lightTransInfo.steps = (transTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(transTime, LIGHT_TRANS_INTERVAL);
+	lightTransInfo.step = 0;
+
+	if (lightTransInfo.steps <= 1)
+	{
+		lightTransInfo.steps = 1;
+		lightTransInfo.step = 1;
+		lightTrans_apply();
+		return;
+	}
+
+	lightTransTimerEvt = TL_ZB_TIMER_SCHEDULE(lightTrans_timerCb, NULL, LIGHT_TRANS_INTERVAL);
+}
+
+/*********************************************************************
+ * @fn      lightTrans_stop
+ *
+ * @brief   Stop a coordinated transition where it is
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void lightTrans_stop(void)
+{
+	if (lightTransTimerEvt)
+	{
+		TL_ZB_TIMER_CANCEL(&lightTransTimerEvt);
+	}
+}
+
+/*********************************************************************
+ * @fn      lightTrans_active
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  TRUE while a coordinated transition is running
+ */
+bool lightTrans_active(void)
+{
+	return (lightTransTimerEvt != NULL);
+}
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
@@ -0,0 +1,65 @@
+/********************************************************************************************************
+ * @file    sampleLightTransition.h
+ *
+ * @brief   This is the header file for sampleLightTransition
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _SAMPLE_LIGHT_TRANSITION_H_
+#define _SAMPLE_LIGHT_TRANSITION_H_
+
+/**********************************************************************
+ * CONSTANT
+ */
+#define LIGHT_TRANS_INTERVAL ZCL_LEVEL_CHANGE_INTERVAL
+
+/* Fields of light_transTarget_t taking part in a transition, at most one color group */
+#define LIGHT_TRANS_LEVEL BIT(0)
+#define LIGHT_TRANS_XY BIT(1)
+#define LIGHT_TRANS_HUE_SAT BIT(2) // enhanced hue and saturation
+#define LIGHT_TRANS_MIREDS BIT(3)
+
+#define LIGHT_TRANS_COLOR (LIGHT_TRANS_XY | LIGHT_TRANS_HUE_SAT | LIGHT_TRANS_MIREDS)
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Target values of a coordinated transition
+ */
+typedef struct
+{
+	u8 fields; // LIGHT_TRANS_xxx
+	u8 level;
+	u8 saturation;
+	u16 x;
+	u16 y;
+	u16 enhancedHue;
+	u16 mireds;
+} light_transTarget_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+void lightTrans_start(const light_transTarget_t *pTarget, u16 transTime);
+void lightTrans_stop(void);
+bool lightTrans_active(void);
+
+#endif /* _SAMPLE_LIGHT_TRANSITION_H_ */
@@ -46,7 +46,7 @@
  *  @brief  ZCL: MAX number of cluster list, in cluster number add  + out cluster number
  *
  */
-#define ZCL_CLUSTER_NUM_MAX 11
+#define ZCL_CLUSTER_NUM_MAX 13
 
 /**
  *  @brief  ZCL: maximum number for zcl reporting table
@@ -33,6 +33,7 @@
 #include "ota.h"
 #include "sampleLight.h"
 #include "sampleLightCtrl.h"
+#include "sampleLightOta.h"
 
 /**********************************************************************
  * LOCAL CONSTANTS
@@ -128,7 +129,7 @@ void zbdemo_bdbInitCb(u8 status, u8 joinedNetwork)
 			heartInterval = 1000;
 
 #ifdef ZCL_OTA
-			ota_queryStart(OTA_PERIODIC_QUERY_INTERVAL);
+			ota_queryStart(lightOta_queryInterval());
 #endif
 		}
 		else
@@ -185,7 +186,7 @@ void zbdemo_bdbCommissioningCb(u8 status, void *arg)
 			light_blink_start(2, 200, 200);
 
 #ifdef ZCL_OTA
-			ota_queryStart(OTA_PERIODIC_QUERY_INTERVAL);
+			ota_queryStart(lightOta_queryInterval());
 #endif
 
 #if FIND_AND_BIND_SUPPORT
@@ -256,6 +257,8 @@ void sampleLight_otaProcessMsgHandler(u8 evt, u8 status)
 	{
 		if (status == ZCL_STA_SUCCESS)
 		{
+			lightOta_resumeStart();
+			lightOta_paceStart();
 		}
 		else
 		{
@@ -263,7 +266,12 @@ void sampleLight_otaProcessMsgHandler(u8 evt, u8 status)
 	}
 	else if (evt == OTA_EVT_COMPLETE)
 	{
-		if (status == ZCL_STA_SUCCESS)
+		lightOta_paceStop();
+		/* finished or given up, either way the next download starts over */
+		lightOta_resumeClear();
+
+		// A delta image is rebuilt into the full one before the banks are switched
+		if ((status == ZCL_STA_SUCCESS) && (lightOta_imageFinalize() == ZCL_STA_SUCCESS))
 		{
 			ota_mcuReboot();
 		}
@@ -30,6 +30,10 @@
 #include "zcl_include.h"
 #include "sampleLight.h"
 #include "sampleLightCtrl.h"
+#include "sampleLightTransition.h"
+#include "zcl_lightExt.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
 
 #include "app_ui.h"
 #ifdef ZCL_LIGHT_COLOR_CONTROL
@@ -42,14 +46,17 @@ typedef struct
 	s32 stepHue256;
 	u16 currentHue256;
 	u16 hueRemainingTime;
+	u8 targetHue;
 
 	s32 stepSaturation256;
 	u16 currentSaturation256;
 	u16 saturationRemainingTime;
+	u8 targetSaturation;
 
 	s32 stepColorTemp256;
 	u32 currentColorTemp256;
 	u16 colorTempRemainingTime;
+	u16 targetColorTemp;
 	u16 colorTempMinMireds;
 	u16 colorTempMaxMireds;
 
@@ -62,6 +69,7 @@ typedef struct
 	u32 currentEnhancedHue256;
 	s32 stepEnhancedHue256;
 	u16 enhancedHueRemainingTime;
+	u16 targetEnhancedHue;
 } zcl_colorInfo_t;
 
 /**********************************************************************
@@ -71,14 +79,17 @@ static zcl_colorInfo_t colorInfo = {
 	.stepHue256 = 0,
 	.currentHue256 = 0,
 	.hueRemainingTime = 0,
+	.targetHue = 0,
 
 	.stepSaturation256 = 0,
 	.currentSaturation256 = 0,
 	.saturationRemainingTime = 0,
+	.targetSaturation = 0,
 
 	.stepColorTemp256 = 0,
 	.currentColorTemp256 = 0,
 	.colorTempRemainingTime = 0,
+	.targetColorTemp = 0,
 	.colorTempMinMireds = 0,
 	.colorTempMaxMireds = 0,
 	
@@ -91,6 +102,7 @@ static zcl_colorInfo_t colorInfo = {
 	.currentEnhancedHue256 = 0,
 	.stepEnhancedHue256 = 0,
 	.enhancedHueRemainingTime = 0,
+	.targetEnhancedHue = 0,
 };
 
 static ev_timer_event_t *colorTimerEvt = NULL;
@@ -127,12 +139,29 @@ void sampleLight_colorInit(void)
 	colorInfo.xyRemainingTime = 0;
 	colorInfo.enhancedHueRemainingTime = 0;
 
-	// Startup is only defined for color temperature, so why would we load any colors here ...
-	pColor->colorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
-	pColor->enhancedColorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
+	// The restored color mode is kept, so RGB lamps come back in the color they had before power loss
+	if ((pColor->colorMode != ZCL_COLOR_MODE_CURRENT_HUE_SATURATION) &&
+		(pColor->colorMode != ZCL_COLOR_MODE_CURRENT_X_Y) &&
+		(pColor->colorMode != ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS))
+	{
+		pColor->colorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
+	}
 
-	light_applyUpdate_16(&pColor->colorTemperatureMireds, &colorInfo.currentColorTemp256, &colorInfo.stepColorTemp256, &colorInfo.colorTempRemainingTime,
-						 pColor->colorTempPhysicalMinMireds, pColor->colorTempPhysicalMaxMireds, FALSE);
+	if ((pColor->enhancedColorMode != ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION) ||
+		(pColor->colorMode != ZCL_COLOR_MODE_CURRENT_HUE_SATURATION))
+	{
+		pColor->enhancedColorMode = pColor->colorMode;
+	}
+
+	if (pColor->colorMode == ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS)
+	{
+		light_applyUpdate_16(&pColor->colorTemperatureMireds, &colorInfo.currentColorTemp256, &colorInfo.stepColorTemp256, &colorInfo.colorTempRemainingTime,
+							 pColor->colorTempPhysicalMinMireds, pColor->colorTempPhysicalMaxMireds, FALSE);
+	}
+	else
+	{
+		light_fresh();
+	}
 }
 
 /*********************************************************************
@@ -173,7 +202,24 @@ void sampleLight_updateColorMode(u8 colorMode)
 		led_off(LED_STATUS_G);
 		led_off(LED_STATUS_B);
 	}
-	
+
+	// The timer only steps the runs of the current mode, a run left over from another mode would keep it going forever
+	if (colorMode != ZCL_COLOR_MODE_CURRENT_HUE_SATURATION)
+	{
+		colorInfo.hueRemainingTime = 0;
+		colorInfo.saturationRemainingTime = 0;
+		colorInfo.enhancedHueRemainingTime = 0;
+	}
+
+	if (colorMode != ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS)
+	{
+		colorInfo.colorTempRemainingTime = 0;
+	}
+
+	if (colorMode != ZCL_COLOR_MODE_CURRENT_X_Y)
+	{
+		colorInfo.xyRemainingTime = 0;
+	}
 }
 
 /*********************************************************************
@@ -219,6 +265,7 @@ static s32 sampleLight_colorTimerEvtCb(void *arg)
 {
 	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
 
+	// The 8.8 steps drop a fraction per tick, a run that ends is set to its target so a long transition does not land short.
 	// It is safe to use the enhanced mode here, because we control it ourselves.
 	if ((pColor->enhancedColorMode == ZCL_COLOR_MODE_CURRENT_HUE_SATURATION) ||
 		(pColor->enhancedColorMode == ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION))
@@ -227,18 +274,33 @@ static s32 sampleLight_colorTimerEvtCb(void *arg)
 		{
 			light_applyUpdate(&pColor->currentSaturation, &colorInfo.currentSaturation256, &colorInfo.stepSaturation256, &colorInfo.saturationRemainingTime,
 							  ZCL_COLOR_ATTR_SATURATION_MIN, ZCL_COLOR_ATTR_SATURATION_MAX, FALSE);
+
+			if (!colorInfo.saturationRemainingTime)
+			{
+				pColor->currentSaturation = colorInfo.targetSaturation;
+			}
 		}
 
 		if (colorInfo.hueRemainingTime)
 		{
 			light_applyUpdate(&pColor->currentHue, &colorInfo.currentHue256, &colorInfo.stepHue256, &colorInfo.hueRemainingTime,
 							  ZCL_COLOR_ATTR_HUE_MIN, ZCL_COLOR_ATTR_HUE_MAX, TRUE);
+
+			if (!colorInfo.hueRemainingTime)
+			{
+				pColor->currentHue = colorInfo.targetHue;
+			}
 		}
 
 		if (colorInfo.enhancedHueRemainingTime) 
 		{
 			light_applyUpdate_16(&pColor->enhancedCurrentHue, &colorInfo.currentEnhancedHue256, &colorInfo.stepEnhancedHue256, &colorInfo.enhancedHueRemainingTime,
 							 ZCL_COLOR_ATTR_ENHANCED_HUE_MIN, ZCL_COLOR_ATTR_ENHANCED_HUE_MAX, TRUE);
+
+			if (!colorInfo.enhancedHueRemainingTime)
+			{
+				pColor->enhancedCurrentHue = colorInfo.targetEnhancedHue;
+			}
 		}
 	}
 	else if (pColor->enhancedColorMode == ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS)
@@ -247,6 +309,11 @@ static s32 sampleLight_colorTimerEvtCb(void *arg)
 		{
 			light_applyUpdate_16(&pColor->colorTemperatureMireds, &colorInfo.currentColorTemp256, &colorInfo.stepColorTemp256, &colorInfo.colorTempRemainingTime,
 								 colorInfo.colorTempMinMireds, colorInfo.colorTempMaxMireds, FALSE);
+
+			if (!colorInfo.colorTempRemainingTime)
+			{
+				pColor->colorTemperatureMireds = colorInfo.targetColorTemp;
+			}
 		}
 	}
 	else if (pColor->enhancedColorMode == ZCL_COLOR_MODE_CURRENT_X_Y)
@@ -286,6 +353,26 @@ static void sampleLight_colorTimerStop(void)
 	}
 }
 
+/*********************************************************************
+ * @fn      sampleLight_colorTimerRestart
+ *
+ * @brief   restart the color timer for every run still left, a new command
+ *          must not freeze a run of the same mode it does not replace
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void sampleLight_colorTimerRestart(void)
+{
+	sampleLight_colorTimerStop();
+
+	if (colorInfo.saturationRemainingTime || colorInfo.hueRemainingTime || colorInfo.enhancedHueRemainingTime || colorInfo.colorTempRemainingTime || colorInfo.xyRemainingTime)
+	{
+		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
+	}
+}
+
 /*********************************************************************
  * @fn      sampleLight_colorLoopTimerEvtCb
  *
@@ -314,7 +401,7 @@ static s32 sampleLight_colorLoopTimerEvtCb(void *arg)
 /*********************************************************************
  * @fn      sampleLight_colorLoopTimerStop
  *
- * @brief
+ * @brief   cancel the color loop timer, the loop is no longer active afterwards
  *
  * @param   None
  *
@@ -322,10 +409,63 @@ static s32 sampleLight_colorLoopTimerEvtCb(void *arg)
  */
 static void sampleLight_colorLoopTimerStop(void)
 {
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+
 	if (colorLoopTimerEvt)
 	{
 		TL_ZB_TIMER_CANCEL(&colorLoopTimerEvt);
 	}
+
+	pColor->colorLoopActive = 0;
+}
+
+/*********************************************************************
+ * @fn      sampleLight_colorTransitionActive
+ *
+ * @brief   whether a color transition or color loop is currently running
+ *
+ * @param   None
+ *
+ * @return  TRUE if one of the color timers is scheduled
+ */
+bool sampleLight_colorTransitionActive(void)
+{
+	return (colorTimerEvt != NULL) || (colorLoopTimerEvt != NULL);
+}
+
+/*********************************************************************
+ * @fn      sampleLight_colorFadeActive
+ *
+ * @brief   whether a color transition is running, the color loop is not counted
+ *
+ * @param   None
+ *
+ * @return  TRUE if the color transition timer is scheduled
+ */
+bool sampleLight_colorFadeActive(void)
+{
+	return (colorTimerEvt != NULL);
+}
+
+/*********************************************************************
+ * @fn      sampleLight_colorTransitionStop
+ *
+ * @brief   abort a running color transition and color loop
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+void sampleLight_colorTransitionStop(void)
+{
+	colorInfo.hueRemainingTime = 0;
+	colorInfo.saturationRemainingTime = 0;
+	colorInfo.enhancedHueRemainingTime = 0;
+	colorInfo.colorTempRemainingTime = 0;
+	colorInfo.xyRemainingTime = 0;
+
+	sampleLight_colorTimerStop();
+	sampleLight_colorLoopTimerStop();
 }
 
 /*********************************************************************
@@ -375,13 +515,13 @@ static void sampleLight_moveToHueProcess(zcl_colorCtrlMoveToHueCmd_t *cmd)
 	case COLOR_CTRL_DIRECTION_UP:
 		if (hueDiff < 0)
 		{
-			hueDiff += ZCL_COLOR_ATTR_HUE_MAX;
+			hueDiff += (ZCL_COLOR_ATTR_HUE_MAX + 1);
 		}
 		break;
 	case COLOR_CTRL_DIRECTION_DOWN:
 		if (hueDiff > 0)
 		{
-			hueDiff -= ZCL_COLOR_ATTR_HUE_MAX;
+			hueDiff -= (ZCL_COLOR_ATTR_HUE_MAX + 1);
 		}
 		break;
 	default:
@@ -389,17 +529,14 @@ static void sampleLight_moveToHueProcess(zcl_colorCtrlMoveToHueCmd_t *cmd)
 	}
 
 	colorInfo.hueRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
+	colorInfo.targetHue = cmd->hue;
 	colorInfo.stepHue256 = ((s32)hueDiff) << 8;
 	colorInfo.stepHue256 /= (s32)colorInfo.hueRemainingTime;
 
 	light_applyUpdate(&pColor->currentHue, &colorInfo.currentHue256, &colorInfo.stepHue256, &colorInfo.hueRemainingTime,
 					  ZCL_COLOR_ATTR_HUE_MIN, ZCL_COLOR_ATTR_HUE_MAX, TRUE);
 	
-	sampleLight_colorTimerStop();
-	if (colorInfo.hueRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -429,11 +566,11 @@ static void sampleLight_moveHueProcess(zcl_colorCtrlMoveHueCmd_t *cmd)
 		colorInfo.hueRemainingTime = 0;
 		break;
 	case COLOR_CTRL_MOVE_UP:
-		colorInfo.stepHue256 = (((s32)cmd->rate) << 8) / 10;
+		colorInfo.stepHue256 = INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
 		colorInfo.hueRemainingTime = 0xFFFF;
 		break;
 	case COLOR_CTRL_MOVE_DOWN:
-		colorInfo.stepHue256 = ((-(s32)cmd->rate) << 8) / 10;
+		colorInfo.stepHue256 = -INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
 		colorInfo.hueRemainingTime = 0xFFFF;
 		break;
 	default:
@@ -443,11 +580,7 @@ static void sampleLight_moveHueProcess(zcl_colorCtrlMoveHueCmd_t *cmd)
 	light_applyUpdate(&pColor->currentHue, &colorInfo.currentHue256, &colorInfo.stepHue256, &colorInfo.hueRemainingTime,
 					  ZCL_COLOR_ATTR_HUE_MIN, ZCL_COLOR_ATTR_HUE_MAX, TRUE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.hueRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -473,12 +606,15 @@ static void sampleLight_stepHueProcess(zcl_colorCtrlStepHueCmd_t *cmd)
 	colorInfo.hueRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
 
 	colorInfo.stepHue256 = (((s32)cmd->stepSize) << 8) / colorInfo.hueRemainingTime;
+	colorInfo.targetHue = pColor->currentHue;
 
 	switch (cmd->stepMode)
 	{
 	case COLOR_CTRL_STEP_MODE_UP:
+		colorInfo.targetHue = ((u16)pColor->currentHue + cmd->stepSize) % (ZCL_COLOR_ATTR_HUE_MAX + 1);
 		break;
 	case COLOR_CTRL_STEP_MODE_DOWN:
+		colorInfo.targetHue = ((u16)pColor->currentHue + (ZCL_COLOR_ATTR_HUE_MAX + 1) - cmd->stepSize % (ZCL_COLOR_ATTR_HUE_MAX + 1)) % (ZCL_COLOR_ATTR_HUE_MAX + 1);
 		colorInfo.stepHue256 = -colorInfo.stepHue256;
 		break;
 	default:
@@ -488,11 +624,7 @@ static void sampleLight_stepHueProcess(zcl_colorCtrlStepHueCmd_t *cmd)
 	light_applyUpdate(&pColor->currentHue, &colorInfo.currentHue256, &colorInfo.stepHue256, &colorInfo.hueRemainingTime,
 					  ZCL_COLOR_ATTR_HUE_MIN, ZCL_COLOR_ATTR_HUE_MAX, TRUE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.hueRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -519,17 +651,14 @@ static void sampleLight_moveToSaturationProcess(zcl_colorCtrlMoveToSaturationCmd
 
 	colorInfo.saturationRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
 
-	colorInfo.stepSaturation256 = ((s32)(cmd->saturation - pColor->currentSaturation)) << 8;
+	colorInfo.targetSaturation = (cmd->saturation > ZCL_COLOR_ATTR_SATURATION_MAX) ? ZCL_COLOR_ATTR_SATURATION_MAX : cmd->saturation;
+	colorInfo.stepSaturation256 = ((s32)(colorInfo.targetSaturation - pColor->currentSaturation)) << 8;
 	colorInfo.stepSaturation256 /= (s32)colorInfo.saturationRemainingTime;
 
 	light_applyUpdate(&pColor->currentSaturation, &colorInfo.currentSaturation256, &colorInfo.stepSaturation256, &colorInfo.saturationRemainingTime,
 					  ZCL_COLOR_ATTR_SATURATION_MIN, ZCL_COLOR_ATTR_SATURATION_MAX, FALSE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.saturationRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -559,12 +688,14 @@ static void sampleLight_moveSaturationProcess(zcl_colorCtrlMoveSaturationCmd_t *
 		colorInfo.saturationRemainingTime = 0;
 		break;
 	case COLOR_CTRL_MOVE_UP:
-		colorInfo.stepSaturation256 = (((s32)cmd->rate) << 8) / 10;
+		colorInfo.stepSaturation256 = INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
 		colorInfo.saturationRemainingTime = 0xFFFF;
+		colorInfo.targetSaturation = ZCL_COLOR_ATTR_SATURATION_MAX;
 		break;
 	case COLOR_CTRL_MOVE_DOWN:
-		colorInfo.stepSaturation256 = ((-(s32)cmd->rate) << 8) / 10;
+		colorInfo.stepSaturation256 = -INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
 		colorInfo.saturationRemainingTime = 0xFFFF;
+		colorInfo.targetSaturation = ZCL_COLOR_ATTR_SATURATION_MIN;
 		break;
 	default:
 		break;
@@ -573,11 +704,7 @@ static void sampleLight_moveSaturationProcess(zcl_colorCtrlMoveSaturationCmd_t *
 	light_applyUpdate(&pColor->currentSaturation, &colorInfo.currentSaturation256, &colorInfo.stepSaturation256, &colorInfo.saturationRemainingTime,
 					  ZCL_COLOR_ATTR_SATURATION_MIN, ZCL_COLOR_ATTR_SATURATION_MAX, FALSE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.saturationRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -603,12 +730,17 @@ static void sampleLight_stepSaturationProcess(zcl_colorCtrlStepSaturationCmd_t *
 	colorInfo.saturationRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
 
 	colorInfo.stepSaturation256 = (((s32)cmd->stepSize) << 8) / colorInfo.saturationRemainingTime;
+	colorInfo.targetSaturation = pColor->currentSaturation;
 
 	switch (cmd->stepMode)
 	{
 	case COLOR_CTRL_STEP_MODE_UP:
+		colorInfo.targetSaturation = ((u16)pColor->currentSaturation + cmd->stepSize > ZCL_COLOR_ATTR_SATURATION_MAX) ? ZCL_COLOR_ATTR_SATURATION_MAX
+																													  : pColor->currentSaturation + cmd->stepSize;
 		break;
 	case COLOR_CTRL_STEP_MODE_DOWN:
+		colorInfo.targetSaturation = ((s16)pColor->currentSaturation - cmd->stepSize < ZCL_COLOR_ATTR_SATURATION_MIN) ? ZCL_COLOR_ATTR_SATURATION_MIN
+																													   : pColor->currentSaturation - cmd->stepSize;
 		colorInfo.stepSaturation256 = -colorInfo.stepSaturation256;
 		break;
 	default:
@@ -618,11 +750,7 @@ static void sampleLight_stepSaturationProcess(zcl_colorCtrlStepSaturationCmd_t *
 	light_applyUpdate(&pColor->currentSaturation, &colorInfo.currentSaturation256, &colorInfo.stepSaturation256, &colorInfo.saturationRemainingTime,
 					  ZCL_COLOR_ATTR_SATURATION_MIN, ZCL_COLOR_ATTR_SATURATION_MAX, FALSE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.saturationRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -677,6 +805,7 @@ static void sampleLight_moveToColorProcess(zcl_colorCtrlMoveToColorCmd_t *cmd)
 	// Development override, something is wrong
 	pColor->currentX = cmd->colorX;
 	pColor->currentY = cmd->colorY;
+	colorInfo.xyRemainingTime = 0;
 	sampleLight_colorTimerStop();
 	light_fresh();
 
@@ -701,11 +830,7 @@ static void sampleLight_moveToColorProcess(zcl_colorCtrlMoveToColorCmd_t *cmd)
 							&pColor->currentY, &colorInfo.currentY256, &colorInfo.stepY256,
 							&colorInfo.xyRemainingTime, ZCL_COLOR_ATTR_XY_MIN, ZCL_COLOR_ATTR_XY_MAX, FALSE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.xyRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 
 	*/
 }
@@ -798,13 +923,13 @@ static void sampleLight_enhancedMoveToHueProcess(zcl_colorCtrlEnhancedMoveToHueC
 	case COLOR_CTRL_DIRECTION_UP:
 		if (hueDiff < 0)
 		{
-			hueDiff += ZCL_COLOR_ATTR_ENHANCED_HUE_MAX;
+			hueDiff += (ZCL_COLOR_ATTR_ENHANCED_HUE_MAX + 1);
 		}
 		break;
 	case COLOR_CTRL_DIRECTION_DOWN:
 		if (hueDiff > 0)
 		{
-			hueDiff -= ZCL_COLOR_ATTR_ENHANCED_HUE_MAX;
+			hueDiff -= (ZCL_COLOR_ATTR_ENHANCED_HUE_MAX + 1);
 		}
 		break;
 	default:
@@ -812,17 +937,14 @@ static void sampleLight_enhancedMoveToHueProcess(zcl_colorCtrlEnhancedMoveToHueC
 	}
 
 	colorInfo.enhancedHueRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
+	colorInfo.targetEnhancedHue = cmd->enhancedHue;
 	colorInfo.stepEnhancedHue256 = ((s32)hueDiff) << 8;
 	colorInfo.stepEnhancedHue256 /= (s32)colorInfo.enhancedHueRemainingTime;
 
 	light_applyUpdate_16(&pColor->enhancedCurrentHue, &colorInfo.currentEnhancedHue256, &colorInfo.stepEnhancedHue256, &colorInfo.enhancedHueRemainingTime,
 					  ZCL_COLOR_ATTR_ENHANCED_HUE_MIN, ZCL_COLOR_ATTR_ENHANCED_HUE_MAX, TRUE);
 	
-	sampleLight_colorTimerStop();
-	if (colorInfo.enhancedHueRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -843,17 +965,30 @@ static void sampleLight_enhancedMoveHueProcess(zcl_colorCtrlEnhancedMoveHueCmd_t
 	pColor->colorMode = ZCL_COLOR_MODE_CURRENT_HUE_SATURATION;
 	pColor->enhancedColorMode = ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION;
 
+	colorInfo.currentEnhancedHue256 = (u32)(pColor->enhancedCurrentHue) << 8;
+
 	switch (cmd->moveMode)
 	{
 	case COLOR_CTRL_MOVE_STOP:
+		colorInfo.stepEnhancedHue256 = 0;
+		colorInfo.enhancedHueRemainingTime = 0;
 		break;
 	case COLOR_CTRL_MOVE_UP:
+		colorInfo.stepEnhancedHue256 = INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
+		colorInfo.enhancedHueRemainingTime = 0xFFFF;
 		break;
 	case COLOR_CTRL_MOVE_DOWN:
+		colorInfo.stepEnhancedHue256 = -INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
+		colorInfo.enhancedHueRemainingTime = 0xFFFF;
 		break;
 	default:
 		break;
 	}
+
+	light_applyUpdate_16(&pColor->enhancedCurrentHue, &colorInfo.currentEnhancedHue256, &colorInfo.stepEnhancedHue256, &colorInfo.enhancedHueRemainingTime,
+					  ZCL_COLOR_ATTR_ENHANCED_HUE_MIN, ZCL_COLOR_ATTR_ENHANCED_HUE_MAX, TRUE);
+
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -874,15 +1009,30 @@ static void sampleLight_enhancedStepHueProcess(zcl_colorCtrlEnhancedStepHueCmd_t
 	pColor->colorMode = ZCL_COLOR_MODE_CURRENT_HUE_SATURATION;
 	pColor->enhancedColorMode = ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION;
 
+	colorInfo.currentEnhancedHue256 = (u32)(pColor->enhancedCurrentHue) << 8;
+
+	colorInfo.enhancedHueRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
+
+	colorInfo.stepEnhancedHue256 = (((s32)cmd->stepSize) << 8) / colorInfo.enhancedHueRemainingTime;
+	colorInfo.targetEnhancedHue = pColor->enhancedCurrentHue;
+
 	switch (cmd->stepMode)
 	{
 	case COLOR_CTRL_STEP_MODE_UP:
+		colorInfo.targetEnhancedHue = pColor->enhancedCurrentHue + cmd->stepSize;
 		break;
 	case COLOR_CTRL_STEP_MODE_DOWN:
+		colorInfo.targetEnhancedHue = pColor->enhancedCurrentHue - cmd->stepSize;
+		colorInfo.stepEnhancedHue256 = -colorInfo.stepEnhancedHue256;
 		break;
 	default:
 		break;
 	}
+
+	light_applyUpdate_16(&pColor->enhancedCurrentHue, &colorInfo.currentEnhancedHue256, &colorInfo.stepEnhancedHue256, &colorInfo.enhancedHueRemainingTime,
+					  ZCL_COLOR_ATTR_ENHANCED_HUE_MIN, ZCL_COLOR_ATTR_ENHANCED_HUE_MAX, TRUE);
+
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -979,17 +1129,15 @@ static void sampleLight_moveToColorTemperatureProcess(zcl_colorCtrlMoveToColorTe
 
 	colorInfo.colorTempRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
 
-	colorInfo.stepColorTemp256 = ((s32)(cmd->colorTemperature - pColor->colorTemperatureMireds)) << 8;
+	colorInfo.targetColorTemp = (cmd->colorTemperature < colorInfo.colorTempMinMireds) ? colorInfo.colorTempMinMireds
+							  : (cmd->colorTemperature > colorInfo.colorTempMaxMireds) ? colorInfo.colorTempMaxMireds : cmd->colorTemperature;
+	colorInfo.stepColorTemp256 = ((s32)(colorInfo.targetColorTemp - pColor->colorTemperatureMireds)) << 8;
 	colorInfo.stepColorTemp256 /= (s32)colorInfo.colorTempRemainingTime;
 
 	light_applyUpdate_16(&pColor->colorTemperatureMireds, &colorInfo.currentColorTemp256, &colorInfo.stepColorTemp256, &colorInfo.colorTempRemainingTime,
 						 colorInfo.colorTempMinMireds, colorInfo.colorTempMaxMireds, FALSE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.colorTempRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -1039,12 +1187,14 @@ static void sampleLight_moveColorTemperatureProcess(zcl_colorCtrlMoveColorTemper
 		colorInfo.colorTempRemainingTime = 0;
 		break;
 	case COLOR_CTRL_MOVE_UP:
-		colorInfo.stepColorTemp256 = (((s32)cmd->rate) << 8) / 10;
+		colorInfo.stepColorTemp256 = INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
 		colorInfo.colorTempRemainingTime = 0xFFFF;
+		colorInfo.targetColorTemp = colorInfo.colorTempMaxMireds;
 		break;
 	case COLOR_CTRL_MOVE_DOWN:
-		colorInfo.stepColorTemp256 = ((-(s32)cmd->rate) << 8) / 10;
+		colorInfo.stepColorTemp256 = -INTERP_STEP256_FROM_RATE(cmd->rate, ZCL_COLOR_CHANGE_INTERVAL);
 		colorInfo.colorTempRemainingTime = 0xFFFF;
+		colorInfo.targetColorTemp = colorInfo.colorTempMinMireds;
 		break;
 	default:
 		break;
@@ -1053,11 +1203,7 @@ static void sampleLight_moveColorTemperatureProcess(zcl_colorCtrlMoveColorTemper
 	light_applyUpdate_16(&pColor->colorTemperatureMireds, &colorInfo.currentColorTemp256, &colorInfo.stepColorTemp256, &colorInfo.colorTempRemainingTime,
 						 colorInfo.colorTempMinMireds, colorInfo.colorTempMaxMireds, FALSE);
 
-	sampleLight_colorTimerStop();
-	if (colorInfo.colorTempRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -1102,27 +1248,38 @@ static void sampleLight_stepColorTemperatureProcess(zcl_colorCtrlStepColorTemper
 
 	colorInfo.colorTempRemainingTime = (cmd->transitionTime == 0) ? 1 : INTERP_STEPS_FROM_ONE_TENTH(cmd->transitionTime, ZCL_COLOR_CHANGE_INTERVAL);
 
-	colorInfo.stepColorTemp256 = (((s32)cmd->stepSize) << 8) / colorInfo.colorTempRemainingTime;
+	s32 target = pColor->colorTemperatureMireds;
 
 	switch (cmd->stepMode)
 	{
 	case COLOR_CTRL_STEP_MODE_UP:
+		target += cmd->stepSize;
 		break;
 	case COLOR_CTRL_STEP_MODE_DOWN:
-		colorInfo.stepColorTemp256 = -colorInfo.stepColorTemp256;
+		target -= cmd->stepSize;
 		break;
 	default:
 		break;
 	}
 
+	// The step ends within the limits, also when it starts outside of them, the timer only clamps a step that crosses one
+	if (target > colorInfo.colorTempMaxMireds)
+	{
+		target = colorInfo.colorTempMaxMireds;
+	}
+	else if (target < colorInfo.colorTempMinMireds)
+	{
+		target = colorInfo.colorTempMinMireds;
+	}
+
+	colorInfo.targetColorTemp = target;
+	colorInfo.stepColorTemp256 = (target - pColor->colorTemperatureMireds) << 8;
+	colorInfo.stepColorTemp256 /= (s32)colorInfo.colorTempRemainingTime;
+
 	light_applyUpdate_16(&pColor->colorTemperatureMireds, &colorInfo.currentColorTemp256, &colorInfo.stepColorTemp256, &colorInfo.colorTempRemainingTime,
 						 colorInfo.colorTempMinMireds, colorInfo.colorTempMaxMireds, FALSE);
 	
-	sampleLight_colorTimerStop();
-	if (colorInfo.colorTempRemainingTime)
-	{
-		colorTimerEvt = TL_ZB_TIMER_SCHEDULE(sampleLight_colorTimerEvtCb, NULL, ZCL_COLOR_CHANGE_INTERVAL);
-	}
+	sampleLight_colorTimerRestart();
 }
 
 /*********************************************************************
@@ -1140,7 +1297,9 @@ static void sampleLight_stopMoveStepProcess(void)
 
 	colorInfo.hueRemainingTime = 0;
 	colorInfo.saturationRemainingTime = 0;
+	colorInfo.enhancedHueRemainingTime = 0;
 	colorInfo.colorTempRemainingTime = 0;
+	colorInfo.xyRemainingTime = 0;
 
 	sampleLight_colorTimerStop();
 }
@@ -1160,6 +1319,18 @@ status_t sampleLight_colorCtrlCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, voi
 {
 	if (pAddrInfo->dstEp == SAMPLE_LIGHT_ENDPOINT)
 	{
+		// A new command takes over from a scene recall still in progress, a loop setting alone does not conflict with it
+		if (cmdId != ZCL_CMD_LIGHT_COLOR_CONTROL_COLOR_LOOP_SET)
+		{
+			lightTrans_stop();
+		}
+#ifdef ZCL_LIGHT_EXT
+		lightAnim_stop();
+#endif
+#if LIGHT_CIRCADIAN_ENABLE
+		lightCircadian_override();
+#endif
+
 		switch (cmdId)
 		{
 		case ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_HUE:
@@ -30,6 +30,10 @@
 #include "zcl_include.h"
 #include "sampleLight.h"
 #include "sampleLightCtrl.h"
+#include "sampleLightTransition.h"
+#include "zcl_lightExt.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
 
 #ifdef ZCL_LEVEL_CTRL
 
@@ -40,6 +44,7 @@ typedef struct
 {
 	s32 stepLevel256;
 	u16 currentLevel256;
+	u8 targetLevel;
 	u8 withOnOff;
 } zcl_levelInfo_t;
 
@@ -49,6 +54,7 @@ typedef struct
 static zcl_levelInfo_t levelInfo = {
 	.stepLevel256 = 0,
 	.currentLevel256 = 0,
+	.targetLevel = 0,
 	.withOnOff = 0,
 };
 
@@ -71,6 +77,14 @@ static s32 sampleLight_levelTimerEvtCb(void *arg)
 	{
 		light_applyUpdate(&pLevel->curLevel, &levelInfo.currentLevel256, &levelInfo.stepLevel256, &pLevel->remainingTime,
 						  ZCL_LEVEL_ATTR_MIN_LEVEL, ZCL_LEVEL_ATTR_MAX_LEVEL, FALSE);
+
+		// The 8.8 step drops a fraction per tick, a long transition lands a few levels short without this
+		if ((pLevel->remainingTime == 0) && (pLevel->curLevel != levelInfo.targetLevel))
+		{
+			pLevel->curLevel = levelInfo.targetLevel;
+			levelInfo.currentLevel256 = (u16)(pLevel->curLevel) << 8;
+			light_fresh();
+		}
 	}
 
 	if (levelInfo.withOnOff)
@@ -109,6 +123,38 @@ static void sampleLight_LevelTimerStop(void)
 	}
 }
 
+/*********************************************************************
+ * @fn      sampleLight_levelTransitionActive
+ *
+ * @brief   whether a level transition is currently running
+ *
+ * @param
+ *
+ * @return  TRUE if the level timer is scheduled
+ */
+bool sampleLight_levelTransitionActive(void)
+{
+	return (levelTimerEvt != NULL);
+}
+
+/*********************************************************************
+ * @fn      sampleLight_levelTransitionStop
+ *
+ * @brief   abort a running level transition, the current level is kept
+ *
+ * @param
+ *
+ * @return
+ */
+void sampleLight_levelTransitionStop(void)
+{
+	zcl_levelAttr_t *pLevel = zcl_levelAttrGet();
+
+	sampleLight_LevelTimerStop();
+
+	pLevel->remainingTime = 0;
+}
+
 /*********************************************************************
  * @fn      sampleLight_moveToLevelProcess
  *
@@ -127,6 +173,8 @@ static void sampleLight_moveToLevelProcess(u8 cmdId, moveToLvl_t *cmd)
 
 	levelInfo.withOnOff = (cmdId == ZCL_CMD_LEVEL_MOVE_TO_LEVEL_WITH_ON_OFF) ? TRUE : FALSE;
 	levelInfo.currentLevel256 = (u16)(pLevel->curLevel) << 8;
+	levelInfo.targetLevel = (cmd->level < ZCL_LEVEL_ATTR_MIN_LEVEL) ? ZCL_LEVEL_ATTR_MIN_LEVEL
+						  : (cmd->level > ZCL_LEVEL_ATTR_MAX_LEVEL) ? ZCL_LEVEL_ATTR_MAX_LEVEL : cmd->level;
 	levelInfo.stepLevel256 = ((s32)(cmd->level - pLevel->curLevel)) << 8;
 	levelInfo.stepLevel256 /= (s32)pLevel->remainingTime;
 
@@ -169,7 +217,7 @@ static void sampleLight_moveProcess(u8 cmdId, move_t *cmd)
 	levelInfo.withOnOff = (cmdId == ZCL_CMD_LEVEL_MOVE_WITH_ON_OFF) ? TRUE : FALSE;
 	levelInfo.currentLevel256 = (u16)(pLevel->curLevel) << 8;
 
-	u32 rate = (u32)cmd->rate * 100;
+	u32 rate = (u32)cmd->rate * ZCL_LEVEL_CHANGE_INTERVAL;
 	u8 newLevel;
 	u8 deltaLevel;
 	if (cmd->moveMode == LEVEL_MOVE_UP)
@@ -188,6 +236,7 @@ static void sampleLight_moveProcess(u8 cmdId, move_t *cmd)
 		pLevel->remainingTime = 1;
 	}
 
+	levelInfo.targetLevel = newLevel;
 	levelInfo.stepLevel256 = ((s32)(newLevel - pLevel->curLevel)) << 8;
 	levelInfo.stepLevel256 /= (s32)pLevel->remainingTime;
 
@@ -239,6 +288,8 @@ static void sampleLight_stepProcess(u8 cmdId, step_t *cmd)
 
 	if (cmd->stepMode == LEVEL_STEP_UP)
 	{
+		levelInfo.targetLevel = ((u16)pLevel->curLevel + cmd->stepSize > ZCL_LEVEL_ATTR_MAX_LEVEL) ? ZCL_LEVEL_ATTR_MAX_LEVEL
+																								 : pLevel->curLevel + cmd->stepSize;
 		if (levelInfo.withOnOff)
 		{
 			sampleLight_onoff(ZCL_CMD_ONOFF_ON);
@@ -246,6 +297,8 @@ static void sampleLight_stepProcess(u8 cmdId, step_t *cmd)
 	}
 	else
 	{
+		levelInfo.targetLevel = ((s16)pLevel->curLevel - cmd->stepSize < ZCL_LEVEL_ATTR_MIN_LEVEL) ? ZCL_LEVEL_ATTR_MIN_LEVEL
+																								  : pLevel->curLevel - cmd->stepSize;
 		levelInfo.stepLevel256 = -levelInfo.stepLevel256;
 	}
 
@@ -302,6 +355,15 @@ status_t sampleLight_levelCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *c
 {
 	if (pAddrInfo->dstEp == SAMPLE_LIGHT_ENDPOINT)
 	{
+		// A new command takes over from a scene recall, an animation or the circadian schedule
+		lightTrans_stop();
+#ifdef ZCL_LIGHT_EXT
+		lightAnim_stop();
+#endif
+#if LIGHT_CIRCADIAN_ENABLE
+		lightCircadian_override();
+#endif
+
 		switch (cmdId)
 		{
 		case ZCL_CMD_LEVEL_MOVE_TO_LEVEL:
@@ -0,0 +1,275 @@
+/********************************************************************************************************
+ * @file    zcl_lightExtCb.c
+ *
+ * @brief   This is the source file for zcl_lightExtCb
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#if (__PROJECT_TL_DIMMABLE_LIGHT__)
+
+/**********************************************************************
+ * INCLUDES
+ */
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "zcl_lightExt.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightTransition.h"
+#include "sampleLightStream.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
+
+#ifdef ZCL_LIGHT_EXT
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      sampleLight_lightExtStateApply
+ *
+ * @brief   Apply on/off, level and one color group in a single step.
+ *          On/off takes effect at once, level and color move together
+ *          on the coordinated transition engine. Also plays animation keyframes.
+ *
+ * @param   cmd
+ *
+ * @return  None
+ */
+void sampleLight_lightExtStateApply(zcl_lightExt_setStateCmd_t *cmd)
+{
+	light_transTarget_t target;
+
+	memset((u8 *)&target, 0, sizeof(light_transTarget_t));
+
+#ifdef ZCL_ON_OFF
+	if (cmd->fields & LIGHT_EXT_FIELD_ON_OFF)
+	{
+		zcl_onOffAttr_t *pOnOff = zcl_onoffAttrGet();
+
+		if (cmd->onOff)
+		{
+			pOnOff->globalSceneControl = TRUE;
+			pOnOff->onOff = ZCL_ONOFF_STATUS_ON;
+		}
+		else
+		{
+			pOnOff->onOff = ZCL_ONOFF_STATUS_OFF;
+			pOnOff->onTime = 0;
+		}
+	}
+#endif
+
+#ifdef ZCL_LEVEL_CTRL
+	if (cmd->fields & LIGHT_EXT_FIELD_LEVEL)
+	{
+		target.fields |= LIGHT_TRANS_LEVEL;
+		target.level = cmd->level;
+		if (target.level < ZCL_LEVEL_ATTR_MIN_LEVEL)
+		{
+			target.level = ZCL_LEVEL_ATTR_MIN_LEVEL;
+		}
+		else if (target.level > ZCL_LEVEL_ATTR_MAX_LEVEL)
+		{
+			target.level = ZCL_LEVEL_ATTR_MAX_LEVEL;
+		}
+	}
+#endif
+
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+
+	if (cmd->fields & LIGHT_EXT_FIELD_XY)
+	{
+		target.fields |= LIGHT_TRANS_XY;
+		target.x = cmd->x;
+		target.y = cmd->y;
+	}
+	else if (cmd->fields & LIGHT_EXT_FIELD_HUE_SAT)
+	{
+		target.fields |= LIGHT_TRANS_HUE_SAT;
+		target.enhancedHue = cmd->enhancedHue;
+		target.saturation = (cmd->saturation > ZCL_COLOR_ATTR_SATURATION_MAX) ? ZCL_COLOR_ATTR_SATURATION_MAX : cmd->saturation;
+	}
+	else if (cmd->fields & LIGHT_EXT_FIELD_MIREDS)
+	{
+		target.fields |= LIGHT_TRANS_MIREDS;
+		target.mireds = cmd->mireds;
+		if (target.mireds < pColor->colorTempPhysicalMinMireds)
+		{
+			target.mireds = pColor->colorTempPhysicalMinMireds;
+		}
+		else if (target.mireds > pColor->colorTempPhysicalMaxMireds)
+		{
+			target.mireds = pColor->colorTempPhysicalMaxMireds;
+		}
+	}
+#endif
+
+	if (target.fields)
+	{
+		lightTrans_start(&target, cmd->transTime);
+	}
+	else
+	{
+		light_transitionStop();
+		light_fresh();
+	}
+
+#ifdef ZCL_SCENE
+	zcl_sceneAttr_t *pScene = zcl_sceneAttrGet();
+	pScene->sceneValid = 0;
+#endif
+}
+
+/*********************************************************************
+ * @fn      sampleLight_lightExtStreamProcess
+ *
+ * @brief   Hand the samples of a stream frame to the jitter buffer
+ *
+ * @param   cmd
+ *
+ * @return  None
+ */
+static void sampleLight_lightExtStreamProcess(zcl_lightExt_streamCmd_t *cmd)
+{
+	lightStream_put(cmd->flags, cmd->count, cmd->pSamples);
+}
+
+/*********************************************************************
+ * @fn      sampleLight_lightExtAnimUploadProcess
+ *
+ * @brief
+ *
+ * @param   cmd
+ *
+ * @return  status_t
+ */
+static status_t sampleLight_lightExtAnimUploadProcess(zcl_lightExt_animUploadCmd_t *cmd)
+{
+	return lightAnim_upload(cmd->index, cmd->total, cmd->loopCount, cmd->count, cmd->pFrames);
+}
+
+/*********************************************************************
+ * @fn      sampleLight_lightExtAnimControlProcess
+ *
+ * @brief
+ *
+ * @param   cmd
+ *
+ * @return  status_t
+ */
+static status_t sampleLight_lightExtAnimControlProcess(zcl_lightExt_animControlCmd_t *cmd)
+{
+	switch (cmd->action)
+	{
+	case LIGHT_EXT_ANIM_STOP:
+		lightAnim_stop();
+		break;
+	case LIGHT_EXT_ANIM_START:
+#if LIGHT_CIRCADIAN_ENABLE
+		lightCircadian_override();
+#endif
+		return lightAnim_start(cmd->seq);
+	case LIGHT_EXT_ANIM_PAUSE:
+		lightAnim_pause();
+		break;
+	case LIGHT_EXT_ANIM_RESUME:
+		lightAnim_resume();
+		break;
+	default:
+		return ZCL_STA_INVALID_VALUE;
+	}
+
+	return ZCL_STA_SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      sampleLight_lightExtCircadianSetProcess
+ *
+ * @brief
+ *
+ * @param   cmd
+ *
+ * @return  status_t
+ */
+static status_t sampleLight_lightExtCircadianSetProcess(zcl_lightExt_circadianSetCmd_t *cmd)
+{
+#if LIGHT_CIRCADIAN_ENABLE
+	return lightCircadian_set(cmd->enable, cmd->count, cmd->pPoints);
+#else
+	return ZCL_STA_UNSUP_MANU_CLUSTER_COMMAND;
+#endif
+}
+
+/*********************************************************************
+ * @fn      sampleLight_lightExtCb
+ *
+ * @brief   Handler for the manufacturer specific light extension commands.
+ *
+ * @param   pAddrInfo
+ * @param   cmdId - light extension cluster command id
+ * @param   cmdPayload
+ *
+ * @return  status_t
+ */
+status_t sampleLight_lightExtCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload)
+{
+	status_t status = ZCL_STA_SUCCESS;
+
+	if (pAddrInfo->dstEp == SAMPLE_LIGHT_ENDPOINT)
+	{
+		switch (cmdId)
+		{
+		case ZCL_CMD_LIGHT_EXT_SET_STATE:
+			lightAnim_stop();
+#if LIGHT_CIRCADIAN_ENABLE
+			lightCircadian_override();
+#endif
+			sampleLight_lightExtStateApply((zcl_lightExt_setStateCmd_t *)cmdPayload);
+			break;
+		case ZCL_CMD_LIGHT_EXT_STREAM:
+			lightAnim_stop();
+#if LIGHT_CIRCADIAN_ENABLE
+			lightCircadian_override();
+#endif
+			sampleLight_lightExtStreamProcess((zcl_lightExt_streamCmd_t *)cmdPayload);
+			break;
+		case ZCL_CMD_LIGHT_EXT_ANIM_UPLOAD:
+			status = sampleLight_lightExtAnimUploadProcess((zcl_lightExt_animUploadCmd_t *)cmdPayload);
+			break;
+		case ZCL_CMD_LIGHT_EXT_ANIM_CONTROL:
+			status = sampleLight_lightExtAnimControlProcess((zcl_lightExt_animControlCmd_t *)cmdPayload);
+			break;
+		case ZCL_CMD_LIGHT_EXT_CIRCADIAN_SET:
+			status = sampleLight_lightExtCircadianSetProcess((zcl_lightExt_circadianSetCmd_t *)cmdPayload);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return status;
+}
+
+#endif /* ZCL_LIGHT_EXT */
+
+#endif /* __PROJECT_TL_DIMMABLE_LIGHT__ */
@@ -31,6 +31,9 @@
 #include "zcl_include.h"
 #include "sampleLight.h"
 #include "sampleLightCtrl.h"
+#include "zcl_lightExt.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
 
 /**********************************************************************
  * LOCAL VARIABLES
@@ -85,6 +88,9 @@ void sampleLight_updateOnOff(void)
 void sampleLight_onoff(u8 cmd)
 {
 	zcl_onOffAttr_t *pOnOff = zcl_onoffAttrGet();
+#if LIGHT_CIRCADIAN_ENABLE
+	u8 prevOnOff = pOnOff->onOff;
+#endif
 
 	if (cmd == ZCL_CMD_ONOFF_ON)
 	{
@@ -120,6 +126,14 @@ void sampleLight_onoff(u8 cmd)
 		}
 	}
 
+#if LIGHT_CIRCADIAN_ENABLE
+	// Switching on ends a manual override, the light comes up at the scheduled color
+	if ((prevOnOff == ZCL_ONOFF_STATUS_OFF) && (pOnOff->onOff == ZCL_ONOFF_STATUS_ON))
+	{
+		lightCircadian_resume();
+	}
+#endif
+
 	light_fresh();
 
 #ifdef ZCL_SCENE
@@ -275,6 +289,11 @@ status_t sampleLight_onOffCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *c
 
 	if (pAddrInfo->dstEp == SAMPLE_LIGHT_ENDPOINT)
 	{
+		// A new command takes over from an animation
+#ifdef ZCL_LIGHT_EXT
+		lightAnim_stop();
+#endif
+
 		switch (cmdId)
 		{
 		case ZCL_CMD_ONOFF_ON:
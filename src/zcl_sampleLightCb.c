@@ -32,6 +32,11 @@
 #include "ota.h"
 #include "sampleLight.h"
 #include "sampleLightCtrl.h"
+#include "sampleLightNv.h"
+#include "sampleLightReport.h"
+#include "zcl_lightExt.h"
+#include "sampleLightCircadian.h"
+#include "sampleLightBrownOut.h"
 
 /**********************************************************************
  * LOCAL CONSTANTS
@@ -148,6 +153,23 @@ static void sampleLight_zclReadRspCmd(zclReadRspCmd_t *pReadRspCmd)
  */
 static void sampleLight_zclWriteReqCmd(u16 clusterId, zclWriteCmd_t *pWriteReqCmd)
 {
+#if LIGHT_CIRCADIAN_ENABLE
+	// Any write to the Time cluster resynchronizes the local clock
+	if (clusterId == ZCL_CLUSTER_GEN_TIME)
+	{
+		lightCircadian_timeSync();
+		return;
+	}
+#endif
+
+#if LIGHT_BROWN_OUT_ENABLE && (defined ZCL_LIGHT_EXT)
+	if (clusterId == ZCL_CLUSTER_LIGHT_EXT)
+	{
+		lightBrownOut_attrWritten();
+		return;
+	}
+#endif
+
 	// Check if we got the right clusters, if not return early
 	if (clusterId != ZCL_CLUSTER_GEN_ON_OFF && clusterId != ZCL_CLUSTER_GEN_LEVEL_CONTROL && clusterId != ZCL_CLUSTER_LIGHTING_COLOR_CONTROL)	{
 		return;
@@ -161,17 +183,17 @@ static void sampleLight_zclWriteReqCmd(u16 clusterId, zclWriteCmd_t *pWriteReqCm
 	{
 		if (clusterId == ZCL_CLUSTER_GEN_ON_OFF && attr[i].attrID == ZCL_ATTRID_START_UP_ONOFF)
 		{
-			zcl_onOffAttr_save();
+			lightNv_enqueue(LIGHT_NV_OP_STATE);
 			break;
 		}
 		else if (clusterId == ZCL_CLUSTER_LIGHTING_COLOR_CONTROL && attr[i].attrID == ZCL_ATTRID_START_UP_COLOR_TEMPERATURE_MIREDS)
 		{
-			zcl_colorCtrlAttr_save();
+			lightNv_enqueue(LIGHT_NV_OP_STATE);
 			break;
 		} 
 		else if (clusterId == ZCL_CLUSTER_GEN_LEVEL_CONTROL && attr[i].attrID == ZCL_ATTRID_LEVEL_START_UP_CURRENT_LEVEL)
 		{
-			zcl_levelAttr_save();
+			lightNv_enqueue(LIGHT_NV_OP_STATE);
 			break;
 		}
 	}
@@ -229,6 +251,9 @@ static void sampleLight_zclDfltRspCmd(zclDefaultRspCmd_t *pDftRspCmd)
 static void sampleLight_zclCfgReportCmd(zclCfgReportCmd_t *pCfgReportCmd)
 {
 	//    printf("sampleLight_zclCfgReportCmd\n");
+
+	/* re-arm the report deadline with the new intervals */
+	lightReport_cfgChanged();
 }
 
 /*********************************************************************
@@ -277,7 +302,7 @@ status_t sampleLight_basicCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *c
 	if (cmdId == ZCL_CMD_BASIC_RESET_FAC_DEFAULT)
 	{
 		// Reset all the attributes of all its clusters to factory defaults
-		// zcl_nv_attr_reset();
+		zcl_sampleLightAttrsReset();
 	}
 
 	return ZCL_STA_SUCCESS;
@@ -30,6 +30,202 @@
 #include "zb_api.h"
 #include "zcl_include.h"
 #include "sampleLight.h"
+#include "sampleLightTransition.h"
+#include "zcl_lightExt.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
+
+/**********************************************************************
+ * LOCAL CONSTANTS
+ */
+/* Color control extension set, attributes in the order defined by the ZCL spec.
+ * A set may be cut short after any attribute, the offsets tell how far it reaches.
+ */
+#define SCENE_COLOR_OFS_X 0
+#define SCENE_COLOR_OFS_Y 2
+#define SCENE_COLOR_OFS_ENHANCED_HUE 4
+#define SCENE_COLOR_OFS_SATURATION 6
+#define SCENE_COLOR_OFS_LOOP_ACTIVE 7
+#define SCENE_COLOR_OFS_LOOP_DIRECTION 8
+#define SCENE_COLOR_OFS_LOOP_TIME 9
+#define SCENE_COLOR_OFS_MIREDS 11
+#define SCENE_COLOR_OFS_ENHANCED_COLOR_MODE 13
+
+/* Shorter sets only come from Add Scene, the length hints at the mode */
+#define SCENE_COLOR_LEN_XY 4
+#define SCENE_COLOR_LEN_HUE_SAT 11
+#define SCENE_COLOR_LEN_FULL 14
+
+/* On/off set (4) + level set (4) + color set header (3) + full color set */
+#define SCENE_EXT_LEN_STORED (4 + 4 + 3 + SCENE_COLOR_LEN_FULL)
+
+#define SCENE_FIELD_ON_OFF BIT(0)
+#define SCENE_FIELD_LEVEL BIT(1)
+#define SCENE_FIELD_COLOR BIT(2)
+
+/* Store Scene writes every set in full, they must fit the SDK entry */
+typedef char sceneExtLenCheck_t[(SCENE_EXT_LEN_STORED <= ZCL_SCENE_EXT_FIELD_SIZE) ? 1 : -1];
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Values parsed from the extension field sets of a scene entry
+ */
+typedef struct
+{
+	u8 fields; // SCENE_FIELD_xxx present in the entry
+	u8 onOff;
+	u8 level;
+	u8 colorLen; // bytes present in the color set
+	u8 colorMode;
+	u8 enhancedColorMode;
+	u8 saturation;
+	u8 loopActive;
+	u8 loopDirection;
+	u16 loopTime;
+	u16 x;
+	u16 y;
+	u16 enhancedHue;
+	u16 mireds;
+} sampleLight_sceneFields_t;
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+/*********************************************************************
+ * @fn      sampleLight_sceneColorParse
+ *
+ * @brief   Reads a color control set. When EnhancedColorMode is not part of
+ *          the set the mode is taken from how far the set reaches, which is
+ *          how sampleLight_sceneStoreReqHandler truncates it.
+ *
+ * @param   pData  - set payload
+ * @param   len    - set payload length
+ * @param   pFields
+ *
+ * @return  None
+ */
+static void sampleLight_sceneColorParse(u8 *pData, u8 len, sampleLight_sceneFields_t *pFields)
+{
+	pFields->fields |= SCENE_FIELD_COLOR;
+	pFields->colorLen = len;
+
+	if (len >= SCENE_COLOR_OFS_Y + 2)
+	{
+		pFields->x = BUILD_U16(pData[SCENE_COLOR_OFS_X], pData[SCENE_COLOR_OFS_X + 1]);
+		pFields->y = BUILD_U16(pData[SCENE_COLOR_OFS_Y], pData[SCENE_COLOR_OFS_Y + 1]);
+	}
+	if (len >= SCENE_COLOR_OFS_ENHANCED_HUE + 2)
+	{
+		pFields->enhancedHue = BUILD_U16(pData[SCENE_COLOR_OFS_ENHANCED_HUE], pData[SCENE_COLOR_OFS_ENHANCED_HUE + 1]);
+	}
+	if (len >= SCENE_COLOR_OFS_SATURATION + 1)
+	{
+		pFields->saturation = pData[SCENE_COLOR_OFS_SATURATION];
+	}
+	if (len >= SCENE_COLOR_OFS_LOOP_DIRECTION + 1)
+	{
+		pFields->loopActive = pData[SCENE_COLOR_OFS_LOOP_ACTIVE];
+		pFields->loopDirection = pData[SCENE_COLOR_OFS_LOOP_DIRECTION];
+	}
+	if (len >= SCENE_COLOR_OFS_LOOP_TIME + 2)
+	{
+		pFields->loopTime = BUILD_U16(pData[SCENE_COLOR_OFS_LOOP_TIME], pData[SCENE_COLOR_OFS_LOOP_TIME + 1]);
+	}
+	if (len >= SCENE_COLOR_OFS_MIREDS + 2)
+	{
+		pFields->mireds = BUILD_U16(pData[SCENE_COLOR_OFS_MIREDS], pData[SCENE_COLOR_OFS_MIREDS + 1]);
+	}
+
+	if (len >= SCENE_COLOR_LEN_FULL)
+	{
+		pFields->enhancedColorMode = pData[SCENE_COLOR_OFS_ENHANCED_COLOR_MODE];
+	}
+	else if (len <= SCENE_COLOR_LEN_XY)
+	{
+		pFields->enhancedColorMode = ZCL_COLOR_MODE_CURRENT_X_Y;
+	}
+	else if (len <= SCENE_COLOR_LEN_HUE_SAT)
+	{
+		pFields->enhancedColorMode = ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION;
+	}
+	else
+	{
+		pFields->enhancedColorMode = ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS;
+	}
+
+	pFields->colorMode = (pFields->enhancedColorMode == ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION) ? ZCL_COLOR_MODE_CURRENT_HUE_SATURATION : pFields->enhancedColorMode;
+}
+#endif
+
+/*********************************************************************
+ * @fn      sampleLight_sceneFieldsParse
+ *
+ * @brief   Walks the extension field sets of a scene entry by cluster id
+ *          and length, so sets added by a controller in any order or
+ *          shortened per the spec are handled as well as our own.
+ *
+ * @param   pScene
+ * @param   pFields - parsed values
+ *
+ * @return  None
+ */
+static void sampleLight_sceneFieldsParse(zcl_sceneEntry_t *pScene, sampleLight_sceneFields_t *pFields)
+{
+	u8 ofs = 0;
+
+	memset((u8 *)pFields, 0, sizeof(sampleLight_sceneFields_t));
+
+	while (ofs + 3 <= pScene->extFieldLen)
+	{
+		u16 clusterId = BUILD_U16(pScene->extField[ofs], pScene->extField[ofs + 1]);
+		u8 len = pScene->extField[ofs + 2];
+		u8 *pData = &pScene->extField[ofs + 3];
+
+		if (ofs + 3 + len > pScene->extFieldLen)
+		{
+			break;
+		}
+
+		switch (clusterId)
+		{
+#ifdef ZCL_ON_OFF
+		case ZCL_CLUSTER_GEN_ON_OFF:
+			if (len >= 1)
+			{
+				pFields->fields |= SCENE_FIELD_ON_OFF;
+				pFields->onOff = pData[0];
+			}
+			break;
+#endif
+#ifdef ZCL_LEVEL_CTRL
+		case ZCL_CLUSTER_GEN_LEVEL_CONTROL:
+			if (len >= 1)
+			{
+				pFields->fields |= SCENE_FIELD_LEVEL;
+				pFields->level = pData[0];
+			}
+			break;
+#endif
+#ifdef ZCL_LIGHT_COLOR_CONTROL
+		case ZCL_CLUSTER_LIGHTING_COLOR_CONTROL:
+			if (len >= SCENE_COLOR_LEN_XY)
+			{
+				sampleLight_sceneColorParse(pData, len, pFields);
+			}
+			break;
+#endif
+		default:
+			break;
+		}
+
+		ofs += 3 + len;
+	}
+}
 
 /*********************************************************************
  * @fn      sampleLight_sceneRecallReqHandler
@@ -43,56 +239,91 @@
  */
 static void sampleLight_sceneRecallReqHandler(zclIncomingAddrInfo_t *pAddrInfo, zcl_sceneEntry_t *pScene)
 {
-	u8 extLen = 0;
+	sampleLight_sceneFields_t fields;
+	light_transTarget_t target;
+
+	sampleLight_sceneFieldsParse(pScene, &fields);
+	memset((u8 *)&target, 0, sizeof(light_transTarget_t));
+
+#ifdef ZCL_LIGHT_EXT
+	lightAnim_stop();
+#endif
+#if LIGHT_CIRCADIAN_ENABLE
+	lightCircadian_override();
+#endif
 
 #ifdef ZCL_ON_OFF
-	zcl_onOffAttr_t *pOnOff = zcl_onoffAttrGet();
+	if (fields.fields & SCENE_FIELD_ON_OFF)
+	{
+		zcl_onOffAttr_t *pOnOff = zcl_onoffAttrGet();
 
-	pOnOff->onOff = pScene->extField[extLen + 3];
-	extLen += 4;
+		pOnOff->onOff = fields.onOff;
+	}
 #endif
 
 #ifdef ZCL_LEVEL_CTRL
-	u8 level = pScene->extField[extLen + 3];
-	extLen += 4;
+	if (fields.fields & SCENE_FIELD_LEVEL)
+	{
+		target.fields |= LIGHT_TRANS_LEVEL;
+		target.level = fields.level;
+	}
 #endif
 
 #ifdef ZCL_LIGHT_COLOR_CONTROL
-	u8 colorMode = pScene->extField[extLen + 3];
-	u8 hue = pScene->extField[extLen + 4];
-	u8 saturation = pScene->extField[extLen + 5];
-	u16 colorTemperatureMireds = BUILD_U16(pScene->extField[extLen + 6], pScene->extField[extLen + 7]);
-	extLen += 8;
-#endif
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+	bool loopStart = FALSE;
 
-#ifdef ZCL_LEVEL_CTRL
-	moveToLvl_t moveToLevel;
-	moveToLevel.level = level;
-	moveToLevel.transitionTime = pScene->transTime;
-	moveToLevel.optPresent = 0;
+	if (fields.fields & SCENE_FIELD_COLOR)
+	{
+		if (fields.colorLen > SCENE_COLOR_OFS_LOOP_DIRECTION)
+		{
+			pColor->colorLoopDirection = fields.loopDirection;
+		}
+		if (fields.colorLen >= SCENE_COLOR_OFS_LOOP_TIME + 2)
+		{
+			pColor->colorLoopTime = fields.loopTime;
+		}
+		loopStart = (fields.colorLen > SCENE_COLOR_OFS_LOOP_ACTIVE) && fields.loopActive;
 
-	sampleLight_levelCb(pAddrInfo, ZCL_CMD_LEVEL_MOVE_TO_LEVEL, &moveToLevel);
+		if (fields.enhancedColorMode == ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS)
+		{
+			target.fields |= LIGHT_TRANS_MIREDS;
+			target.mireds = fields.mireds;
+		}
+		else if (fields.enhancedColorMode == ZCL_COLOR_MODE_CURRENT_X_Y)
+		{
+			target.fields |= LIGHT_TRANS_XY;
+			target.x = fields.x;
+			target.y = fields.y;
+		}
+		else if (!loopStart)
+		{
+			// A looping scene gets its hue from the color loop
+			target.fields |= LIGHT_TRANS_HUE_SAT;
+			target.enhancedHue = fields.enhancedHue;
+			target.saturation = fields.saturation;
+		}
+	}
 #endif
 
+	/* Scene transition time is in seconds plus an optional tenths part,
+	 * anything above 6553 s is clamped to the longest 1/10 s transition.
+	 */
+	u32 transTime = (u32)pScene->transTime * 10 + pScene->transTime100ms;
+
+	lightTrans_start(&target, (transTime > 0xFFFF) ? 0xFFFF : (u16)transTime);
+
 #ifdef ZCL_LIGHT_COLOR_CONTROL
-	if (colorMode == ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS)
+	if (loopStart)
 	{
-		zcl_colorCtrlMoveToColorTemperatureCmd_t move2ColorTemp;
-		move2ColorTemp.colorTemperature = colorTemperatureMireds;
-		move2ColorTemp.transitionTime = pScene->transTime;
-		move2ColorTemp.optPresent = 0;
+		zcl_colorCtrlColorLoopSetCmd_t loopSet;
 
-		sampleLight_colorCtrlCb(pAddrInfo, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_COLOR_TEMPERATURE, &move2ColorTemp);
-	}
-	else
-	{
-		zcl_colorCtrlMoveToHueAndSaturationCmd_t move2HueAndSat;
-		move2HueAndSat.hue = hue;
-		move2HueAndSat.saturation = saturation;
-		move2HueAndSat.transitionTime = pScene->transTime;
-		move2HueAndSat.optPresent = 0;
+		memset((u8 *)&loopSet, 0, sizeof(zcl_colorCtrlColorLoopSetCmd_t));
+		loopSet.updateFlags.bits.action = 1;
+		loopSet.action = COLOR_LOOP_SET_ACTION_FROM_ENHANCED_CURRENT_HUE;
 
-		sampleLight_colorCtrlCb(pAddrInfo, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_HUE_AND_SATURATION, &move2HueAndSat);
+		pColor->currentSaturation = fields.saturation;
+		sampleLight_colorCtrlCb(pAddrInfo, ZCL_CMD_LIGHT_COLOR_CONTROL_COLOR_LOOP_SET, &loopSet);
 	}
 #endif
 }
@@ -101,6 +332,7 @@ static void sampleLight_sceneRecallReqHandler(zclIncomingAddrInfo_t *pAddrInfo,
  * @fn      sampleLight_sceneStoreReqHandler
  *
  * @brief   Handler for ZCL scene store command. This function will set scene attribute first.
+ *          The color set is always written in full, SCENE_EXT_LEN_STORED checks it fits.
  *
  * @param   pApsdeInd
  * @param   pScene
@@ -132,15 +364,32 @@ static void sampleLight_sceneStoreReqHandler(zcl_sceneEntry_t *pScene)
 
 #ifdef ZCL_LIGHT_COLOR_CONTROL
 	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+	u8 colorSet[SCENE_COLOR_LEN_FULL];
 
 	pScene->extField[extLen++] = LO_UINT16(ZCL_CLUSTER_LIGHTING_COLOR_CONTROL);
 	pScene->extField[extLen++] = HI_UINT16(ZCL_CLUSTER_LIGHTING_COLOR_CONTROL);
-	pScene->extField[extLen++] = 5;
-	pScene->extField[extLen++] = pColor->colorMode;
-	pScene->extField[extLen++] = pColor->currentHue;
-	pScene->extField[extLen++] = pColor->currentSaturation;
-	pScene->extField[extLen++] = LO_UINT16(pColor->colorTemperatureMireds);
-	pScene->extField[extLen++] = HI_UINT16(pColor->colorTemperatureMireds);
+	pScene->extField[extLen++] = SCENE_COLOR_LEN_FULL;
+
+	/* A scene stored from plain hue mode keeps its hue in the enhanced field */
+	u16 enhancedHue = (pColor->enhancedColorMode == ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION) ? pColor->enhancedCurrentHue : ((u16)pColor->currentHue << 8);
+
+	colorSet[SCENE_COLOR_OFS_X] = LO_UINT16(pColor->currentX);
+	colorSet[SCENE_COLOR_OFS_X + 1] = HI_UINT16(pColor->currentX);
+	colorSet[SCENE_COLOR_OFS_Y] = LO_UINT16(pColor->currentY);
+	colorSet[SCENE_COLOR_OFS_Y + 1] = HI_UINT16(pColor->currentY);
+	colorSet[SCENE_COLOR_OFS_ENHANCED_HUE] = LO_UINT16(enhancedHue);
+	colorSet[SCENE_COLOR_OFS_ENHANCED_HUE + 1] = HI_UINT16(enhancedHue);
+	colorSet[SCENE_COLOR_OFS_SATURATION] = pColor->currentSaturation;
+	colorSet[SCENE_COLOR_OFS_LOOP_ACTIVE] = pColor->colorLoopActive;
+	colorSet[SCENE_COLOR_OFS_LOOP_DIRECTION] = pColor->colorLoopDirection;
+	colorSet[SCENE_COLOR_OFS_LOOP_TIME] = LO_UINT16(pColor->colorLoopTime);
+	colorSet[SCENE_COLOR_OFS_LOOP_TIME + 1] = HI_UINT16(pColor->colorLoopTime);
+	colorSet[SCENE_COLOR_OFS_MIREDS] = LO_UINT16(pColor->colorTemperatureMireds);
+	colorSet[SCENE_COLOR_OFS_MIREDS + 1] = HI_UINT16(pColor->colorTemperatureMireds);
+	colorSet[SCENE_COLOR_OFS_ENHANCED_COLOR_MODE] = pColor->enhancedColorMode;
+
+	memcpy(&pScene->extField[extLen], colorSet, SCENE_COLOR_LEN_FULL);
+	extLen += SCENE_COLOR_LEN_FULL;
 #endif
 
 	pScene->extFieldLen = extLen;
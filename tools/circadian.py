@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+
+# Encoder and host simulation for the circadian schedule
+# (src/sampleLightCircadian.c). "encode" turns a JSON table into a
+# Circadian Set frame of the light extension cluster, printed as hex.
+# "simulate" runs a day on a simulated clock the way the light does: the
+# Time attribute is synced once, the local time is derived from the time
+# zone and DST attributes, and the schedule is sampled every step.
+#
+# Table format, local time "HH:MM", level 0 or missing leaves the level alone:
+#   {"enable": true, "points": [
+#       {"time": "06:30", "mireds": 370, "level": 120},
+#       {"time": "12:00", "mireds": 200, "level": 254},
+#       {"time": "21:00", "mireds": 454, "level": 80}]}
+
+import argparse
+import json
+import struct
+
+from light_cmd import MANUFACTURER_CODE_TELINK, zcl_frame
+
+CMD_CIRCADIAN_SET = 0x04
+
+# sync with sampleLightCircadian.h
+POINT_MAX = 8
+STEP_S = 60
+FADE_TIME = 20
+DAY_S = 86400
+
+
+def load(path):
+    with open(path) as f:
+        table = json.load(f)
+    points = []
+    for point in table['points']:
+        hours, minutes = point['time'].split(':')
+        points.append((int(hours) * 60 + int(minutes), point['mireds'], point.get('level', 0)))
+    assert 0 < len(points) <= POINT_MAX, "1..%d points" % POINT_MAX
+    return bool(table.get('enable', True)), sorted(points)
+
+
+def cdiv(a, b):
+    """C integer division, truncating toward zero."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def interp(points, sec_of_day):
+    """Same arithmetic as lightCircadian_interp."""
+    prev, nxt = points[-1], points[0]
+    for i, point in enumerate(points):
+        if point[0] * 60 > sec_of_day:
+            nxt, prev = point, points[i - 1]
+            break
+
+    span = (nxt[0] * 60 + DAY_S - prev[0] * 60) % DAY_S
+    pos = (sec_of_day + DAY_S - prev[0] * 60) % DAY_S
+    if span == 0:
+        return prev[1], prev[2]
+
+    level = prev[2] + cdiv((nxt[2] - prev[2]) * pos, span) if prev[2] and nxt[2] else prev[2]
+    return prev[1] + cdiv((nxt[1] - prev[1]) * pos, span), level
+
+
+def encode(args):
+    enable, points = load(args.table)
+    payload = struct.pack('<BB', 1 if enable else 0, len(points))
+    for minute, mireds, level in points:
+        payload += struct.pack('<HHB', minute, mireds, level)
+    return zcl_frame(CMD_CIRCADIAN_SET, payload, args.seq, False, args.manufacturer)
+
+
+def simulate(args):
+    _, points = load(args.table)
+
+    # UTC time written by the coordinator so that the local day starts at 00:00
+    time_zone = args.tz * 3600
+    dst_shift = 3600 if args.dst else 0
+    sync = args.day * DAY_S - time_zone - dst_shift
+
+    prev = None
+    worst = (0, 0, 0)
+    print(" local  mireds level")
+    for t in range(0, DAY_S, STEP_S):
+        utc = sync + t
+        local = (utc + time_zone + dst_shift) % DAY_S
+        mireds, level = interp(points, local)
+        if t % (args.every * 60) == 0:
+            print(" %02d:%02d  %6d %5s" % (local // 3600, local // 60 % 60, mireds, level or '-'))
+        if prev is not None:
+            step_m, step_l = abs(mireds - prev[0]), abs(level - prev[1])
+            if (step_m, step_l) > worst[1:]:
+                worst = (local, step_m, step_l)
+        prev = (mireds, level)
+
+    print("largest step %d mireds / %d level at %02d:%02d, each faded over %.1f s" % (
+        worst[1], worst[2], worst[0] // 3600, worst[0] // 60 % 60, FADE_TIME / 10))
+
+
+def main(args):
+    if args.command == 'encode':
+        print(encode(args).hex())
+    else:
+        simulate(args)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('command', choices=('encode', 'simulate'))
+    parser.add_argument("-t", '--table', required=True, help="JSON schedule table")
+    parser.add_argument('--tz', type=int, default=0, help="time zone in hours, for simulate")
+    parser.add_argument('--dst', action='store_true', help="daylight saving in effect, for simulate")
+    parser.add_argument('--day', type=int, default=9000, help="days since 2000-01-01, for simulate")
+    parser.add_argument('--every', type=int, default=30, help="print every N minutes, for simulate")
+    parser.add_argument('--seq', type=int, default=0, help="ZCL sequence number")
+    parser.add_argument('--manufacturer', type=lambda v: int(v, 0), default=MANUFACTURER_CODE_TELINK)
+    _args = parser.parse_args()
+    main(_args)
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+
+# Encoder for the keyframe animation commands of the light extension cluster
+# (src/sampleLightAnim.c). "upload" turns a JSON program into one or more
+# Anim Upload frames, "start"/"stop"/"pause"/"resume" print an Anim Control
+# frame, all as hex, one frame per line.
+#
+# Program format, times in 1/10 s, one color group per keyframe:
+#   {"loop": 0, "frames": [
+#       {"on": true, "level": 254, "mireds": 370, "transition": 2, "hold": 1},
+#       {"level": 120, "transition": 3},
+#       {"xy": [20000, 21000], "transition": 10, "hold": 20}]}
+
+import argparse
+import json
+import struct
+
+from light_cmd import (FIELD_HUE_SAT, FIELD_LEVEL, FIELD_MIREDS, FIELD_ON_OFF, FIELD_XY,
+                       MANUFACTURER_CODE_TELINK, SET_STATE, zcl_frame)
+
+CMD_ANIM_UPLOAD = 0x02
+CMD_ANIM_CONTROL = 0x03
+
+ACTIONS = {'stop': 0, 'start': 1, 'pause': 2, 'resume': 3}
+
+# sync with sampleLightAnim.h
+FRAME_MAX = 16
+
+
+def keyframe(frame):
+    fields = 0
+    if 'on' in frame:
+        fields |= FIELD_ON_OFF
+    if 'level' in frame:
+        fields |= FIELD_LEVEL
+    if 'xy' in frame:
+        fields |= FIELD_XY
+    elif 'hue' in frame:
+        fields |= FIELD_HUE_SAT
+    elif 'mireds' in frame:
+        fields |= FIELD_MIREDS
+
+    x, y = frame.get('xy', (0, 0))
+    hue, sat = frame.get('hue', (0, 0))
+    state = SET_STATE.pack(fields, 1 if frame.get('on') else 0, frame.get('level', 0), x, y, hue, sat,
+                           frame.get('mireds', 0), frame.get('transition', 0))
+    return state + struct.pack('<H', frame.get('hold', 0))
+
+
+def upload(args):
+    with open(args.program) as f:
+        program = json.load(f)
+    frames = [keyframe(frame) for frame in program['frames']]
+    assert 0 < len(frames) <= FRAME_MAX, "1..%d keyframes" % FRAME_MAX
+
+    out = []
+    for index in range(0, len(frames), args.per_frame):
+        chunk = frames[index:index + args.per_frame]
+        payload = struct.pack('<BBBB', index, len(frames), program.get('loop', 0), len(chunk)) + b''.join(chunk)
+        out.append(zcl_frame(CMD_ANIM_UPLOAD, payload, (args.seq + len(out)) & 0xff, False, args.manufacturer))
+    return out
+
+
+def main(args):
+    if args.command == 'upload':
+        frames = upload(args)
+    else:
+        payload = struct.pack('<BB', ACTIONS[args.command], args.keyframe)
+        frames = [zcl_frame(CMD_ANIM_CONTROL, payload, args.seq, args.no_default_rsp, args.manufacturer)]
+    for frame in frames:
+        print(frame.hex())
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('command', choices=['upload'] + list(ACTIONS))
+    parser.add_argument("-p", '--program', help="JSON keyframe program, for upload")
+    parser.add_argument("-n", '--per-frame', type=int, default=4, help="keyframes per upload frame")
+    parser.add_argument("-k", '--keyframe', type=int, default=0, help="keyframe sequence number to start from")
+    parser.add_argument('--seq', type=int, default=0, help="ZCL sequence number")
+    parser.add_argument('--manufacturer', type=lambda v: int(v, 0), default=MANUFACTURER_CODE_TELINK)
+    parser.add_argument('--no-default-rsp', action='store_true', help="for groupcast control frames")
+    _args = parser.parse_args()
+    main(_args)
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+
+# Encoder for the manufacturer specific light extension cluster
+# (src/custom_zcl/zcl_lightExt.h). Prints the ZCL frame as hex so it can be
+# pasted into a ZCL sniffer/test tool, or only the payload with --payload.
+#
+#   light_cmd.py --on --level 200 --mireds 300 -t 20
+
+import argparse
+import struct
+
+CLUSTER_LIGHT_EXT = 0xFC01
+MANUFACTURER_CODE_TELINK = 0x124f  # sync with version_cfg.h
+
+CMD_SET_STATE = 0x00
+
+FIELD_ON_OFF = 1 << 0
+FIELD_LEVEL = 1 << 1
+FIELD_XY = 1 << 2
+FIELD_HUE_SAT = 1 << 3
+FIELD_MIREDS = 1 << 4
+
+# cluster specific, manufacturer specific, client to server
+FRAME_CTRL = 0x01 | 0x04
+FRAME_CTRL_DISABLE_DEFAULT_RSP = 0x10
+
+# fields, onOff, level, x, y, enhancedHue, saturation, mireds, transTime
+SET_STATE = struct.Struct('<BBBHHHBHH')
+
+
+def zcl_frame(cmd, payload, seq, disable_default_rsp, manufacturer):
+    frame_ctrl = FRAME_CTRL
+    if disable_default_rsp:
+        frame_ctrl |= FRAME_CTRL_DISABLE_DEFAULT_RSP
+    return struct.pack('<BHBB', frame_ctrl, manufacturer, seq, cmd) + payload
+
+
+def set_state(args):
+    fields = 0
+    on_off = 0
+    if args.on or args.off:
+        fields |= FIELD_ON_OFF
+        on_off = 1 if args.on else 0
+    if args.level is not None:
+        fields |= FIELD_LEVEL
+    # same precedence as the firmware: xy, then hue/sat, then mireds
+    if args.xy is not None:
+        fields |= FIELD_XY
+    elif args.hue is not None:
+        fields |= FIELD_HUE_SAT
+    elif args.mireds is not None:
+        fields |= FIELD_MIREDS
+
+    x, y = args.xy or (0, 0)
+    hue, sat = args.hue or (0, 0)
+    return SET_STATE.pack(fields, on_off, args.level or 0, x, y, hue, sat, args.mireds or 0, args.transition)
+
+
+def main(args):
+    payload = set_state(args)
+    if args.payload:
+        print(payload.hex())
+        return
+    frame = zcl_frame(CMD_SET_STATE, payload, args.seq, args.no_default_rsp, args.manufacturer)
+    print("cluster 0x%04x manufacturer 0x%04x" % (CLUSTER_LIGHT_EXT, args.manufacturer))
+    print(frame.hex())
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    on_off = parser.add_mutually_exclusive_group()
+    on_off.add_argument('--on', action='store_true')
+    on_off.add_argument('--off', action='store_true')
+    parser.add_argument("-l", '--level', type=int, choices=range(0, 256), metavar="0..255")
+    color = parser.add_mutually_exclusive_group()
+    color.add_argument('--xy', type=lambda v: int(v, 0), nargs=2, metavar=("X", "Y"))
+    color.add_argument('--hue', type=lambda v: int(v, 0), nargs=2, metavar=("ENHANCED_HUE", "SATURATION"))
+    color.add_argument('--mireds', type=int)
+    parser.add_argument("-t", '--transition', type=int, default=0, help="transition time in 1/10 s")
+    parser.add_argument('--seq', type=int, default=0, help="ZCL sequence number")
+    parser.add_argument('--manufacturer', type=lambda v: int(v, 0), default=MANUFACTURER_CODE_TELINK)
+    parser.add_argument('--no-default-rsp', action='store_true')
+    parser.add_argument('--payload', action='store_true', help="print only the command payload")
+    _args = parser.parse_args()
+    main(_args)
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+
+# Stand-in sender and host simulation for the light extension stream
+# command (ZCL_CMD_LIGHT_EXT_STREAM, src/sampleLightStream.c).
+#
+# "frames" prints one ZCL frame per line as "<send time ms> <hex>", ready to
+# be replayed by a coordinator script. "simulate" pushes the same frames
+# through a model of the on-device jitter buffer with random network delay
+# and compares how much of the arrival jitter is left on the light.
+
+import argparse
+import colorsys
+import math
+import random
+import statistics
+import struct
+
+CLUSTER_LIGHT_EXT = 0xFC01
+MANUFACTURER_CODE_TELINK = 0x124f  # sync with version_cfg.h
+CMD_STREAM = 0x01
+
+FLAG_CCT = 1 << 0
+
+# cluster specific, manufacturer specific, client to server, no default response
+FRAME_CTRL = 0x01 | 0x04 | 0x10
+
+# sync with sampleLightStream.h
+STREAM_INTERVAL = 20
+STREAM_BUF_SIZE = 16
+STREAM_DELAY_MS = 100
+STREAM_TIMEOUT_MS = 1000
+STREAM_DELAY_MAX_MS = 400
+
+
+def effect(t_ms, period_ms):
+    """Hue sweep, one turn per period. Returns R, G, B."""
+    r, g, b = colorsys.hsv_to_rgb((t_ms % period_ms) / period_ms, 1.0, 1.0)
+    return round(r * 255), round(g * 255), round(b * 255)
+
+
+def samples(args):
+    step = 1000.0 / args.rate
+    return [(round(i * step) & 0xffff, effect(i * step, args.period))
+            for i in range(int(args.duration * args.rate / 1000))]
+
+
+def frames(args):
+    """Group samples into frames, each sent when its last sample is due."""
+    out = []
+    all_samples = samples(args)
+    for i in range(0, len(all_samples), args.per_frame):
+        chunk = all_samples[i:i + args.per_frame]
+        send_ms = round((i + len(chunk) - 1) * 1000.0 / args.rate)
+        payload = struct.pack('<BB', 0, len(chunk))
+        for ts, (r, g, b) in chunk:
+            payload += struct.pack('<HBBB', ts, r, g, b)
+        seq = (i // args.per_frame) & 0xff
+        out.append((send_ms, chunk, struct.pack('<BHBB', FRAME_CTRL, MANUFACTURER_CODE_TELINK, seq, CMD_STREAM) + payload))
+    return out
+
+
+class JitterBuffer:
+    """Same algorithm as lightStream_put / lightStream_timerCb."""
+
+    def __init__(self):
+        self.buf = []
+        self.started = False
+        self.last_ts = 0
+        self.sender_ms = 0
+        self.offset = STREAM_DELAY_MS
+        self.late = 0
+        self.underruns = 0
+
+    def put(self, now, chunk):
+        if not self.started:
+            self.started = True
+            self.last_ts = chunk[0][0]
+        for ts, value in chunk:
+            delta = ((ts - self.last_ts + 0x8000) & 0xffff) - 0x8000
+            if self.buf and delta <= 0:
+                continue
+            self.last_ts = (self.last_ts + delta) & 0xffff
+            self.sender_ms += delta
+            due = self.sender_ms + self.offset
+            if now > due:
+                self.late += 1
+                self.offset += min(now - due, STREAM_DELAY_MAX_MS - self.offset)
+                due = now
+            elif self.offset > STREAM_DELAY_MS and due - now > STREAM_DELAY_MS:
+                self.offset -= 1
+                due -= 1
+            if len(self.buf) == STREAM_BUF_SIZE:
+                self.buf.pop(0)
+            self.buf.append((due, self.sender_ms, value))
+
+    def tick(self, now):
+        while len(self.buf) >= 2 and now >= self.buf[1][0]:
+            self.buf.pop(0)
+        if not self.buf or now < self.buf[0][0]:
+            return None
+        if len(self.buf) == 1:
+            self.underruns += 1
+            return self.buf[0][1], self.buf[0][2]
+        (a_due, a_ms, a_v), (b_due, b_ms, b_v) = self.buf[0], self.buf[1]
+        pos = (now - a_due) / (b_due - a_due)
+        return a_ms + pos * (b_ms - a_ms), tuple(int(x + (y - x) * pos) for x, y in zip(a_v, b_v))
+
+
+def simulate(args):
+    rnd = random.Random(args.seed)
+    arrivals = []
+    for send_ms, chunk, _ in frames(args):
+        if rnd.random() < args.loss:
+            continue
+        latency = args.latency + abs(rnd.gauss(0, args.jitter))
+        arrivals.append((send_ms + latency, send_ms, chunk))
+    arrivals.sort(key=lambda a: a[0])
+
+    jb = JitterBuffer()
+    start = arrivals[0][0]
+    arrival_delay = [arr - send for arr, send, _ in arrivals]
+    play_delay = []
+    error = []
+    i = 0
+    now = start
+    while i < len(arrivals) or jb.buf:
+        while i < len(arrivals) and arrivals[i][0] <= now:
+            jb.put(int(now - start), arrivals[i][2])
+            i += 1
+        out = jb.tick(int(now - start))
+        if out is not None:
+            sender_ms, value = out
+            # how far behind the sender timeline the light is showing
+            play_delay.append((now - start) - sender_ms)
+            ideal = effect(sender_ms, args.period)
+            error.append(math.sqrt(sum((a - b) ** 2 for a, b in zip(value, ideal)) / 3))
+        if i == len(arrivals) and len(jb.buf) <= 1:
+            break
+        now += STREAM_INTERVAL
+
+    print("%d samples/s, %d per frame, latency %g ms + |N(0, %g)| ms, loss %g" % (
+        args.rate, args.per_frame, args.latency, args.jitter, args.loss))
+    print("arrival jitter   %6.1f ms stdev, %6.1f ms spread" % (
+        statistics.pstdev(arrival_delay), max(arrival_delay) - min(arrival_delay)))
+    print("playout jitter   %6.1f ms stdev, %6.1f ms spread (render tick %d ms)" % (
+        statistics.pstdev(play_delay), max(play_delay) - min(play_delay), STREAM_INTERVAL))
+    print("playout delay    %6.1f ms final, %d late samples, %d underrun ticks" % (
+        jb.offset, jb.late, jb.underruns))
+    print("color error      %6.1f rms, %6.1f max (0..255 per channel)" % (
+        math.sqrt(statistics.mean(e * e for e in error)), max(error)))
+
+
+def main(args):
+    if args.command == 'frames':
+        for send_ms, _, frame in frames(args):
+            print("%d %s" % (send_ms, frame.hex()))
+    else:
+        simulate(args)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('command', choices=('frames', 'simulate'))
+    parser.add_argument("-r", '--rate', type=int, default=40, help="samples per second")
+    parser.add_argument("-f", '--per-frame', type=int, default=2, help="samples per frame")
+    parser.add_argument("-d", '--duration', type=int, default=10000, help="stream length in ms")
+    parser.add_argument('--period', type=int, default=4000, help="hue sweep period in ms")
+    parser.add_argument('--latency', type=float, default=15, help="base network latency in ms")
+    parser.add_argument('--jitter', type=float, default=25, help="network delay stdev in ms")
+    parser.add_argument('--loss', type=float, default=0.02, help="frame loss ratio")
+    parser.add_argument('--seed', type=int, default=1)
+    _args = parser.parse_args()
+    main(_args)
@@ -8,65 +8,94 @@ import struct
 OTA_MAGIC = b'\x5d\x02'
 
 
+def prepare_firmware(firmware):
+    """Same fixups as tl_check_fw.py, applied in memory."""
+    firmware = bytearray(firmware)
+    if firmware[6:8] != OTA_MAGIC:
+        # Ensure FW size is multiple of 16
+        padding = 16 - len(firmware) % 16
+        if padding < 16:
+            firmware += b'\xFF' * padding
+        # Fix FW length
+        firmware[0x18:0x1c] = (len(firmware) + 4).to_bytes(4, byteorder='little')
+        # Add magic constant
+        firmware[6:8] = OTA_MAGIC
+        # Add CRC
+        crc = binascii.crc32(firmware) ^ 0xffffffff
+        firmware += crc.to_bytes(4, byteorder='little')
+    return firmware
+
+
 def main(args):
     assert args.input_file != args.output
 
     with open(args.input_file, 'rb') as bin_file:
-        bin_file.seek(0, 0)
-        firmware = bytearray(bin_file.read(-1))
-        if firmware[6:8] != OTA_MAGIC:
-            # Ensure FW size is multiple of 16
-            padding = 16 - len(firmware) % 16
-            if padding < 16:
-                firmware += b'\xFF' * padding
-            # Fix FW length
-            firmware[0x18:0x1c] = (len(firmware) + 4).to_bytes(4, byteorder='little')
-            # Add magic constant
-            firmware[6:8] = OTA_MAGIC
-            # Add CRC
-            crc = binascii.crc32(firmware) ^ 0xffffffff
-            firmware += crc.to_bytes(4, byteorder='little')
+        firmware = prepare_firmware(bin_file.read(-1))
+
+    manufacturer_code = int.from_bytes(firmware[18:20], byteorder='little')
+    image_type = int.from_bytes(firmware[20:22], byteorder='little')
+    file_version = args.set_version or int.from_bytes(firmware[2:6], byteorder='little')
+
+    suffix = ''
+    full_len = len(firmware)
+    # imported here, the packers use prepare_firmware from this module
+    if args.base:
+        import ota_delta
+        with open(args.base, 'rb') as base_file:
+            base = prepare_firmware(base_file.read(-1))
+        firmware = ota_delta.make_delta(base, firmware, args.bank_size)
+        suffix = '-delta-{:08x}'.format(int.from_bytes(base[2:6], byteorder='little'))
+    elif args.compress:
+        import ota_lz
+        packed = ota_lz.make_lz(firmware, args.bank_size)
+        # the lamp spends extra time unpacking, only worth it when fewer blocks go over the air
+        if -(-len(packed) // args.block_size) < -(-full_len // args.block_size):
+            firmware = packed
+            suffix = '-lz'
+        else:
+            print("lz: %d bytes saves no %d byte block on the %d byte image, writing it raw" % (
+                len(packed), args.block_size, full_len))
+    if suffix:
+        print("%s: %d bytes instead of %d (%.1f%%)" % (
+            suffix[1:], len(firmware), full_len, 100.0 * len(firmware) / full_len))
 
-        ota_hdr_s = struct.Struct('<I5HIH32sI')
-        header_size = 56
-        firmware_len = len(firmware)
-        total_image_size = firmware_len + header_size + 6
-        manufacturer_code = int.from_bytes(firmware[18:20], byteorder='little')
-        image_type = int.from_bytes(firmware[20:22], byteorder='little')
-        file_version = args.set_version or int.from_bytes(firmware[2:6], byteorder='little')
-        ota_hdr = ota_hdr_s.pack(
-            0xbeef11e,
-            0x100,  # header version is 0x0100
-            header_size,
-            0,  # ota_ext_hdr_value if ota_ext_hdr else 0,
-            manufacturer_code,  # args.manufacturer,
-            image_type,  # args.image_type,
-            file_version,  # options.File_Version
-            args.ota_version,  # options.stack_version,
-            b'\x00' * 32,  # OTA_Header_String.encode(),
-            total_image_size,
-        )
-        # add chunk header: 0 - firmware type
-        ota_hdr += struct.pack('<HI', 0, firmware_len)
+    ota_hdr_s = struct.Struct('<I5HIH32sI')
+    header_size = 56
+    firmware_len = len(firmware)
+    total_image_size = firmware_len + header_size + 6
+    ota_hdr = ota_hdr_s.pack(
+        0xbeef11e,
+        0x100,  # header version is 0x0100
+        header_size,
+        0,  # ota_ext_hdr_value if ota_ext_hdr else 0,
+        manufacturer_code,  # args.manufacturer,
+        image_type,  # args.image_type,
+        file_version,  # options.File_Version
+        args.ota_version,  # options.stack_version,
+        b'\x00' * 32,  # OTA_Header_String.encode(),
+        total_image_size,
+    )
+    # add chunk header: 0 - firmware type
+    ota_hdr += struct.pack('<HI', 0, firmware_len)
 
-        out_filename = args.output
-        if not out_filename:
-            head, tail = os.path.split(args.input_file)
-            if args.output_title:
-                name = args.output_title
-            else:
-                name, _ = os.path.splitext(tail)
-            out_filename = os.path.join(head, '{:04x}-{:04x}-{:08x}-{}.zigbee'.format(
-                manufacturer_code,
-                image_type,
-                file_version,
-                name,
-            ))
-        with open(out_filename, 'wb') as output:
-            bin_file.seek(0, 0)
-            output.write(ota_hdr)
-            output.write(firmware)
-        print("%s was created with ZCL OTA Header." % out_filename)
+    out_filename = args.output
+    if not out_filename:
+        head, tail = os.path.split(args.input_file)
+        if args.output_title:
+            name = args.output_title
+        else:
+            name, _ = os.path.splitext(tail)
+        out_filename = os.path.join(head, '{:04x}-{:04x}-{:08x}-{}{}.zigbee'.format(
+            manufacturer_code,
+            image_type,
+            file_version,
+            name,
+            suffix,
+        ))
+    with open(out_filename, 'wb') as output:
+        output.write(ota_hdr)
+        output.write(firmware)
+    print("%s was created with ZCL OTA Header." % out_filename)
 
 
 if __name__ == '__main__':
@@ -77,5 +106,13 @@ if __name__ == '__main__':
     # sync with g_zcl_basicAttrs.stackVersion
     parser.add_argument("-s", '--ota-version', type=int, help="OTA stack version", default=2)
     parser.add_argument("-v", '--set-version', type=lambda x: int(x, 0), help="Override version from BIN")
+    # a delta image only upgrades lamps running exactly this BIN, serve it to those only
+    packed = parser.add_mutually_exclusive_group()
+    packed.add_argument("-b", '--base', help="make a delta image against this BIN")
+    packed.add_argument("-c", '--compress', action='store_true', help="make a compressed image")
+    parser.add_argument('--block-size', type=int, default=48,
+                        help="OTA image block payload size, --compress falls back to raw unless it saves blocks")
+    parser.add_argument('--bank-size', type=lambda x: int(x, 0), default=0x34000,
+                        help="standby bank size, FLASH_OTA_IMAGE_MAX_SIZE")
     _args = parser.parse_args()
     main(_args)
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+# Rough flash lifetime estimate for the light state storage.
+#
+# Both layouts spread writes evenly over their sectors, so lifetime is
+# reached when every sector has been erased --endurance times:
+#   lifetime = endurance * sectors * bytes_per_sector / bytes_written_per_day
+#
+# "nv" is the per-cluster storage used before the journal: every save wrote
+# the on/off, level and color items through the SDK NV module, each item
+# carrying its own header. "journal" is the append-only region at 0x74000
+# with one fixed-size slot per save and slot 0 of each sector reserved.
+
+import argparse
+
+SECONDS_PER_DAY = 24 * 60 * 60
+
+# sizeof zcl_nv_onOff_t, zcl_nv_level_t, zcl_nv_colorCtrl_t
+LEGACY_ITEMS = (2, 2, 4)
+
+
+def align(n, to):
+    return (n + to - 1) // to * to
+
+
+def lifetime_days(bytes_per_save, sectors, sector_size, saves_per_day, endurance):
+    bytes_per_day = bytes_per_save * saves_per_day
+    return endurance * sectors * sector_size / bytes_per_day
+
+
+def main(args):
+    saves_per_day = SECONDS_PER_DAY / args.interval
+
+    nv_bytes = sum(args.nv_item_overhead + align(size, 4) for size in LEGACY_ITEMS)
+    nv_days = lifetime_days(nv_bytes, args.nv_sectors, args.sector_size, saves_per_day, args.endurance)
+
+    slots = args.sector_size // args.slot_size - 1
+    journal_days = lifetime_days(args.slot_size, args.journal_sectors, slots * args.slot_size,
+                                 saves_per_day, args.endurance)
+
+    print("one save every %g s, %d saves/day, %d erase cycles per sector" % (
+        args.interval, saves_per_day, args.endurance))
+    print("%-8s %6s %8s %10s %12s" % ("layout", "B/save", "sectors", "erases/day", "lifetime"))
+    for name, per_save, sectors, days in (
+            ("nv", nv_bytes, args.nv_sectors, nv_days),
+            ("journal", args.slot_size, args.journal_sectors, journal_days)):
+        print("%-8s %6d %8d %10.1f %9.1f yr" % (
+            name, per_save, sectors, args.endurance / days, days / 365))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-i", '--interval', type=float, default=10, help="seconds between saves")
+    parser.add_argument("-e", '--endurance', type=int, default=100000, help="erase cycles per sector")
+    parser.add_argument('--sector-size', type=int, default=4096)
+    parser.add_argument('--slot-size', type=int, default=32, help="LIGHT_JOURNAL_SLOT_SIZE")
+    parser.add_argument('--journal-sectors', type=int, default=2, help="LIGHT_JOURNAL_SECTOR_NUM")
+    parser.add_argument('--nv-sectors', type=int, default=2, help="sectors of the SDK NV module in use")
+    parser.add_argument('--nv-item-overhead', type=int, default=16, help="SDK NV item header bytes")
+    _args = parser.parse_args()
+    main(_args)
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+
+# Delta OTA images (src/sampleLightOta.c). The patch rebuilds the new
+# firmware from the one the lamp is running with three operations: copy a
+# range of the running image, insert literal bytes, fill a run with one byte.
+#
+# make_ota.py --base old.bin new.bin wraps the container into a .zigbee file.
+# Run on its own, this script builds the container, replays it the way the
+# lamp does and prints the transfer saving:
+#
+#   ota_delta.py old.bin new.bin
+
+import argparse
+import struct
+
+from make_ota import prepare_firmware
+from ota_pack import (BANK_SIZE, DELTA_MAGIC, FW_SIZE_OFFSET, check_image, check_in_place, make_container,
+                      parse_container)
+
+OP_END = 0x00
+OP_COPY = 0x01
+OP_LITERAL = 0x02
+OP_FILL = 0x03
+
+KEY_LEN = 8
+MIN_COPY = 12  # a copy costs 7 bytes
+MIN_FILL = 6  # a fill costs 4 bytes
+MAX_LEN = 0xffff
+CANDIDATES = 16
+
+
+def match_len(base, base_pos, new, new_pos):
+    limit = min(len(base) - base_pos, len(new) - new_pos, MAX_LEN)
+    n = 0
+    while n + 64 <= limit and base[base_pos + n:base_pos + n + 64] == new[new_pos + n:new_pos + n + 64]:
+        n += 64
+    while n < limit and base[base_pos + n] == new[new_pos + n]:
+        n += 1
+    return n
+
+
+def diff(base, new):
+    index = {}
+    for pos in range(len(base) - KEY_LEN + 1):
+        positions = index.setdefault(bytes(base[pos:pos + KEY_LEN]), [])
+        if len(positions) < CANDIDATES:
+            positions.append(pos)
+
+    ops = bytearray()
+    literal = bytearray()
+
+    def flush_literal():
+        for i in range(0, len(literal), MAX_LEN):
+            chunk = literal[i:i + MAX_LEN]
+            ops.extend(struct.pack('<BH', OP_LITERAL, len(chunk)) + chunk)
+        literal.clear()
+
+    pos = 0
+    next_src = None
+    while pos < len(new):
+        best_src, best_len = None, 0
+        # unchanged code usually continues right after the previous copy
+        candidates = index.get(bytes(new[pos:pos + KEY_LEN]), [])
+        if next_src is not None:
+            candidates = [next_src] + candidates
+        for src in candidates:
+            n = match_len(base, src, new, pos)
+            if n > best_len:
+                best_src, best_len = src, n
+
+        run = 1
+        while pos + run < len(new) and run < MAX_LEN and new[pos + run] == new[pos]:
+            run += 1
+
+        if best_len >= MIN_COPY and best_len >= run:
+            flush_literal()
+            ops.extend(struct.pack('<BIH', OP_COPY, best_src, best_len))
+            pos += best_len
+            next_src = best_src + best_len
+        elif run >= MIN_FILL:
+            flush_literal()
+            ops.extend(struct.pack('<BHB', OP_FILL, run, new[pos]))
+            pos += run
+            next_src = None
+        else:
+            literal.append(new[pos])
+            pos += 1
+            if next_src is not None:
+                next_src += 1
+    flush_literal()
+    ops.append(OP_END)
+    return bytes(ops)
+
+
+def patch(base, ops):
+    """Same operations as lightOta_deltaRun. Returns the image and the unpack trace."""
+    new = bytearray()
+    trace = []
+    pos = 0
+    while True:
+        trace.append((len(new), pos))
+        op = ops[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            src, n = struct.unpack_from('<IH', ops, pos)
+            pos += 6
+            assert src + n <= len(base), "copy past the base image"
+            new += base[src:src + n]
+        elif op == OP_LITERAL:
+            n, = struct.unpack_from('<H', ops, pos)
+            new += ops[pos + 2:pos + 2 + n]
+            pos += 2 + n
+        elif op == OP_FILL:
+            n, value = struct.unpack_from('<HB', ops, pos)
+            new += bytes([value]) * n
+            pos += 3
+        else:
+            raise AssertionError("bad op 0x%02x" % op)
+    return bytes(new), trace
+
+
+def make_delta(base, new, bank_size=BANK_SIZE):
+    ops = diff(base, new)
+    _, trace = patch(base, ops)
+    error = check_in_place(len(new), len(ops), trace, bank_size)
+    if error:
+        raise SystemExit("%s, send the full image" % error)
+    return make_container(DELTA_MAGIC, new, ops, base, bank_size)
+
+
+def apply(base, container):
+    """Replay of lightOta_imageFinalize, raises on anything the lamp would reject."""
+    magic, base_size, base_crc, new_size, new_crc, ops = parse_container(container)
+    assert magic == DELTA_MAGIC, "not a delta container"
+    assert base_size == int.from_bytes(base[FW_SIZE_OFFSET:FW_SIZE_OFFSET + 4], 'little'), "base size"
+    assert base_crc == int.from_bytes(base[base_size - 4:base_size], 'little'), "base crc"
+
+    new, _ = patch(base, ops)
+    check_image(new, new_size, new_crc)
+    return new
+
+
+def main(args):
+    with open(args.base, 'rb') as f:
+        base = prepare_firmware(f.read(-1))
+    with open(args.new, 'rb') as f:
+        new = prepare_firmware(f.read(-1))
+
+    container = make_delta(base, new, args.bank_size)
+    assert apply(base, container) == new
+
+    blocks_full = -(-len(new) // args.block_size)
+    blocks_delta = -(-len(container) // args.block_size)
+    print("full image  %7d bytes, %5d blocks" % (len(new), blocks_full))
+    print("delta image %7d bytes, %5d blocks (%.1f%%)" % (
+        len(container), blocks_delta, 100.0 * len(container) / len(new)))
+    print("rebuilt image verified against crc 0x%08x" % int.from_bytes(new[-4:], 'little'))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('base', help="BIN the lamps are running")
+    parser.add_argument('new', help="BIN to upgrade to")
+    parser.add_argument('--bank-size', type=lambda x: int(x, 0), default=BANK_SIZE,
+                        help="standby bank size, FLASH_OTA_IMAGE_MAX_SIZE")
+    parser.add_argument('--block-size', type=int, default=48, help="OTA image block payload size")
+    _args = parser.parse_args()
+    main(_args)
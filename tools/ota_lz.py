@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+
+# Compressed OTA images (src/sampleLightOta.c). An LZSS coder with a 4 KiB
+# window: the lamp reads matches back from the image it has already written,
+# so it needs no window in RAM.
+#
+# make_ota.py --compress new.bin wraps the container into a .zigbee file.
+# Run on its own, this script compresses a BIN, unpacks it the way the lamp
+# does, and models the end-to-end upgrade time against the raw image:
+#
+#   ota_lz.py glc002.bin --block-ms 60
+
+import argparse
+
+from make_ota import prepare_firmware
+from ota_pack import (BANK_SIZE, LZ_MAGIC, PAGE_SIZE, SECTOR_SIZE, align, check_image, check_in_place,
+                      make_container, moved_offset, parse_container)
+
+# sync with sampleLightOta.h
+WINDOW = 4096
+MIN_MATCH = 3
+LEN_EXT = 15
+MAX_MATCH = MIN_MATCH + LEN_EXT + 255
+
+CHAIN = 32
+
+
+def compress(data):
+    out = bytearray()
+    chains = {}
+    flags_pos = 0
+    bit = 8
+    pos = 0
+
+    def insert(p):
+        if p + MIN_MATCH <= len(data):
+            chain = chains.setdefault(bytes(data[p:p + MIN_MATCH]), [])
+            chain.append(p)
+            if len(chain) > CHAIN:
+                del chain[0]
+
+    while pos < len(data):
+        if bit == 8:
+            flags_pos = len(out)
+            out.append(0)
+            bit = 0
+
+        best_len, best_dist = 0, 0
+        limit = min(MAX_MATCH, len(data) - pos)
+        for cand in reversed(chains.get(bytes(data[pos:pos + MIN_MATCH]), [])):
+            dist = pos - cand
+            if dist > WINDOW:
+                break
+            n = 0
+            while n < limit and data[cand + n] == data[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_dist = n, dist
+                if n == limit:
+                    break
+
+        if best_len >= MIN_MATCH:
+            code = best_len - MIN_MATCH
+            token = (min(code, LEN_EXT) << 12) | (best_dist - 1)
+            out += token.to_bytes(2, 'little')
+            if code >= LEN_EXT:
+                out.append(code - LEN_EXT)
+            out[flags_pos] |= 1 << bit
+            for p in range(pos, pos + best_len):
+                insert(p)
+            pos += best_len
+        else:
+            out.append(data[pos])
+            insert(pos)
+            pos += 1
+        bit += 1
+    return bytes(out)
+
+
+def decompress(packed, size):
+    """Same decoding as lightOta_lzRun. Returns the image and the unpack trace."""
+    out = bytearray()
+    trace = []
+    pos = 0
+    while len(out) < size:
+        trace.append((len(out), pos))
+        flags = packed[pos]
+        pos += 1
+        for bit in range(8):
+            if len(out) >= size:
+                break
+            trace.append((len(out), pos))
+            if flags & (1 << bit):
+                token = int.from_bytes(packed[pos:pos + 2], 'little')
+                pos += 2
+                dist = (token & (WINDOW - 1)) + 1
+                n = (token >> 12) + MIN_MATCH
+                if token >> 12 == LEN_EXT:
+                    n += packed[pos]
+                    pos += 1
+                assert dist <= len(out), "match before the start of the image"
+                for _ in range(n):
+                    out.append(out[-dist])
+            else:
+                out.append(packed[pos])
+                pos += 1
+    return bytes(out), trace
+
+
+def make_lz(new, bank_size=BANK_SIZE):
+    packed = compress(new)
+    _, trace = decompress(packed, len(new))
+    error = check_in_place(len(new), len(packed), trace, bank_size)
+    if error:
+        raise SystemExit("%s, send the full image" % error)
+    return make_container(LZ_MAGIC, new, packed, b'', bank_size)
+
+
+def apply(container):
+    """Replay of lightOta_imageFinalize, raises on anything the lamp would reject."""
+    magic, _, _, new_size, new_crc, packed = parse_container(container)
+    assert magic == LZ_MAGIC, "not a compressed container"
+    new, _ = decompress(packed, new_size)
+    check_image(new, new_size, new_crc)
+    return new
+
+
+def main(args):
+    with open(args.input_file, 'rb') as f:
+        new = prepare_firmware(f.read(-1))
+
+    container = make_lz(new, args.bank_size)
+    assert apply(container) == new
+    data_len = len(parse_container(container)[5])
+
+    blocks_raw = -(-len(new) // args.block_size)
+    blocks_lz = -(-len(container) // args.block_size)
+    # both downloads erase and write the bank as blocks arrive, only the unpack is extra
+    download_raw = blocks_raw * args.block_ms / 1000
+    download_lz = blocks_lz * args.block_ms / 1000
+    moved_pages = data_len // PAGE_SIZE + 1
+    unpack = ((align(data_len) + align(len(new))) // SECTOR_SIZE * args.erase_ms +
+              (moved_pages + len(new) // PAGE_SIZE + 1) * args.page_ms) / 1000
+
+    print("raw image        %7d bytes, %5d blocks" % (len(new), blocks_raw))
+    print("compressed image %7d bytes, %5d blocks, ratio %.3f" % (
+        len(container), blocks_lz, len(container) / len(new)))
+    print("unpacked in place, packed data moved to bank offset 0x%x, crc 0x%08x verified" % (
+        moved_offset(data_len, args.bank_size), int.from_bytes(new[-4:], 'little')))
+    print("end-to-end at %g ms per block: raw %.1f s, compressed %.1f s download + %.1f s unpack = %.1f s (%.0f%%)" % (
+        args.block_ms, download_raw, download_lz, unpack, download_lz + unpack,
+        100.0 * (download_lz + unpack) / download_raw))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("input_file", help="BIN to compress")
+    parser.add_argument('--bank-size', type=lambda x: int(x, 0), default=BANK_SIZE,
+                        help="standby bank size, FLASH_OTA_IMAGE_MAX_SIZE")
+    parser.add_argument('--block-size', type=int, default=48, help="OTA image block payload size")
+    parser.add_argument('--block-ms', type=float, default=60, help="time per image block request/response")
+    parser.add_argument('--erase-ms', type=float, default=40, help="flash sector erase time")
+    parser.add_argument('--page-ms', type=float, default=1.5, help="flash page write time")
+    _args = parser.parse_args()
+    main(_args)
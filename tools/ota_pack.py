@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+
+# Container shared by the delta (ota_delta.py) and compressed (ota_lz.py)
+# OTA images, unpacked on the lamp by src/sampleLightOta.c. The container
+# is sent as the regular upgrade image sub-element: the firmware header of
+# the new image, the pack header, the packed data and the tl_check_fw.py
+# padding and crc trailer.
+
+import binascii
+import struct
+
+# sync with sampleLightOta.h
+DELTA_MAGIC = 0x544c444c
+LZ_MAGIC = 0x535a4c4c
+PACK_VERSION = 1
+FW_HDR_LEN = 0x20
+FW_SIZE_OFFSET = 0x18
+SECTOR_SIZE = 0x1000
+PAGE_SIZE = 256
+
+# magic, version, baseSize, baseCrc, newSize, newCrc, dataLen, dataCrc
+PACK_HDR = struct.Struct('<IB3xIIIIII')
+DATA_OFFSET = FW_HDR_LEN + PACK_HDR.size
+
+BANK_SIZE = 0x34000  # FLASH_OTA_IMAGE_MAX_SIZE
+
+
+def crc(data):
+    """Running crc without the final xor, as xcrc32(data, len, 0xffffffff)."""
+    return binascii.crc32(data) ^ 0xffffffff
+
+
+def align(size):
+    return (size + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1)
+
+
+def moved_offset(data_len, bank_size):
+    """Where lightOta_unpack moves the data to, relative to the bank."""
+    return bank_size - align(data_len)
+
+
+def check_in_place(new_size, data_len, trace, bank_size):
+    """Replay the writer of lightOta_unpack against the reader position.
+
+    trace holds (bytes produced, bytes of data consumed) before each item
+    of the data. Returns None if the image can be unpacked, else the reason.
+    """
+    moved = moved_offset(data_len, bank_size)
+    if align(data_len) + SECTOR_SIZE > bank_size or moved < DATA_OFFSET + SECTOR_SIZE:
+        return "packed data too large for a 0x%x byte bank" % bank_size
+    if new_size > bank_size:
+        return "image larger than the bank"
+
+    i = 0
+    for sector in range(0, new_size, SECTOR_SIZE):
+        # the first page of the sector is flushed, and the sector erased,
+        # once the output grows past it
+        flush_at = min(sector + PAGE_SIZE, new_size)
+        while i + 1 < len(trace) and trace[i + 1][0] < flush_at:
+            i += 1
+        consumed = trace[i][1]
+        if consumed < data_len and moved + consumed < sector + SECTOR_SIZE and moved + data_len > sector:
+            return "output overtakes the packed data at 0x%x" % sector
+    return None
+
+
+def make_container(magic, new, data, base=b'', bank_size=BANK_SIZE):
+    hdr = PACK_HDR.pack(magic, PACK_VERSION, len(base), int.from_bytes(base[-4:], 'little') if base else 0,
+                        len(new), int.from_bytes(new[-4:], 'little'), len(data), crc(data))
+    container = bytearray(new[:FW_HDR_LEN]) + hdr + data
+    # same padding and trailer as tl_check_fw.py, the OTA client checks them like a full image
+    padding = 16 - len(container) % 16
+    if padding < 16:
+        container += b'\xFF' * padding
+    container[FW_SIZE_OFFSET:FW_SIZE_OFFSET + 4] = (len(container) + 4).to_bytes(4, 'little')
+    container += crc(container).to_bytes(4, 'little')
+    return bytes(container)
+
+
+def parse_container(container):
+    """Returns the header fields and the packed data, checked like the lamp does."""
+    magic, version, base_size, base_crc, new_size, new_crc, data_len, data_crc = PACK_HDR.unpack_from(
+        container, FW_HDR_LEN)
+    data = container[DATA_OFFSET:DATA_OFFSET + data_len]
+    assert magic in (DELTA_MAGIC, LZ_MAGIC) and version == PACK_VERSION, "not a packed container"
+    assert crc(data) == data_crc, "data crc"
+    return magic, base_size, base_crc, new_size, new_crc, data
+
+
+def check_image(new, new_size, new_crc):
+    assert len(new) == new_size, "image size"
+    assert crc(new[:-4]) == new_crc == int.from_bytes(new[-4:], 'little'), "image crc"
@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+
+# Stand-in OTA upgrade server on the ZBHCI UART (zbhci.c, hci_uart.c of the
+# SDK). Serves a .zigbee file made by make_ota.py to a lamp built with
+# ZBHCI_UART 1 in app_cfg.h and logs every block: latency from our response
+# to the next request, repeated requests and the total time, so that two
+# firmware builds can be compared on the same bench without radio noise.
+#
+# Limitation: this drives the ZBHCI OTA start/block/end commands, which write
+# the image through the SDK's UART upgrade path and bypass the ZCL OTA client
+# (ota.c). None of the client side of sampleLightOta.c runs in this exchange:
+# no OTA_EVT_START/COMPLETE, so no block pacing or fade hold, no resume
+# checkpoints, no packed image unpacking, and no Query Next Image or Upgrade
+# End. The timings measure the UART path and flash writes only; an over the
+# air download through a real ZCL OTA server is still needed for those.
+#
+#   ota_server.py serve -p /dev/ttyUSB0 1141-0000-00000002-glc002.zigbee --log blocks.csv
+#
+# "simulate" runs the same exchange against an in-process model of the
+# client, to check the server and the report without a lamp:
+#
+#   ota_server.py simulate 1141-0000-00000002-glc002.zigbee --flash-ms 4 --loss 0.01
+
+import argparse
+import csv
+import random
+import statistics
+import struct
+import time
+
+# ZBHCI frame: start, u16 type, u16 length, crc8, payload, end. Big endian.
+HCI_START = 0x55
+HCI_END = 0xAA
+
+# sync with zbhci.h of the SDK
+ZBHCI_CMD_ACKNOWLEDGE = 0x8000
+ZBHCI_CMD_OTA_START_REQUEST = 0x0210
+ZBHCI_CMD_OTA_START_RESPONSE = 0x8210
+ZBHCI_CMD_OTA_BLOCK_REQUEST = 0x0211
+ZBHCI_CMD_OTA_BLOCK_RESPONSE = 0x8211
+ZBHCI_CMD_OTA_END_REQUEST = 0x0212
+ZBHCI_CMD_OTA_END_RESPONSE = 0x8212
+
+# payloads
+START_REQ = struct.Struct('>IIHH')  # total file size, file version, manufacturer code, image type
+START_RSP = struct.Struct('>IIB')  # flash address, total file size, status
+BLOCK_REQ = struct.Struct('>IB')  # offset, length, sent by the lamp
+BLOCK_RSP = struct.Struct('>BIB')  # status, offset, length, then the data
+END_RSP = struct.Struct('>B')  # status
+
+STATUS_SUCCESS = 0x00
+STATUS_ABORT = 0x95
+STATUS_INVALID_IMAGE = 0x96
+
+OTA_FILE_MAGIC = 0x0beef11e
+OTA_HDR = struct.Struct('<I5HIH32sI')
+
+
+def crc8(msg_type, payload):
+    crc = (msg_type >> 8) ^ (msg_type & 0xff) ^ (len(payload) >> 8) ^ (len(payload) & 0xff)
+    for b in payload:
+        crc ^= b
+    return crc
+
+
+def frame(msg_type, payload=b''):
+    return struct.pack('>BHHB', HCI_START, msg_type, len(payload), crc8(msg_type, payload)) + payload + bytes([HCI_END])
+
+
+class Deframer:
+    """Splits the UART byte stream into (type, payload), drops damaged frames."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.dropped = 0
+
+    def feed(self, data):
+        self.buf += data
+        out = []
+        while True:
+            start = self.buf.find(HCI_START)
+            if start < 0:
+                self.buf.clear()
+                break
+            del self.buf[:start]
+            if len(self.buf) < 6:
+                break
+            msg_type, length, crc = struct.unpack_from('>HHB', self.buf, 1)
+            if len(self.buf) < 7 + length:
+                break
+            payload = bytes(self.buf[6:6 + length])
+            if self.buf[6 + length] == HCI_END and crc == crc8(msg_type, payload):
+                out.append((msg_type, payload))
+                del self.buf[:7 + length]
+            else:
+                self.dropped += 1
+                del self.buf[:1]
+        return out
+
+
+def load_image(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, _, hdr_len, _, manufacturer, image_type, version, _, _, size = OTA_HDR.unpack_from(data)
+    if magic != OTA_FILE_MAGIC or size != len(data) or hdr_len > len(data):
+        raise SystemExit("%s is not an OTA file" % path)
+    return data, manufacturer, image_type, version
+
+
+class SerialLink:
+    def __init__(self, port, baud):
+        import serial  # pyserial, only needed against a real lamp
+        self.port = serial.Serial(port, baud, timeout=0.01)
+
+    def send(self, data):
+        self.port.write(data)
+
+    def recv(self):
+        return self.port.read(256)
+
+
+class SimulatedLink:
+    """OTA client model: requests the file block by block, spends flash_ms
+    per block, loses a frame in either direction with probability loss and
+    asks again after retry_ms."""
+
+    def __init__(self, args, clock):
+        self.clock = clock
+        self.block = args.block_size
+        self.flash_ms = args.flash_ms
+        self.retry_ms = args.retry_ms
+        self.loss = args.loss
+        self.rand = random.Random(args.seed)
+        self.size = 0
+        self.offset = 0
+        self.due = None
+        self.rx = bytearray()
+        self.tx = bytearray()
+        self.deframer = Deframer()
+
+    def _request(self, delay_ms):
+        self.due = self.clock.now + delay_ms / 1000
+
+    def send(self, data):
+        for msg_type, payload in self.deframer.feed(data):
+            if self.rand.random() < self.loss:
+                continue
+            if msg_type == ZBHCI_CMD_OTA_START_REQUEST:
+                self.size = START_REQ.unpack(payload)[0]
+                self.offset = 0
+                self.tx += frame(ZBHCI_CMD_OTA_START_RESPONSE, START_RSP.pack(0x40000, self.size, STATUS_SUCCESS))
+                self._request(self.flash_ms)
+            elif msg_type == ZBHCI_CMD_OTA_BLOCK_RESPONSE:
+                status, offset, length = BLOCK_RSP.unpack_from(payload)
+                if status == STATUS_SUCCESS and offset == self.offset:
+                    self.offset += length
+                    self._request(self.flash_ms)
+
+    def recv(self):
+        if self.due is not None and self.clock.now >= self.due:
+            self.due = None
+            if self.offset >= self.size:
+                self.tx += frame(ZBHCI_CMD_OTA_END_RESPONSE, END_RSP.pack(STATUS_SUCCESS))
+            else:
+                if self.rand.random() >= self.loss:
+                    length = min(self.block, self.size - self.offset)
+                    self.tx += frame(ZBHCI_CMD_OTA_BLOCK_REQUEST, BLOCK_REQ.pack(self.offset, length))
+                # lost or not, the client asks again if nothing comes back
+                self._request(self.retry_ms)
+        data, self.tx = bytes(self.tx), bytearray()
+        if not data:
+            self.clock.sleep(0.001)
+        return data
+
+
+class WallClock:
+    @property
+    def now(self):
+        return time.monotonic()
+
+    @staticmethod
+    def sleep(s):
+        time.sleep(s)
+
+
+class VirtualClock:
+    def __init__(self):
+        self.now = 0.0
+
+    def sleep(self, s):
+        self.now += s
+
+
+def serve(link, clock, image, args, log_rows):
+    data, manufacturer, image_type, version = image
+    deframer = Deframer()
+    served = {}
+    last_rsp = None
+    retries = 0
+    start = clock.now
+
+    link.send(frame(ZBHCI_CMD_OTA_START_REQUEST, START_REQ.pack(len(data), version, manufacturer, image_type)))
+    started = False
+    while True:
+        if clock.now - start > args.timeout:
+            raise SystemExit("timeout after %d bytes" % max(served.keys(), default=0))
+        for msg_type, payload in deframer.feed(link.recv()):
+            if msg_type == ZBHCI_CMD_OTA_START_RESPONSE:
+                _, _, status = START_RSP.unpack(payload)
+                if status != STATUS_SUCCESS:
+                    raise SystemExit("lamp refused the image, status 0x%02x" % status)
+                started = True
+            elif msg_type == ZBHCI_CMD_OTA_BLOCK_REQUEST and started:
+                offset, length = BLOCK_REQ.unpack(payload)
+                now = clock.now
+                latency = (now - last_rsp) * 1000 if last_rsp is not None else 0.0
+                retry = offset in served
+                retries += retry
+                served[offset] = served.get(offset, 0) + 1
+                chunk = data[offset:offset + length]
+                status = STATUS_SUCCESS if chunk else STATUS_ABORT
+                link.send(frame(ZBHCI_CMD_OTA_BLOCK_RESPONSE, BLOCK_RSP.pack(status, offset, len(chunk)) + chunk))
+                last_rsp = clock.now
+                log_rows.append((round((now - start) * 1000, 3), offset, len(chunk), round(latency, 3), int(retry)))
+            elif msg_type == ZBHCI_CMD_OTA_END_RESPONSE:
+                status, = END_RSP.unpack(payload)
+                return status, clock.now - start, retries, deframer.dropped
+            elif msg_type != ZBHCI_CMD_ACKNOWLEDGE and args.verbose:
+                print("ignored 0x%04x %s" % (msg_type, payload.hex()))
+
+
+def report(image, status, total_s, retries, dropped, log_rows):
+    data = image[0]
+    latencies = sorted(row[3] for row in log_rows[1:] if not row[4])
+    print("file version 0x%08x, %d bytes, %d block requests" % (image[3], len(data), len(log_rows)))
+    print("end status 0x%02x after %.2f s, %.0f bytes/s" % (status, total_s, len(data) / total_s if total_s else 0))
+    print("retries %d, damaged frames %d" % (retries, dropped))
+    if latencies:
+        print("block latency ms: mean %.1f, p50 %.1f, p95 %.1f, max %.1f" % (
+            statistics.mean(latencies), latencies[len(latencies) // 2],
+            latencies[min(len(latencies) - 1, int(len(latencies) * 0.95))], latencies[-1]))
+
+
+def main(args):
+    image = load_image(args.image)
+    if args.command == 'serve':
+        clock = WallClock()
+        link = SerialLink(args.port, args.baud)
+    else:
+        clock = VirtualClock()
+        link = SimulatedLink(args, clock)
+
+    log_rows = []
+    status, total_s, retries, dropped = serve(link, clock, image, args, log_rows)
+    report(image, status, total_s, retries, dropped, log_rows)
+
+    if args.log:
+        with open(args.log, 'w', newline='') as f:
+            writer = csv.writer(f)
+            writer.writerow(('t_ms', 'offset', 'len', 'latency_ms', 'retry'))
+            writer.writerows(log_rows)
+    if status != STATUS_SUCCESS:
+        raise SystemExit(1)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('command', choices=('serve', 'simulate'))
+    parser.add_argument('image', help=".zigbee file made by make_ota.py")
+    parser.add_argument("-p", '--port', help="serial port of the lamp, for serve")
+    parser.add_argument("-b", '--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=600, help="give up after this many seconds")
+    parser.add_argument('--log', help="write one CSV row per block request")
+    parser.add_argument("-v", '--verbose', action='store_true')
+    # client model, for simulate
+    parser.add_argument('--block-size', type=int, default=48, help="bytes per block request")
+    parser.add_argument('--flash-ms', type=float, default=4, help="time the client spends per block")
+    parser.add_argument('--retry-ms', type=float, default=1000, help="client request timeout")
+    parser.add_argument('--loss', type=float, default=0.0, help="frame loss ratio")
+    parser.add_argument('--seed', type=int, default=1)
+    _args = parser.parse_args()
+    if _args.command == 'serve' and not _args.port:
+        parser.error("serve needs --port")
+    main(_args)
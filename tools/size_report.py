@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+
+# Flash, RAM and stack report of a link, run by the glc002.report target
+# (ADD_REPORT_TARGET in cmake/TelinkSDK.cmake). Sizes come from the linker
+# map, per module (object file or archive member) and per function
+# (-ffunction-sections input section), stack frames from the -fstack-usage
+# .su files next to the objects.
+#
+# The totals are checked against the budgets in the baseline file and every
+# module is compared with its size in the baseline, so that growth shows up
+# in review instead of in a full OTA bank:
+#
+#   size_report.py -m glc002.map -s CMakeFiles/glc002.dir -b tools/size_baseline.json
+#   size_report.py -m glc002.map -s CMakeFiles/glc002.dir -b tools/size_baseline.json --update
+
+import argparse
+import json
+import os
+import re
+
+# output sections by where they live, a section in both is copied from flash to RAM at start-up
+FLASH_SECTIONS = ('.vectors', '.ram_code', '.text', '.rodata', '.retention_data', '.data')
+RAM_SECTIONS = ('.ram_code', '.retention_data', '.retention_bss', '.data', '.bss', '.ictag', '.irq_stk')
+
+OUTPUT_RE = re.compile(r'^(\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+INPUT_RE = re.compile(r'^ (\.\S+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$')
+INPUT_CONT_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+OUTPUT_CONT_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+SU_RE = re.compile(r'^(.*?):\d+:\d+:(\S+)\s+(\d+)\s+(\S+)$')
+
+
+def module_name(path):
+    """libzb_router.a(bdb.o) stays as it is, our own objects lose the build path and .obj."""
+    path = path.strip()
+    if path.endswith(')'):
+        return os.path.basename(path)
+    name = os.path.basename(path)
+    for ext in ('.obj', '.o'):
+        if name.endswith(ext):
+            name = name[:-len(ext)]
+    return name
+
+
+def function_name(section):
+    """.text.lightOta_crc -> lightOta_crc, plain sections have no function."""
+    for prefix in ('.text.', '.ram_code.', '.rodata.', '.data.', '.bss.', '.sbss.', '.sdata.'):
+        if section.startswith(prefix):
+            return section[len(prefix):]
+    return None
+
+
+def parse_map(path):
+    """Returns {(module, function or None): {'flash': n, 'ram': n}} and the
+    totals of the output sections, alignment fill included."""
+    usage = {}
+    totals = {'flash': 0, 'ram': 0}
+    output = None
+    pending = None
+    pending_output = False
+    in_map = False
+
+    def add_output(size):
+        if output.startswith(FLASH_SECTIONS):
+            totals['flash'] += size
+        if output.startswith(RAM_SECTIONS):
+            totals['ram'] += size
+
+    def add(section, size, source):
+        if not size or output is None:
+            return
+        key = (module_name(source), function_name(section))
+        entry = usage.setdefault(key, {'flash': 0, 'ram': 0})
+        if output.startswith(FLASH_SECTIONS):
+            entry['flash'] += size
+        if output.startswith(RAM_SECTIONS):
+            entry['ram'] += size
+
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if line.startswith('Linker script and memory map'):
+                in_map = True
+                continue
+            if not in_map:
+                # skip the discarded input sections
+                continue
+            if pending_output:
+                m = OUTPUT_CONT_RE.match(line)
+                if m:
+                    add_output(int(m.group(2), 16))
+                pending_output = False
+                continue
+            if pending:
+                m = INPUT_CONT_RE.match(line)
+                if m:
+                    add(pending, int(m.group(2), 16), m.group(3))
+                pending = None
+                continue
+            m = OUTPUT_RE.match(line)
+            if m and not line.startswith(' '):
+                output = m.group(1)
+                add_output(int(m.group(3), 16))
+                continue
+            if line.startswith('.') and ' ' not in line:
+                # long output section name, address and size on the next line
+                output = line
+                pending_output = True
+                continue
+            m = INPUT_RE.match(line)
+            if m:
+                if m.group(2) is None:
+                    # long input section name, address, size and file on the next line
+                    pending = m.group(1)
+                else:
+                    add(m.group(1), int(m.group(3), 16), m.group(4))
+    return usage, totals
+
+
+def parse_stack(su_dir):
+    """Returns {function: (bytes, qualifier, module)} from every .su file below su_dir."""
+    stack = {}
+    for root, _, files in os.walk(su_dir):
+        for name in files:
+            if not name.endswith('.su'):
+                continue
+            with open(os.path.join(root, name)) as f:
+                for line in f:
+                    m = SU_RE.match(line.strip())
+                    if m:
+                        stack[m.group(2)] = (int(m.group(3)), m.group(4), module_name(name[:-3]))
+    return stack
+
+
+def summarize(usage):
+    modules = {}
+    for (module, _), entry in usage.items():
+        total = modules.setdefault(module, {'flash': 0, 'ram': 0})
+        total['flash'] += entry['flash']
+        total['ram'] += entry['ram']
+    return modules
+
+
+def main(args):
+    usage, totals = parse_map(args.map)
+    stack = parse_stack(args.su_dir) if args.su_dir else {}
+    modules = summarize(usage)
+    flash = totals['flash']
+    ram = totals['ram']
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    budget = baseline['budget']
+    base_modules = baseline.get('modules', {})
+
+    print("%-40s %8s %8s %8s" % ("module", "flash", "ram", "delta"))
+    for name, m in sorted(modules.items(), key=lambda kv: -kv[1]['flash'])[:args.top]:
+        delta = m['flash'] - base_modules[name]['flash'] if name in base_modules else None
+        print("%-40s %8d %8d %8s" % (name, m['flash'], m['ram'], '' if delta is None else '%+d' % delta))
+
+    print("\n%-40s %8s %8s %8s" % ("function or object", "flash", "ram", "stack"))
+    symbols = [(key, entry) for key, entry in usage.items() if key[1]]
+    for (_, name), entry in sorted(symbols, key=lambda kv: (-kv[1]['flash'], -kv[1]['ram']))[:args.top]:
+        print("%-40s %8d %8d %8s" % (name[:40], entry['flash'], entry['ram'], stack[name][0] if name in stack else ''))
+
+    if stack:
+        print("\n%-40s %8s  %s" % ("deepest frames", "stack", "module"))
+        for func, (size, qualifier, module) in sorted(stack.items(), key=lambda kv: -kv[1][0])[:args.top]:
+            print("%-40s %8d  %s %s" % (func[:40], size, module, '' if qualifier == 'static' else qualifier))
+
+    print("\ntotal flash %d of %d, ram %d of %d" % (flash, budget['flash'], ram, budget['ram']))
+
+    if args.update:
+        baseline['modules'] = {name: modules[name] for name in sorted(modules)}
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print("%s updated" % args.baseline)
+        return
+
+    errors = []
+    if flash > budget['flash']:
+        errors.append("flash %d over the budget of %d" % (flash, budget['flash']))
+    if ram > budget['ram']:
+        errors.append("ram %d over the budget of %d" % (ram, budget['ram']))
+    for func, (size, _, _) in stack.items():
+        if size > budget['stack_frame']:
+            errors.append("%s uses %d bytes of stack, the budget is %d" % (func, size, budget['stack_frame']))
+    for name, m in modules.items():
+        if name in base_modules and m['flash'] > base_modules[name]['flash'] + budget['module_growth']:
+            errors.append("%s grew by %d bytes of flash" % (name, m['flash'] - base_modules[name]['flash']))
+    for error in errors:
+        print("error: " + error)
+    if errors:
+        raise SystemExit(1)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-m", '--map', required=True, help="linker map file")
+    parser.add_argument("-s", '--su-dir', help="directory searched for -fstack-usage .su files")
+    parser.add_argument("-b", '--baseline', required=True, help="JSON with the budgets and the module sizes")
+    parser.add_argument('--top', type=int, default=25, help="rows per table")
+    parser.add_argument('--update', action='store_true', help="store this build as the baseline, no budget check")
+    _args = parser.parse_args()
+    main(_args)
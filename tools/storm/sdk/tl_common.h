@@ -0,0 +1,167 @@
+/********************************************************************************************************
+ * @file    tl_common.h
+ *
+ * @brief   Host stand-in for the SDK common header, used by tools/storm only.
+ *          Just enough of the types, the timer pool, the PWM and flash drivers
+ *          and the NV module for the light command callbacks and the light
+ *          state persistence to build and run against a virtual clock.
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _STORM_TL_COMMON_H_
+#define _STORM_TL_COMMON_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**********************************************************************
+ * Types
+ */
+typedef unsigned char u8;
+typedef signed char s8;
+typedef unsigned short u16;
+typedef signed short s16;
+typedef unsigned int u32;
+typedef signed int s32;
+typedef unsigned long long u64;
+typedef signed long long s64;
+
+typedef u8 bool;
+#define TRUE 1
+#define FALSE 0
+#define true 1
+#define false 0
+#define NULL_PTR ((void *)0)
+
+typedef u8 status_t;
+typedef u8 nv_sts_t;
+
+#define BIT(n) (1 << (n))
+#define BUILD_U16(lo, hi) ((u16)(((lo) & 0x00FF) + (((hi) & 0x00FF) << 8)))
+#define LO_UINT16(a) ((a) & 0xFF)
+#define HI_UINT16(a) (((a) >> 8) & 0xFF)
+#define min2(a, b) ((a) < (b) ? (a) : (b))
+#define max2(a, b) ((a) > (b) ? (a) : (b))
+#define max3(a, b, c) max2(max2(a, b), c)
+
+/**********************************************************************
+ * Board
+ */
+
+#define GPIO_PA0 0x000
+#define GPIO_PA1 0x001
+#define GPIO_PB1 0x101
+#define GPIO_PB4 0x104
+#define GPIO_PB7 0x107
+#define GPIO_PC0 0x200
+#define GPIO_PC2 0x202
+#define GPIO_PC3 0x203
+#define GPIO_PC4 0x204
+#define GPIO_PC5 0x205
+#define GPIO_PD2 0x302
+
+#define AS_GPIO 0
+#define AS_PWM0 1
+#define AS_PWM1 2
+#define AS_PWM2 3
+#define AS_PWM3 4
+#define AS_PWM4 5
+#define PM_PIN_PULLUP_10K 2
+
+#define gpio_set_func(pin, func) ((void)(pin), (void)(func))
+
+#define PWM_CLOCK_SOURCE 48000000
+
+#include "app_cfg.h"
+
+/**********************************************************************
+ * PWM driver, counted so that the harness can tell the render cost of a command
+ */
+extern u32 storm_pwmWrites;
+
+#define drv_pwm_init()
+#define drv_pwm_cfg(ch, cmpTick, cycleTick) (storm_pwmWrites++, (void)(ch), (void)(cmpTick), (void)(cycleTick))
+#define drv_pwm_start(ch) (storm_pwmWrites++, (void)(ch))
+#define drv_pwm_stop(ch) (storm_pwmWrites++, (void)(ch))
+
+/**********************************************************************
+ * Timer pool on the virtual clock of the harness
+ */
+typedef s32 (*ev_timer_callback_t)(void *arg);
+
+typedef struct ev_timer_event
+{
+	ev_timer_callback_t cb;
+	void *data;
+	u32 timeout; // virtual ms of the next expiry
+	u32 period;
+	u32 seq; // allocation number, tells a reused slot from the one a callback was started on
+	u8 used;
+} ev_timer_event_t;
+
+ev_timer_event_t *storm_timerAdd(ev_timer_callback_t cb, void *arg, u32 ms);
+void storm_timerCancel(ev_timer_event_t **evt);
+
+#define TL_ZB_TIMER_SCHEDULE storm_timerAdd
+#define TL_ZB_TIMER_CANCEL storm_timerCancel
+
+/**********************************************************************
+ * System timer, derived from the virtual clock
+ */
+#define CLOCK_16M_SYS_TIMER_CLK_1US 16
+#define CLOCK_16M_SYS_TIMER_CLK_1MS (CLOCK_16M_SYS_TIMER_CLK_1US * 1000)
+#define CLOCK_16M_SYS_TIMER_CLK_1S (CLOCK_16M_SYS_TIMER_CLK_1MS * 1000)
+
+u32 clock_time(void);
+bool clock_time_exceed(u32 ref, u32 us);
+
+/**********************************************************************
+ * Flash driver on a RAM image, every access is counted
+ */
+#define FLASH_ADDR_OF_OTA_IMAGE 0x40000
+#define FLASH_OTA_IMAGE_MAX_SIZE 0x34000
+
+void flash_read(u32 addr, u32 len, u8 *buf);
+void flash_write(u32 addr, u32 len, u8 *buf);
+void flash_erase(u32 addr);
+
+u32 xcrc32(const u8 *buf, int len, u32 crc);
+
+/**********************************************************************
+ * NV module, items are not kept, reads and writes are counted
+ */
+#define NV_ENABLE 1
+
+#define NV_SUCC 0x00
+#define NV_ITEM_NOT_FOUND 0x01
+#define NV_ENABLE_PROTECT_ERROR 0x0A
+
+#define NV_MODULE_ZCL 0x03
+#define NV_MODULE_APP 0x04
+
+#define NV_ITEM_ZCL_ON_OFF 0x02
+#define NV_ITEM_ZCL_LEVEL 0x03
+#define NV_ITEM_ZCL_COLOR_CTRL 0x04
+#define NV_ITEM_APP_USER_CFG 0x40
+
+nv_sts_t nv_flashReadNew(u8 single, u8 id, u8 itemId, u16 len, u8 *buf);
+nv_sts_t nv_flashWriteNew(u8 single, u8 id, u8 itemId, u16 len, u8 *buf);
+
+#endif /* _STORM_TL_COMMON_H_ */
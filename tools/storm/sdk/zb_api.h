@@ -0,0 +1,54 @@
+/********************************************************************************************************
+ * @file    zb_api.h
+ *
+ * @brief   Host stand-in for the SDK stack API, used by tools/storm only.
+ *          The stack types named in sampleLight.h, nothing behind them,
+ *          and a stack that is always idle.
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _STORM_ZB_API_H_
+#define _STORM_ZB_API_H_
+
+typedef struct bdb_commissionSetting bdb_commissionSetting_t;
+typedef struct bdb_appCb bdb_appCb_t;
+typedef struct nlme_leave_cnf nlme_leave_cnf_t;
+typedef struct nlme_leave_ind nlme_leave_ind_t;
+typedef struct nwkCmd_nwkUpdate nwkCmd_nwkUpdate_t;
+
+#define HA_PROFILE_ID 0x0104
+#define HA_DEV_COLOR_DIMMABLE_LIGHT 0x0102
+
+typedef struct af_simple_descriptor
+{
+	u16 app_profile_id;
+	u16 app_dev_id;
+	u8 endpoint;
+	u8 app_dev_ver : 4;
+	u8 reserved : 4;
+	u8 app_in_cluster_count;
+	u8 app_out_cluster_count;
+	u16 *app_in_cluster_lst;
+	u16 *app_out_cluster_lst;
+} af_simple_descriptor_t;
+
+#define tl_stackBusy() FALSE
+#define zb_isTaskDone() TRUE
+
+#endif /* _STORM_ZB_API_H_ */
@@ -0,0 +1,505 @@
+/********************************************************************************************************
+ * @file    zcl_include.h
+ *
+ * @brief   Host stand-in for the SDK ZCL headers, used by tools/storm only.
+ *          Command payloads, identifiers and limits of the On/Off, Level,
+ *          Color Control and Scenes clusters as the light callbacks use them.
+ *          Values follow the ZCL specification.
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#ifndef _STORM_ZCL_INCLUDE_H_
+#define _STORM_ZCL_INCLUDE_H_
+
+#include "zb_api.h"
+
+/**********************************************************************
+ * Cluster switches, as zcl_config.h derives them from app_cfg.h
+ */
+#if ZCL_ON_OFF_SUPPORT
+#define ZCL_ON_OFF
+#endif
+#if ZCL_LEVEL_CTRL_SUPPORT
+#define ZCL_LEVEL_CTRL
+#endif
+#if ZCL_LIGHT_COLOR_CONTROL_SUPPORT
+#define ZCL_LIGHT_COLOR_CONTROL
+#endif
+#if ZCL_GROUP_SUPPORT
+#define ZCL_GROUP
+#endif
+#if ZCL_SCENE_SUPPORT
+#define ZCL_SCENE
+#endif
+#if ZCL_TIME_SUPPORT
+#define ZCL_TIME
+#endif
+
+/**********************************************************************
+ * General
+ */
+#define ZCL_STA_SUCCESS 0x00
+#define ZCL_STA_FAILURE 0x01
+#define ZCL_STA_INVALID_VALUE 0x87
+#define ZCL_STA_NOT_FOUND 0x8B
+#define ZCL_STA_INSUFFICIENT_SPACE 0x89
+
+#define ZCL_FRAME_CLIENT_SERVER_DIR 0x00
+#define ZCL_BASIC_MAX_LENGTH 24
+
+#define ZCL_CLUSTER_GEN_BASIC 0x0000
+#define ZCL_CLUSTER_GEN_IDENTIFY 0x0003
+#define ZCL_CLUSTER_GEN_GROUPS 0x0004
+#define ZCL_CLUSTER_GEN_SCENES 0x0005
+#define ZCL_CLUSTER_GEN_ON_OFF 0x0006
+#define ZCL_CLUSTER_GEN_LEVEL_CONTROL 0x0008
+#define ZCL_CLUSTER_GEN_TIME 0x000A
+#define ZCL_CLUSTER_LIGHTING_COLOR_CONTROL 0x0300
+
+typedef struct
+{
+	u16 profileId;
+	u16 clusterId;
+	u16 srcAddr;
+	u16 dstAddr;
+	u8 srcEp;
+	u8 dstEp;
+	u8 dirCluster;
+	u8 apsSec;
+	u16 manufCode;
+	u8 seqNum;
+} zclIncomingAddrInfo_t;
+
+typedef struct zclIncoming zclIncoming_t;
+
+typedef struct
+{
+	u16 id;
+	u8 type;
+	u8 access;
+	u8 *data;
+} zclAttrInfo_t;
+
+typedef status_t (*cluster_forAppCb_t)(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload);
+typedef status_t (*cluster_registerFunc_t)(u8 endpoint, u16 manuCode, u8 attrNum, const zclAttrInfo_t attrTbl[], cluster_forAppCb_t cb);
+
+typedef struct
+{
+	u16 clusterId;
+	u16 manuCode;
+	u16 attrNum;
+	const zclAttrInfo_t *attrTbl;
+	cluster_registerFunc_t clusterRegisterFunc;
+	cluster_forAppCb_t clusterAppCb;
+} zcl_specClusterInfo_t;
+
+/**********************************************************************
+ * Attribute tables of sampleLightEpCfg.c. The harness never registers
+ * the clusters, so the register functions of the SDK are left out.
+ */
+#define MANUFACTURER_CODE_NONE 0x0000
+
+#define ACCESS_CONTROL_READ 0x01
+#define ACCESS_CONTROL_WRITE 0x02
+#define ACCESS_CONTROL_REPORTABLE 0x04
+
+#define ZCL_DATA_TYPE_BOOLEAN 0x10
+#define ZCL_DATA_TYPE_BITMAP8 0x18
+#define ZCL_DATA_TYPE_BITMAP16 0x19
+#define ZCL_DATA_TYPE_UINT8 0x20
+#define ZCL_DATA_TYPE_UINT16 0x21
+#define ZCL_DATA_TYPE_UINT32 0x23
+#define ZCL_DATA_TYPE_INT32 0x2B
+#define ZCL_DATA_TYPE_ENUM8 0x30
+#define ZCL_DATA_TYPE_CHAR_STR 0x42
+#define ZCL_DATA_TYPE_UTC 0xE2
+
+#define ZCL_ATTRID_GLOBAL_CLUSTER_REVISION 0xFFFD
+
+#define POWER_SOURCE_MAINS_1_PHASE 0x01
+
+#define ZCL_ATTRID_BASIC_ZCL_VER 0x0000
+#define ZCL_ATTRID_BASIC_APP_VER 0x0001
+#define ZCL_ATTRID_BASIC_STACK_VER 0x0002
+#define ZCL_ATTRID_BASIC_HW_VER 0x0003
+#define ZCL_ATTRID_BASIC_MFR_NAME 0x0004
+#define ZCL_ATTRID_BASIC_MODEL_ID 0x0005
+#define ZCL_ATTRID_BASIC_POWER_SOURCE 0x0007
+#define ZCL_ATTRID_BASIC_DEV_ENABLED 0x0012
+#define ZCL_ATTRID_BASIC_SW_BUILD_ID 0x4000
+
+#define ZCL_ATTRID_IDENTIFY_TIME 0x0000
+
+#define ZCL_ATTRID_GROUP_NAME_SUPPORT 0x0000
+
+#define ZCL_ATTRID_SCENE_SCENE_COUNT 0x0000
+#define ZCL_ATTRID_SCENE_CURRENT_SCENE 0x0001
+#define ZCL_ATTRID_SCENE_CURRENT_GROUP 0x0002
+#define ZCL_ATTRID_SCENE_SCENE_VALID 0x0003
+#define ZCL_ATTRID_SCENE_NAME_SUPPORT 0x0004
+
+#define ZCL_ATTRID_ONOFF 0x0000
+#define ZCL_ATTRID_GLOBAL_SCENE_CONTROL 0x4000
+#define ZCL_ATTRID_ON_TIME 0x4001
+#define ZCL_ATTRID_OFF_WAIT_TIME 0x4002
+#define ZCL_ATTRID_START_UP_ONOFF 0x4003
+
+#define ZCL_ATTRID_TIME 0x0000
+#define ZCL_ATTRID_TIME_STATUS 0x0001
+#define ZCL_ATTRID_TIME_ZONE 0x0002
+#define ZCL_ATTRID_DST_START 0x0003
+#define ZCL_ATTRID_DST_END 0x0004
+#define ZCL_ATTRID_DST_SHIFT 0x0005
+#define ZCL_ATTRID_STANDARD_TIME 0x0006
+#define ZCL_ATTRID_LOCAL_TIME 0x0007
+
+#define ZCL_ATTRID_LEVEL_CURRENT_LEVEL 0x0000
+#define ZCL_ATTRID_LEVEL_REMAINING_TIME 0x0001
+#define ZCL_ATTRID_LEVEL_START_UP_CURRENT_LEVEL 0x4000
+
+#define ZCL_ATTRID_CURRENT_HUE 0x0000
+#define ZCL_ATTRID_CURRENT_SATURATION 0x0001
+#define ZCL_ATTRID_CURRENT_X 0x0003
+#define ZCL_ATTRID_CURRENT_Y 0x0004
+#define ZCL_ATTRID_COLOR_TEMPERATURE_MIREDS 0x0007
+#define ZCL_ATTRID_COLOR_MODE 0x0008
+#define ZCL_ATTRID_COLOR_OPTIONS 0x000F
+#define ZCL_ATTRID_NUMBER_OF_PRIMARIES 0x0010
+#define ZCL_ATTRID_ENHANCED_CURRENT_HUE 0x4000
+#define ZCL_ATTRID_ENHANCED_COLOR_MODE 0x4001
+#define ZCL_ATTRID_COLOR_LOOP_ACTIVE 0x4002
+#define ZCL_ATTRID_COLOR_LOOP_DIRECTION 0x4003
+#define ZCL_ATTRID_COLOR_LOOP_TIME 0x4004
+#define ZCL_ATTRID_COLOR_LOOP_START_ENHANCED_HUE 0x4005
+#define ZCL_ATTRID_COLOR_LOOP_STORED_ENHANCED_HUE 0x4006
+#define ZCL_ATTRID_COLOR_CAPABILITIES 0x400A
+#define ZCL_ATTRID_COLOR_TEMP_PHYSICAL_MIN_MIREDS 0x400B
+#define ZCL_ATTRID_COLOR_TEMP_PHYSICAL_MAX_MIREDS 0x400C
+#define ZCL_ATTRID_START_UP_COLOR_TEMPERATURE_MIREDS 0x4010
+
+#define ZCL_COLOR_CAPABILITIES_BIT_HUE_SATURATION BIT(0)
+#define ZCL_COLOR_CAPABILITIES_BIT_ENHANCED_HUE BIT(1)
+#define ZCL_COLOR_CAPABILITIES_BIT_COLOR_LOOP BIT(2)
+#define ZCL_COLOR_CAPABILITIES_BIT_X_Y_ATTRIBUTES BIT(3)
+#define ZCL_COLOR_CAPABILITIES_BIT_COLOR_TEMPERATURE BIT(4)
+
+#define ZCL_START_UP_ONOFF_SET_ONOFF_TO_OFF 0x00
+#define ZCL_START_UP_ONOFF_SET_ONOFF_TO_ON 0x01
+#define ZCL_START_UP_ONOFF_SET_ONOFF_TOGGLE 0x02
+#define ZCL_START_UP_CURRENT_LEVEL_TO_MIN 0x00
+#define ZCL_START_UP_CURRENT_LEVEL_TO_PREVIOUS 0xFF
+#define ZCL_START_UP_COLOR_TEMPERATURE_MIREDS_TO_PREVIOUS 0xFFFF
+
+extern const u16 zcl_attr_global_clusterRevision;
+
+#define zcl_basic_register NULL
+#define zcl_identify_register NULL
+#define zcl_group_register NULL
+#define zcl_scene_register NULL
+#define zcl_onOff_register NULL
+#define zcl_level_register NULL
+#define zcl_lightColorCtrl_register NULL
+#define zcl_time_register NULL
+
+/**********************************************************************
+ * On/Off
+ */
+#define ZCL_CMD_ONOFF_OFF 0x00
+#define ZCL_CMD_ONOFF_ON 0x01
+#define ZCL_CMD_ONOFF_TOGGLE 0x02
+#define ZCL_CMD_OFF_WITH_EFFECT 0x40
+#define ZCL_CMD_ON_WITH_RECALL_GLOBAL_SCENE 0x41
+#define ZCL_CMD_ON_WITH_TIMED_OFF 0x42
+
+#define ZCL_ONOFF_STATUS_OFF 0x00
+#define ZCL_ONOFF_STATUS_ON 0x01
+
+typedef struct
+{
+	u8 effectId;
+	u8 effectVariant;
+} zcl_onoff_offWithEffectCmd_t;
+
+typedef struct
+{
+	union
+	{
+		struct
+		{
+			u8 acceptOnlyWhenOn : 1;
+			u8 reserved : 7;
+		} bits;
+		u8 onOffCtrl;
+	} onOffCtrl;
+	u16 onTime;
+	u16 offWaitTime;
+} zcl_onoff_onWithTimeOffCmd_t;
+
+/**********************************************************************
+ * Level
+ */
+#define ZCL_CMD_LEVEL_MOVE_TO_LEVEL 0x00
+#define ZCL_CMD_LEVEL_MOVE 0x01
+#define ZCL_CMD_LEVEL_STEP 0x02
+#define ZCL_CMD_LEVEL_STOP 0x03
+#define ZCL_CMD_LEVEL_MOVE_TO_LEVEL_WITH_ON_OFF 0x04
+#define ZCL_CMD_LEVEL_MOVE_WITH_ON_OFF 0x05
+#define ZCL_CMD_LEVEL_STEP_WITH_ON_OFF 0x06
+#define ZCL_CMD_LEVEL_STOP_WITH_ON_OFF 0x07
+
+#define ZCL_LEVEL_ATTR_MIN_LEVEL 0x01
+#define ZCL_LEVEL_ATTR_MAX_LEVEL 0xFE
+
+#define LEVEL_MOVE_UP 0x00
+#define LEVEL_MOVE_DOWN 0x01
+#define LEVEL_STEP_UP 0x00
+#define LEVEL_STEP_DOWN 0x01
+
+typedef struct
+{
+	u8 level;
+	u16 transitionTime;
+} moveToLvl_t;
+
+typedef struct
+{
+	u8 moveMode;
+	u8 rate;
+} move_t;
+
+typedef struct
+{
+	u8 stepMode;
+	u8 stepSize;
+	u16 transitionTime;
+} step_t;
+
+typedef struct
+{
+	u8 reserved;
+} stop_t;
+
+/**********************************************************************
+ * Color Control
+ */
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_HUE 0x00
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_HUE 0x01
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_HUE 0x02
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_SATURATION 0x03
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_SATURATION 0x04
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_SATURATION 0x05
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_HUE_AND_SATURATION 0x06
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_COLOR 0x07
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_COLOR 0x08
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_COLOR 0x09
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_COLOR_TEMPERATURE 0x0A
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_MOVE_TO_HUE 0x40
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_MOVE_HUE 0x41
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_STEP_HUE 0x42
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_MOVE_TO_HUE_AND_SATURATION 0x43
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_COLOR_LOOP_SET 0x44
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_STOP_MOVE_STEP 0x47
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_COLOR_TEMPERATURE 0x4B
+#define ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_COLOR_TEMPERATURE 0x4C
+
+#define ZCL_COLOR_MODE_CURRENT_HUE_SATURATION 0x00
+#define ZCL_COLOR_MODE_CURRENT_X_Y 0x01
+#define ZCL_COLOR_MODE_COLOR_TEMPERATURE_MIREDS 0x02
+#define ZCL_ENHANCED_COLOR_MODE_CURRENT_HUE_SATURATION 0x03
+
+#define ZCL_COLOR_ATTR_HUE_MIN 0x00
+#define ZCL_COLOR_ATTR_HUE_MAX 0xFE
+#define ZCL_COLOR_ATTR_SATURATION_MIN 0x00
+#define ZCL_COLOR_ATTR_SATURATION_MAX 0xFE
+#define ZCL_COLOR_ATTR_XY_MIN 0x0000
+#define ZCL_COLOR_ATTR_XY_MAX 0xFEFF
+#define ZCL_COLOR_ATTR_ENHANCED_HUE_MIN 0x0000
+#define ZCL_COLOR_ATTR_ENHANCED_HUE_MAX 0xFFFF
+
+#define COLOR_CTRL_DIRECTION_SHORTEST_DISTANCE 0x00
+#define COLOR_CTRL_DIRECTION_LONGEST_DISTANCE 0x01
+#define COLOR_CTRL_DIRECTION_UP 0x02
+#define COLOR_CTRL_DIRECTION_DOWN 0x03
+
+#define COLOR_CTRL_MOVE_STOP 0x00
+#define COLOR_CTRL_MOVE_UP 0x01
+#define COLOR_CTRL_MOVE_DOWN 0x03
+
+#define COLOR_CTRL_STEP_MODE_UP 0x01
+#define COLOR_CTRL_STEP_MODE_DOWN 0x03
+
+#define COLOR_LOOP_SET_DEACTION 0x00
+#define COLOR_LOOP_SET_ACTION_FROM_COLOR_LOOP_START_ENHANCED_HUE 0x01
+#define COLOR_LOOP_SET_ACTION_FROM_ENHANCED_CURRENT_HUE 0x02
+
+typedef struct
+{
+	u8 hue;
+	u8 direction;
+	u16 transitionTime;
+} zcl_colorCtrlMoveToHueCmd_t;
+
+typedef struct
+{
+	u8 moveMode;
+	u8 rate;
+} zcl_colorCtrlMoveHueCmd_t;
+
+typedef struct
+{
+	u8 stepMode;
+	u8 stepSize;
+	u8 transitionTime;
+} zcl_colorCtrlStepHueCmd_t;
+
+typedef struct
+{
+	u8 saturation;
+	u16 transitionTime;
+} zcl_colorCtrlMoveToSaturationCmd_t;
+
+typedef struct
+{
+	u8 moveMode;
+	u8 rate;
+} zcl_colorCtrlMoveSaturationCmd_t;
+
+typedef struct
+{
+	u8 stepMode;
+	u8 stepSize;
+	u8 transitionTime;
+} zcl_colorCtrlStepSaturationCmd_t;
+
+typedef struct
+{
+	u8 hue;
+	u8 saturation;
+	u16 transitionTime;
+} zcl_colorCtrlMoveToHueAndSaturationCmd_t;
+
+typedef struct
+{
+	u16 colorX;
+	u16 colorY;
+	u16 transitionTime;
+} zcl_colorCtrlMoveToColorCmd_t;
+
+typedef struct
+{
+	s16 rateX;
+	s16 rateY;
+} zcl_colorCtrlMoveColorCmd_t;
+
+typedef struct
+{
+	s16 stepX;
+	s16 stepY;
+	u16 transitionTime;
+} zcl_colorCtrlStepColorCmd_t;
+
+typedef struct
+{
+	u16 colorTemperature;
+	u16 transitionTime;
+} zcl_colorCtrlMoveToColorTemperatureCmd_t;
+
+typedef struct
+{
+	u16 enhancedHue;
+	u8 direction;
+	u16 transitionTime;
+} zcl_colorCtrlEnhancedMoveToHueCmd_t;
+
+typedef struct
+{
+	u8 moveMode;
+	u16 rate;
+} zcl_colorCtrlEnhancedMoveHueCmd_t;
+
+typedef struct
+{
+	u8 stepMode;
+	u16 stepSize;
+	u16 transitionTime;
+} zcl_colorCtrlEnhancedStepHueCmd_t;
+
+typedef struct
+{
+	u16 enhancedHue;
+	u8 saturation;
+	u16 transitionTime;
+} zcl_colorCtrlEnhancedMoveToHueAndSaturationCmd_t;
+
+typedef struct
+{
+	union
+	{
+		struct
+		{
+			u8 action : 1;
+			u8 direction : 1;
+			u8 time : 1;
+			u8 startHue : 1;
+			u8 reserved : 4;
+		} bits;
+		u8 updateFlags;
+	} updateFlags;
+	u8 action;
+	u8 direction;
+	u16 time;
+	u16 startHue;
+} zcl_colorCtrlColorLoopSetCmd_t;
+
+typedef struct
+{
+	u8 moveMode;
+	u16 rate;
+	u16 colorTempMinMireds;
+	u16 colorTempMaxMireds;
+} zcl_colorCtrlMoveColorTemperatureCmd_t;
+
+typedef struct
+{
+	u8 stepMode;
+	u16 stepSize;
+	u16 transitionTime;
+	u16 colorTempMinMireds;
+	u16 colorTempMaxMireds;
+} zcl_colorCtrlStepColorTemperatureCmd_t;
+
+/**********************************************************************
+ * Scenes
+ */
+#define ZCL_CMD_SCENE_STORE_SCENE 0x04
+#define ZCL_CMD_SCENE_RECALL_SCENE 0x05
+
+#define ZCL_SCENE_EXT_FIELD_SIZE 30
+
+typedef struct
+{
+	u16 groupId;
+	u8 sceneId;
+	u16 transTime; // seconds
+	u8 transTime100ms;
+	u8 extFieldLen;
+	u8 extField[ZCL_SCENE_EXT_FIELD_SIZE];
+} zcl_sceneEntry_t;
+
+#endif /* _STORM_ZCL_INCLUDE_H_ */
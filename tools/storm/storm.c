@@ -0,0 +1,1316 @@
+/********************************************************************************************************
+ * @file    storm.c
+ *
+ * @brief   Host harness for the light command callbacks. Feeds a ZCL command
+ *          sequence into sampleLight_onOffCb, sampleLight_levelCb,
+ *          sampleLight_colorCtrlCb and sampleLight_sceneCb, runs their timers
+ *          on a virtual clock and reports the processing time of every command
+ *          and timer tick, the timer pool usage and the final light state.
+ *          The light state is persisted as app_task does it, through the NV
+ *          queue and the journal on a counted flash image.
+ *          With -c it evaluates lightCircadian_interp for the queries on
+ *          the input instead, with -j it cuts the power at every flash
+ *          operation of a run of journal appends and checks what the next
+ *          boot restores. Built and driven by tools/storm.py.
+ *
+ * @author  Zigbee Group
+ * @date    2021
+ *
+ * @par     Copyright (c) 2021, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *******************************************************************************************************/
+
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tl_common.h"
+#include "zb_api.h"
+#include "zcl_include.h"
+#include "zcl_lightExt.h"
+#include "sampleLight.h"
+#include "sampleLightCtrl.h"
+#include "sampleLightTransition.h"
+#include "sampleLightNv.h"
+#include "sampleLightReport.h"
+#include "sampleLightStream.h"
+#include "sampleLightAnim.h"
+#include "sampleLightCircadian.h"
+#include "sampleLightBrownOut.h"
+#include "app_ui.h"
+
+/**********************************************************************
+ * LOCAL CONSTANTS
+ */
+/* Application timers the SDK pool can hold next to the stack's own, override with -D */
+#ifndef STORM_TIMER_POOL_SIZE
+#define STORM_TIMER_POOL_SIZE 24
+#endif
+
+#define STORM_FIELD_MAX 5
+#define STORM_SCENE_NUM ZCL_SCENE_TABLE_NUM
+#define STORM_LINE_MAX 256
+#define STORM_SETTLE_MS 600000 // longest transition is 6553.5 s, a stuck timer shows up well before
+#define STORM_FLASH_SIZE 0x80000
+#define STORM_ATTRS_STORE_DELAY_MS 200 // debounce of sampleLightAttrsStoreTimerStart()
+#define STORM_FLASH_NO_CUT 0xFFFFFFFF
+#if LIGHT_JOURNAL_ENABLE
+#define STORM_JOURNAL_RECORDS (3 * (LIGHT_JOURNAL_SLOTS_PER_SECTOR - 1)) // two sector changes per run
+#endif
+
+#define STORM_FIELD(type, field) {offsetof(type, field), sizeof(((type *)0)->field)}
+#define STORM_NO_FIELDS {{0, 0}}
+
+/**********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ *  @brief Payload field filled from one argument of an input line
+ */
+typedef struct
+{
+	u8 ofs;
+	u8 size;
+} storm_field_t;
+
+/**
+ *  @brief Command accepted on the input, by the name used in the sequence files
+ */
+typedef struct
+{
+	const char *name;
+	cluster_forAppCb_t cb;
+	u16 clusterId;
+	u8 cmdId;
+	u8 fieldNum;
+	storm_field_t fields[STORM_FIELD_MAX];
+} storm_cmd_t;
+
+/**
+ *  @brief Cost of one command or one timer tick
+ */
+typedef struct
+{
+	u64 ns;
+	u32 pwmWrites;
+	u16 scheduled;
+	u16 cancelled;
+	u8 cmd; // index into stormCmds, STORM_TICK for a timer tick
+	u8 callbacks;
+} storm_sample_t;
+
+#define STORM_TICK 0xFF
+
+/**
+ *  @brief Flash driver and NV module calls
+ */
+typedef struct
+{
+	u32 flashReads;
+	u32 flashWrites;
+	u32 flashErases;
+	u32 nvReads;
+	u32 nvWrites;
+} storm_flashStats_t;
+
+/**
+ *  @brief Timer pool counters
+ */
+typedef struct
+{
+	u32 scheduled;
+	u32 cancelled;
+	u32 expired;
+	u32 staleCancels; // cancel of a slot that was already free, a dangling handle on target
+	u32 failures;	  // schedule with the pool full, TL_ZB_TIMER_SCHEDULE returns NULL
+	u8 inUse;
+	u8 peak;
+} storm_timerStats_t;
+
+static status_t storm_sceneCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload);
+
+/**********************************************************************
+ * GLOBAL VARIABLES
+ */
+app_ctx_t gLightCtx;
+
+const u16 zcl_attr_global_clusterRevision = 0x0001;
+
+u32 storm_pwmWrites = 0;
+
+/**********************************************************************
+ * LOCAL VARIABLES
+ */
+static const storm_cmd_t stormCmds[] = {
+	{"off", sampleLight_onOffCb, ZCL_CLUSTER_GEN_ON_OFF, ZCL_CMD_ONOFF_OFF, 0, STORM_NO_FIELDS},
+	{"on", sampleLight_onOffCb, ZCL_CLUSTER_GEN_ON_OFF, ZCL_CMD_ONOFF_ON, 0, STORM_NO_FIELDS},
+	{"toggle", sampleLight_onOffCb, ZCL_CLUSTER_GEN_ON_OFF, ZCL_CMD_ONOFF_TOGGLE, 0, STORM_NO_FIELDS},
+	{"offWithEffect", sampleLight_onOffCb, ZCL_CLUSTER_GEN_ON_OFF, ZCL_CMD_OFF_WITH_EFFECT, 2,
+	 {STORM_FIELD(zcl_onoff_offWithEffectCmd_t, effectId), STORM_FIELD(zcl_onoff_offWithEffectCmd_t, effectVariant)}},
+	{"onWithRecallGlobalScene", sampleLight_onOffCb, ZCL_CLUSTER_GEN_ON_OFF, ZCL_CMD_ON_WITH_RECALL_GLOBAL_SCENE, 0, STORM_NO_FIELDS},
+	{"onWithTimedOff", sampleLight_onOffCb, ZCL_CLUSTER_GEN_ON_OFF, ZCL_CMD_ON_WITH_TIMED_OFF, 3,
+	 {STORM_FIELD(zcl_onoff_onWithTimeOffCmd_t, onOffCtrl), STORM_FIELD(zcl_onoff_onWithTimeOffCmd_t, onTime),
+	  STORM_FIELD(zcl_onoff_onWithTimeOffCmd_t, offWaitTime)}},
+
+	{"moveToLevel", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_MOVE_TO_LEVEL, 2,
+	 {STORM_FIELD(moveToLvl_t, level), STORM_FIELD(moveToLvl_t, transitionTime)}},
+	{"move", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_MOVE, 2,
+	 {STORM_FIELD(move_t, moveMode), STORM_FIELD(move_t, rate)}},
+	{"step", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_STEP, 3,
+	 {STORM_FIELD(step_t, stepMode), STORM_FIELD(step_t, stepSize), STORM_FIELD(step_t, transitionTime)}},
+	{"stop", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_STOP, 0, STORM_NO_FIELDS},
+	{"moveToLevelWithOnOff", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_MOVE_TO_LEVEL_WITH_ON_OFF, 2,
+	 {STORM_FIELD(moveToLvl_t, level), STORM_FIELD(moveToLvl_t, transitionTime)}},
+	{"moveWithOnOff", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_MOVE_WITH_ON_OFF, 2,
+	 {STORM_FIELD(move_t, moveMode), STORM_FIELD(move_t, rate)}},
+	{"stepWithOnOff", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_STEP_WITH_ON_OFF, 3,
+	 {STORM_FIELD(step_t, stepMode), STORM_FIELD(step_t, stepSize), STORM_FIELD(step_t, transitionTime)}},
+	{"stopWithOnOff", sampleLight_levelCb, ZCL_CLUSTER_GEN_LEVEL_CONTROL, ZCL_CMD_LEVEL_STOP_WITH_ON_OFF, 0, STORM_NO_FIELDS},
+
+	{"moveToHue", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_HUE, 3,
+	 {STORM_FIELD(zcl_colorCtrlMoveToHueCmd_t, hue), STORM_FIELD(zcl_colorCtrlMoveToHueCmd_t, direction),
+	  STORM_FIELD(zcl_colorCtrlMoveToHueCmd_t, transitionTime)}},
+	{"moveHue", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_HUE, 2,
+	 {STORM_FIELD(zcl_colorCtrlMoveHueCmd_t, moveMode), STORM_FIELD(zcl_colorCtrlMoveHueCmd_t, rate)}},
+	{"stepHue", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_HUE, 3,
+	 {STORM_FIELD(zcl_colorCtrlStepHueCmd_t, stepMode), STORM_FIELD(zcl_colorCtrlStepHueCmd_t, stepSize),
+	  STORM_FIELD(zcl_colorCtrlStepHueCmd_t, transitionTime)}},
+	{"moveToSaturation", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_SATURATION, 2,
+	 {STORM_FIELD(zcl_colorCtrlMoveToSaturationCmd_t, saturation), STORM_FIELD(zcl_colorCtrlMoveToSaturationCmd_t, transitionTime)}},
+	{"moveSaturation", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_SATURATION, 2,
+	 {STORM_FIELD(zcl_colorCtrlMoveSaturationCmd_t, moveMode), STORM_FIELD(zcl_colorCtrlMoveSaturationCmd_t, rate)}},
+	{"stepSaturation", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_SATURATION, 3,
+	 {STORM_FIELD(zcl_colorCtrlStepSaturationCmd_t, stepMode), STORM_FIELD(zcl_colorCtrlStepSaturationCmd_t, stepSize),
+	  STORM_FIELD(zcl_colorCtrlStepSaturationCmd_t, transitionTime)}},
+	{"moveToHueAndSaturation", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_HUE_AND_SATURATION, 3,
+	 {STORM_FIELD(zcl_colorCtrlMoveToHueAndSaturationCmd_t, hue), STORM_FIELD(zcl_colorCtrlMoveToHueAndSaturationCmd_t, saturation),
+	  STORM_FIELD(zcl_colorCtrlMoveToHueAndSaturationCmd_t, transitionTime)}},
+	{"moveToColor", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_COLOR, 3,
+	 {STORM_FIELD(zcl_colorCtrlMoveToColorCmd_t, colorX), STORM_FIELD(zcl_colorCtrlMoveToColorCmd_t, colorY),
+	  STORM_FIELD(zcl_colorCtrlMoveToColorCmd_t, transitionTime)}},
+	{"moveColor", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_COLOR, 2,
+	 {STORM_FIELD(zcl_colorCtrlMoveColorCmd_t, rateX), STORM_FIELD(zcl_colorCtrlMoveColorCmd_t, rateY)}},
+	{"stepColor", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_COLOR, 3,
+	 {STORM_FIELD(zcl_colorCtrlStepColorCmd_t, stepX), STORM_FIELD(zcl_colorCtrlStepColorCmd_t, stepY),
+	  STORM_FIELD(zcl_colorCtrlStepColorCmd_t, transitionTime)}},
+	{"moveToColorTemperature", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_TO_COLOR_TEMPERATURE, 2,
+	 {STORM_FIELD(zcl_colorCtrlMoveToColorTemperatureCmd_t, colorTemperature), STORM_FIELD(zcl_colorCtrlMoveToColorTemperatureCmd_t, transitionTime)}},
+	{"enhancedMoveToHue", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_MOVE_TO_HUE, 3,
+	 {STORM_FIELD(zcl_colorCtrlEnhancedMoveToHueCmd_t, enhancedHue), STORM_FIELD(zcl_colorCtrlEnhancedMoveToHueCmd_t, direction),
+	  STORM_FIELD(zcl_colorCtrlEnhancedMoveToHueCmd_t, transitionTime)}},
+	{"enhancedMoveHue", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_MOVE_HUE, 2,
+	 {STORM_FIELD(zcl_colorCtrlEnhancedMoveHueCmd_t, moveMode), STORM_FIELD(zcl_colorCtrlEnhancedMoveHueCmd_t, rate)}},
+	{"enhancedStepHue", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_STEP_HUE, 3,
+	 {STORM_FIELD(zcl_colorCtrlEnhancedStepHueCmd_t, stepMode), STORM_FIELD(zcl_colorCtrlEnhancedStepHueCmd_t, stepSize),
+	  STORM_FIELD(zcl_colorCtrlEnhancedStepHueCmd_t, transitionTime)}},
+	{"enhancedMoveToHueAndSaturation", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_ENHANCED_MOVE_TO_HUE_AND_SATURATION, 3,
+	 {STORM_FIELD(zcl_colorCtrlEnhancedMoveToHueAndSaturationCmd_t, enhancedHue), STORM_FIELD(zcl_colorCtrlEnhancedMoveToHueAndSaturationCmd_t, saturation),
+	  STORM_FIELD(zcl_colorCtrlEnhancedMoveToHueAndSaturationCmd_t, transitionTime)}},
+	{"colorLoopSet", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_COLOR_LOOP_SET, 5,
+	 {STORM_FIELD(zcl_colorCtrlColorLoopSetCmd_t, updateFlags), STORM_FIELD(zcl_colorCtrlColorLoopSetCmd_t, action),
+	  STORM_FIELD(zcl_colorCtrlColorLoopSetCmd_t, direction), STORM_FIELD(zcl_colorCtrlColorLoopSetCmd_t, time),
+	  STORM_FIELD(zcl_colorCtrlColorLoopSetCmd_t, startHue)}},
+	{"stopMoveStep", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_STOP_MOVE_STEP, 0, STORM_NO_FIELDS},
+	{"moveColorTemperature", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_MOVE_COLOR_TEMPERATURE, 4,
+	 {STORM_FIELD(zcl_colorCtrlMoveColorTemperatureCmd_t, moveMode), STORM_FIELD(zcl_colorCtrlMoveColorTemperatureCmd_t, rate),
+	  STORM_FIELD(zcl_colorCtrlMoveColorTemperatureCmd_t, colorTempMinMireds), STORM_FIELD(zcl_colorCtrlMoveColorTemperatureCmd_t, colorTempMaxMireds)}},
+	{"stepColorTemperature", sampleLight_colorCtrlCb, ZCL_CLUSTER_LIGHTING_COLOR_CONTROL, ZCL_CMD_LIGHT_COLOR_CONTROL_STEP_COLOR_TEMPERATURE, 5,
+	 {STORM_FIELD(zcl_colorCtrlStepColorTemperatureCmd_t, stepMode), STORM_FIELD(zcl_colorCtrlStepColorTemperatureCmd_t, stepSize),
+	  STORM_FIELD(zcl_colorCtrlStepColorTemperatureCmd_t, transitionTime), STORM_FIELD(zcl_colorCtrlStepColorTemperatureCmd_t, colorTempMinMireds),
+	  STORM_FIELD(zcl_colorCtrlStepColorTemperatureCmd_t, colorTempMaxMireds)}},
+
+	/* The transition time is kept with the scene, as Add Scene would set it */
+	{"sceneStore", storm_sceneCb, ZCL_CLUSTER_GEN_SCENES, ZCL_CMD_SCENE_STORE_SCENE, 3,
+	 {STORM_FIELD(zcl_sceneEntry_t, sceneId), STORM_FIELD(zcl_sceneEntry_t, transTime), STORM_FIELD(zcl_sceneEntry_t, transTime100ms)}},
+	{"sceneRecall", storm_sceneCb, ZCL_CLUSTER_GEN_SCENES, ZCL_CMD_SCENE_RECALL_SCENE, 1,
+	 {STORM_FIELD(zcl_sceneEntry_t, sceneId)}},
+};
+
+#define STORM_CMD_NUM (sizeof(stormCmds) / sizeof(storm_cmd_t))
+
+static ev_timer_event_t stormTimerPool[STORM_TIMER_POOL_SIZE];
+static storm_timerStats_t stormTimerStats;
+static u32 stormTimerSeq = 0;
+static u32 stormNow = 0; // virtual ms
+
+static zcl_sceneEntry_t stormScenes[STORM_SCENE_NUM];
+static bool stormSceneUsed[STORM_SCENE_NUM];
+
+static storm_sample_t *stormSamples = NULL;
+static u32 stormSampleNum = 0;
+static u32 stormSampleCap = 0;
+
+static bool stormVerbose = FALSE;
+
+static u8 stormFlash[STORM_FLASH_SIZE];
+static storm_flashStats_t stormFlashStats;
+static u32 stormFlashBudget = STORM_FLASH_NO_CUT; // flash writes and erases left before the power cut
+static bool stormFlashCut = FALSE;
+static ev_timer_event_t *stormAttrsStoreTimerEvt = NULL;
+
+/**********************************************************************
+ * Modules not under test
+ */
+void led_on(u32 pin)
+{
+}
+
+void led_off(u32 pin)
+{
+}
+
+void lightReport_attrChanged(void)
+{
+}
+
+void lightStream_stop(void)
+{
+}
+
+bool lightStream_active(void)
+{
+	return FALSE;
+}
+
+void lightAnim_stop(void)
+{
+}
+
+bool lightAnim_active(void)
+{
+	return FALSE;
+}
+
+#if LIGHT_BROWN_OUT_ENABLE
+nv_sts_t lightBrownOut_save(void)
+{
+	return NV_SUCC;
+}
+#endif
+
+#ifdef ZCL_LIGHT_EXT
+void lightAnim_clear(void)
+{
+}
+
+nv_sts_t lightAnim_save(void)
+{
+	return NV_SUCC;
+}
+
+status_t zcl_lightExt_register(u8 endpoint, u16 manuCode, u8 attrNum, const zclAttrInfo_t attrTbl[], cluster_forAppCb_t cb)
+{
+	return ZCL_STA_SUCCESS;
+}
+
+status_t sampleLight_lightExtCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload)
+{
+	return ZCL_STA_SUCCESS;
+}
+#endif
+
+status_t sampleLight_basicCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload)
+{
+	return ZCL_STA_SUCCESS;
+}
+
+status_t sampleLight_identifyCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload)
+{
+	return ZCL_STA_SUCCESS;
+}
+
+/**********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      storm_timerAdd
+ *
+ * @brief   TL_ZB_TIMER_SCHEDULE on the virtual clock, same pool semantics
+ *
+ * @param   cb  - returns 0 to run again after the same period, a positive
+ *                value to run again after that many ms, -1 to stop
+ * @param   arg
+ * @param   ms
+ *
+ * @return  timer handle, NULL with the pool full
+ */
+ev_timer_event_t *storm_timerAdd(ev_timer_callback_t cb, void *arg, u32 ms)
+{
+	for (u8 i = 0; i < STORM_TIMER_POOL_SIZE; i++)
+	{
+		ev_timer_event_t *pEvt = &stormTimerPool[i];
+
+		if (!pEvt->used)
+		{
+			pEvt->cb = cb;
+			pEvt->data = arg;
+			pEvt->timeout = stormNow + ms;
+			pEvt->period = ms;
+			pEvt->seq = ++stormTimerSeq;
+			pEvt->used = 1;
+
+			stormTimerStats.scheduled++;
+			stormTimerStats.inUse++;
+			stormTimerStats.peak = max2(stormTimerStats.peak, stormTimerStats.inUse);
+			return pEvt;
+		}
+	}
+
+	stormTimerStats.failures++;
+	return NULL;
+}
+
+/*********************************************************************
+ * @fn      storm_timerFree
+ *
+ * @brief
+ *
+ * @param   pEvt
+ *
+ * @return  None
+ */
+static void storm_timerFree(ev_timer_event_t *pEvt)
+{
+	pEvt->used = 0;
+	stormTimerStats.inUse--;
+}
+
+/*********************************************************************
+ * @fn      storm_timerCancel
+ *
+ * @brief   TL_ZB_TIMER_CANCEL, clears the handle
+ *
+ * @param   evt
+ *
+ * @return  None
+ */
+void storm_timerCancel(ev_timer_event_t **evt)
+{
+	if (*evt == NULL)
+	{
+		return;
+	}
+
+	if ((*evt)->used)
+	{
+		storm_timerFree(*evt);
+		stormTimerStats.cancelled++;
+	}
+	else
+	{
+		stormTimerStats.staleCancels++;
+	}
+	*evt = NULL;
+}
+
+/*********************************************************************
+ * @fn      clock_time
+ *
+ * @brief   System timer ticks of the virtual clock
+ *
+ * @param   None
+ *
+ * @return  16 MHz ticks, wrapping like the hardware counter
+ */
+u32 clock_time(void)
+{
+	return stormNow * 1000 * CLOCK_16M_SYS_TIMER_CLK_1US;
+}
+
+/*********************************************************************
+ * @fn      clock_time_exceed
+ *
+ * @brief
+ *
+ * @param   ref - clock_time() of the start
+ * @param   us
+ *
+ * @return  TRUE once more than 'us' passed since 'ref'
+ */
+bool clock_time_exceed(u32 ref, u32 us)
+{
+	return (u32)(clock_time() - ref) > us * CLOCK_16M_SYS_TIMER_CLK_1US;
+}
+
+/*********************************************************************
+ * @fn      storm_flashPowered
+ *
+ * @brief   Count a flash write or erase against the power cut budget
+ *
+ * @param   None
+ *
+ * @return  FALSE once the supply is gone, the operation that meets the
+ *          cut and every one after it are lost
+ */
+static bool storm_flashPowered(void)
+{
+	if (stormFlashBudget == STORM_FLASH_NO_CUT)
+	{
+		return TRUE;
+	}
+
+	if (stormFlashBudget)
+	{
+		stormFlashBudget--;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*********************************************************************
+ * @fn      flash_read
+ *
+ * @brief   Flash driver on the RAM image
+ *
+ * @param   addr
+ * @param   len
+ * @param   buf
+ *
+ * @return  None
+ */
+void flash_read(u32 addr, u32 len, u8 *buf)
+{
+	memcpy(buf, &stormFlash[addr % STORM_FLASH_SIZE], min2(len, STORM_FLASH_SIZE - addr % STORM_FLASH_SIZE));
+	stormFlashStats.flashReads++;
+}
+
+/*********************************************************************
+ * @fn      flash_write
+ *
+ * @brief   Programming only clears bits, as on the real part
+ *
+ * @param   addr
+ * @param   len
+ * @param   buf
+ *
+ * @return  None
+ */
+void flash_write(u32 addr, u32 len, u8 *buf)
+{
+	u8 *pDst = &stormFlash[addr % STORM_FLASH_SIZE];
+
+	if (!storm_flashPowered())
+	{
+		/* the write the power cut meets is torn half way */
+		len = stormFlashCut ? 0 : len / 2;
+		stormFlashCut = TRUE;
+	}
+
+	for (u32 i = 0; i < min2(len, STORM_FLASH_SIZE - addr % STORM_FLASH_SIZE); i++)
+	{
+		pDst[i] &= buf[i];
+	}
+	stormFlashStats.flashWrites++;
+}
+
+/*********************************************************************
+ * @fn      flash_erase
+ *
+ * @brief   Erase the 4K sector holding addr
+ *
+ * @param   addr
+ *
+ * @return  None
+ */
+void flash_erase(u32 addr)
+{
+	if (!storm_flashPowered())
+	{
+		stormFlashCut = TRUE;
+		return;
+	}
+
+	memset(&stormFlash[(addr % STORM_FLASH_SIZE) & ~0xFFF], 0xFF, 0x1000);
+	stormFlashStats.flashErases++;
+}
+
+/*********************************************************************
+ * @fn      xcrc32
+ *
+ * @brief   CRC-32, only seals and checks records on the host image
+ *
+ * @param   buf
+ * @param   len
+ * @param   crc - initial value
+ *
+ * @return  crc
+ */
+u32 xcrc32(const u8 *buf, int len, u32 crc)
+{
+	while (len--)
+	{
+		crc ^= (u32)*buf++ << 24;
+		for (u8 i = 0; i < 8; i++)
+		{
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+/*********************************************************************
+ * @fn      nv_flashReadNew
+ *
+ * @brief   NV module without items, every read misses
+ *
+ * @return  NV_ITEM_NOT_FOUND
+ */
+nv_sts_t nv_flashReadNew(u8 single, u8 id, u8 itemId, u16 len, u8 *buf)
+{
+	stormFlashStats.nvReads++;
+	return NV_ITEM_NOT_FOUND;
+}
+
+/*********************************************************************
+ * @fn      nv_flashWriteNew
+ *
+ * @brief   NV module without items, writes are only counted
+ *
+ * @return  NV_SUCC
+ */
+nv_sts_t nv_flashWriteNew(u8 single, u8 id, u8 itemId, u16 len, u8 *buf)
+{
+	stormFlashStats.nvWrites++;
+	return NV_SUCC;
+}
+
+/*********************************************************************
+ * @fn      storm_attrsStoreTimerCb
+ *
+ * @brief   sampleLightAttrsStoreTimerCb()
+ *
+ * @param   arg
+ *
+ * @return  -1: timer will be canceled
+ */
+static s32 storm_attrsStoreTimerCb(void *arg)
+{
+	lightNv_enqueue(LIGHT_NV_OP_STATE);
+
+	stormAttrsStoreTimerEvt = NULL;
+	return -1;
+}
+
+/*********************************************************************
+ * @fn      storm_appTask
+ *
+ * @brief   The persistence part of app_task(), sampleLightAttrsChk()
+ *          and lightNv_process(), run after every command and tick.
+ *          The debounce timer is the one of sampleLightAttrsStoreTimerStart().
+ *
+ * @param   None
+ *
+ * @return  None
+ */
+static void storm_appTask(void)
+{
+	if (gLightCtx.lightAttrsChanged)
+	{
+		gLightCtx.lightAttrsChanged = FALSE;
+		if (stormAttrsStoreTimerEvt)
+		{
+			TL_ZB_TIMER_CANCEL(&stormAttrsStoreTimerEvt);
+		}
+		stormAttrsStoreTimerEvt = TL_ZB_TIMER_SCHEDULE(storm_attrsStoreTimerCb, NULL, STORM_ATTRS_STORE_DELAY_MS);
+	}
+
+	lightNv_process();
+}
+
+/*********************************************************************
+ * @fn      storm_ns
+ *
+ * @brief
+ *
+ * @param   None
+ *
+ * @return  monotonic host time in ns
+ */
+static u64 storm_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*********************************************************************
+ * @fn      storm_sampleAdd
+ *
+ * @brief
+ *
+ * @param   pSample
+ *
+ * @return  None
+ */
+static void storm_sampleAdd(const storm_sample_t *pSample)
+{
+	if (stormSampleNum == stormSampleCap)
+	{
+		stormSampleCap = stormSampleCap ? stormSampleCap * 2 : 1024;
+		stormSamples = realloc(stormSamples, stormSampleCap * sizeof(storm_sample_t));
+		if (!stormSamples)
+		{
+			fprintf(stderr, "out of memory\n");
+			exit(2);
+		}
+	}
+	stormSamples[stormSampleNum++] = *pSample;
+}
+
+/*********************************************************************
+ * @fn      storm_timerNext
+ *
+ * @brief
+ *
+ * @param   until - virtual ms
+ *
+ * @return  the earliest timer due by 'until', NULL if none
+ */
+static ev_timer_event_t *storm_timerNext(u32 until)
+{
+	ev_timer_event_t *pNext = NULL;
+
+	for (u8 i = 0; i < STORM_TIMER_POOL_SIZE; i++)
+	{
+		ev_timer_event_t *pEvt = &stormTimerPool[i];
+
+		if (pEvt->used && (pEvt->timeout <= until) && (!pNext || (pEvt->timeout < pNext->timeout)))
+		{
+			pNext = pEvt;
+		}
+	}
+	return pNext;
+}
+
+/*********************************************************************
+ * @fn      storm_timersRun
+ *
+ * @brief   Advance the virtual clock, all timers due on the same ms make
+ *          up one tick of the main loop
+ *
+ * @param   until - virtual ms
+ *
+ * @return  None
+ */
+static void storm_timersRun(u32 until)
+{
+	ev_timer_event_t *pEvt;
+
+	while ((pEvt = storm_timerNext(until)) != NULL)
+	{
+		storm_sample_t tick;
+		u32 scheduled = stormTimerStats.scheduled;
+		u32 cancelled = stormTimerStats.cancelled;
+		u32 pwmWrites = storm_pwmWrites;
+
+		memset(&tick, 0, sizeof(tick));
+		tick.cmd = STORM_TICK;
+		stormNow = pEvt->timeout;
+
+		do
+		{
+			u32 seq = pEvt->seq;
+			u64 start = storm_ns();
+			s32 ret = pEvt->cb(pEvt->data);
+
+			tick.ns += storm_ns() - start;
+			tick.callbacks++;
+			stormTimerStats.expired++;
+
+			// cancelled from inside its own callback, maybe already handed out again
+			if (!pEvt->used || (pEvt->seq != seq))
+			{
+				continue;
+			}
+			if (ret < 0)
+			{
+				storm_timerFree(pEvt);
+			}
+			else
+			{
+				if (ret > 0)
+				{
+					pEvt->period = ret;
+				}
+				pEvt->timeout += pEvt->period;
+			}
+		} while ((pEvt = storm_timerNext(stormNow)) != NULL);
+
+		tick.scheduled = stormTimerStats.scheduled - scheduled;
+		tick.cancelled = stormTimerStats.cancelled - cancelled;
+		tick.pwmWrites = storm_pwmWrites - pwmWrites;
+		storm_sampleAdd(&tick);
+
+		storm_appTask();
+	}
+
+	stormNow = until;
+}
+
+/*********************************************************************
+ * @fn      storm_sceneCb
+ *
+ * @brief   The scene table of the SDK in front of sampleLight_sceneCb:
+ *          store fills an entry, recall hands the stored one over.
+ *          Entries are found by scene id, the group is not modelled.
+ *
+ * @param   pAddrInfo
+ * @param   cmdId
+ * @param   cmdPayload - scene id and transition time from the input line
+ *
+ * @return  status_t
+ */
+static status_t storm_sceneCb(zclIncomingAddrInfo_t *pAddrInfo, u8 cmdId, void *cmdPayload)
+{
+	zcl_sceneEntry_t *pCmd = (zcl_sceneEntry_t *)cmdPayload;
+	zcl_sceneEntry_t *pScene = NULL;
+	zcl_sceneEntry_t *pFree = NULL;
+
+	for (u8 i = 0; i < STORM_SCENE_NUM; i++)
+	{
+		if (!stormSceneUsed[i])
+		{
+			pFree = pFree ? pFree : &stormScenes[i];
+		}
+		else if (stormScenes[i].sceneId == pCmd->sceneId)
+		{
+			pScene = &stormScenes[i];
+		}
+	}
+
+	if (cmdId == ZCL_CMD_SCENE_STORE_SCENE)
+	{
+		if (!pScene)
+		{
+			if (!pFree)
+			{
+				return ZCL_STA_INSUFFICIENT_SPACE;
+			}
+			pScene = pFree;
+			stormSceneUsed[pScene - stormScenes] = TRUE;
+		}
+		memcpy(pScene, pCmd, sizeof(zcl_sceneEntry_t));
+	}
+	else if (!pScene)
+	{
+		return ZCL_STA_NOT_FOUND;
+	}
+
+	return sampleLight_sceneCb(pAddrInfo, cmdId, pScene);
+}
+
+/*********************************************************************
+ * @fn      storm_statePrint
+ *
+ * @brief   One line of key=value pairs, read back by storm.py
+ *
+ * @param   tag
+ *
+ * @return  None
+ */
+static void storm_statePrint(const char *tag)
+{
+	zcl_onOffAttr_t *pOnOff = zcl_onoffAttrGet();
+	zcl_levelAttr_t *pLevel = zcl_levelAttrGet();
+	zcl_lightColorCtrlAttr_t *pColor = zcl_colorAttrGet();
+
+	printf("%s onOff=%u level=%u remainingTime=%u colorMode=%u enhancedColorMode=%u hue=%u saturation=%u "
+		   "enhancedHue=%u x=%u y=%u mireds=%u\n",
+		   tag, pOnOff->onOff, pLevel->curLevel, pLevel->remainingTime, pColor->colorMode, pColor->enhancedColorMode,
+		   pColor->currentHue, pColor->currentSaturation, pColor->enhancedCurrentHue, pColor->currentX, pColor->currentY,
+		   pColor->colorTemperatureMireds);
+}
+
+/*********************************************************************
+ * @fn      storm_lineRun
+ *
+ * @brief   Parse "<t_ms> <command> <args...>" and run it at t_ms
+ *
+ * @param   line
+ * @param   lineNum
+ *
+ * @return  None, exits on a malformed line
+ */
+static void storm_lineRun(char *line, u32 lineNum)
+{
+	static zclIncomingAddrInfo_t addrInfo = {
+		.dstEp = SAMPLE_LIGHT_ENDPOINT,
+		.dirCluster = ZCL_FRAME_CLIENT_SERVER_DIR,
+	};
+	u8 payload[sizeof(zcl_sceneEntry_t)];
+	char *save;
+	char *tok = strtok_r(line, " \t\r\n", &save);
+	const storm_cmd_t *pCmd = NULL;
+	u32 t;
+
+	if (!tok || (tok[0] == '#'))
+	{
+		return;
+	}
+	t = strtoul(tok, NULL, 0);
+	if (t < stormNow)
+	{
+		fprintf(stderr, "line %u: time %u is before %u\n", lineNum, t, stormNow);
+		exit(2);
+	}
+
+	tok = strtok_r(NULL, " \t\r\n", &save);
+	for (u8 i = 0; tok && (i < STORM_CMD_NUM); i++)
+	{
+		if (!strcmp(tok, stormCmds[i].name))
+		{
+			pCmd = &stormCmds[i];
+		}
+	}
+	if (!pCmd)
+	{
+		fprintf(stderr, "line %u: unknown command %s\n", lineNum, tok ? tok : "");
+		exit(2);
+	}
+
+	memset(payload, 0, sizeof(payload));
+	for (u8 i = 0; i < pCmd->fieldNum; i++)
+	{
+		u32 value;
+
+		tok = strtok_r(NULL, " \t\r\n", &save);
+		if (!tok)
+		{
+			fprintf(stderr, "line %u: %s takes %u arguments\n", lineNum, pCmd->name, pCmd->fieldNum);
+			exit(2);
+		}
+		value = (u32)strtol(tok, NULL, 0);
+		memcpy(&payload[pCmd->fields[i].ofs], &value, pCmd->fields[i].size); // little endian host
+	}
+
+	storm_timersRun(t);
+
+	storm_sample_t sample;
+	u32 scheduled = stormTimerStats.scheduled;
+	u32 cancelled = stormTimerStats.cancelled;
+	u32 pwmWrites = storm_pwmWrites;
+
+	memset(&sample, 0, sizeof(sample));
+	sample.cmd = pCmd - stormCmds;
+	addrInfo.clusterId = pCmd->clusterId;
+
+	u64 start = storm_ns();
+	pCmd->cb(&addrInfo, pCmd->cmdId, payload);
+	sample.ns = storm_ns() - start;
+
+	sample.scheduled = stormTimerStats.scheduled - scheduled;
+	sample.cancelled = stormTimerStats.cancelled - cancelled;
+	sample.pwmWrites = storm_pwmWrites - pwmWrites;
+	storm_sampleAdd(&sample);
+
+	storm_appTask();
+
+	if (stormVerbose)
+	{
+		char tag[64];
+
+		snprintf(tag, sizeof(tag), "%8u %-24s %6llu ns", t, pCmd->name, sample.ns);
+		storm_statePrint(tag);
+	}
+}
+
+/*********************************************************************
+ * @fn      storm_u64Cmp
+ *
+ * @brief   qsort comparator
+ */
+static int storm_u64Cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a;
+	u64 y = *(const u64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+/*********************************************************************
+ * @fn      storm_rowPrint
+ *
+ * @brief   Distribution of the samples of one command, or of all commands
+ *          with cmd STORM_CMD_NUM, or of the timer ticks with STORM_TICK
+ *
+ * @param   name
+ * @param   cmd
+ * @param   pBuf - scratch of stormSampleNum entries
+ *
+ * @return  None
+ */
+static void storm_rowPrint(const char *name, u8 cmd, u64 *pBuf)
+{
+	u32 n = 0;
+	u32 pwmMax = 0;
+	u32 scheduled = 0;
+	u32 cancelled = 0;
+
+	for (u32 i = 0; i < stormSampleNum; i++)
+	{
+		storm_sample_t *pSample = &stormSamples[i];
+
+		if ((pSample->cmd == cmd) || ((cmd == STORM_CMD_NUM) && (pSample->cmd != STORM_TICK)))
+		{
+			pBuf[n++] = pSample->ns;
+			pwmMax = max2(pwmMax, pSample->pwmWrites);
+			scheduled += pSample->scheduled;
+			cancelled += pSample->cancelled;
+		}
+	}
+	if (!n)
+	{
+		return;
+	}
+
+	qsort(pBuf, n, sizeof(u64), storm_u64Cmp);
+	printf("%-32s %7u %8llu %8llu %8llu %8llu %7u %7u %7u\n", name, n, pBuf[(n - 1) / 2], pBuf[(n - 1) * 95 / 100],
+		   pBuf[(n - 1) * 99 / 100], pBuf[n - 1], pwmMax, scheduled, cancelled);
+}
+
+/*********************************************************************
+ * @fn      storm_report
+ *
+ * @brief
+ *
+ * @param   settled - TRUE if every timer ran out
+ *
+ * @return  None
+ */
+static void storm_report(bool settled)
+{
+	u64 *pBuf = malloc((stormSampleNum + 1) * sizeof(u64));
+	light_nvStats_t *pNv = lightNv_statsGet();
+	u8 ticksMax = 0;
+
+	if (!pBuf)
+	{
+		fprintf(stderr, "out of memory\n");
+		exit(2);
+	}
+
+	printf("%-32s %7s %8s %8s %8s %8s %7s %7s %7s\n", "host ns per call", "count", "p50", "p95", "p99", "max", "pwm max",
+		   "sched", "cancel");
+	for (u8 i = 0; i < STORM_CMD_NUM; i++)
+	{
+		storm_rowPrint(stormCmds[i].name, i, pBuf);
+	}
+	storm_rowPrint("all commands", STORM_CMD_NUM, pBuf);
+	storm_rowPrint("timer ticks", STORM_TICK, pBuf);
+	free(pBuf);
+
+	for (u32 i = 0; i < stormSampleNum; i++)
+	{
+		if (stormSamples[i].cmd == STORM_TICK)
+		{
+			ticksMax = max2(ticksMax, stormSamples[i].callbacks);
+		}
+	}
+
+	printf("\ntimer pool: %u slots, peak %u in use, %u callbacks at most in one tick\n", STORM_TIMER_POOL_SIZE,
+		   stormTimerStats.peak, ticksMax);
+	printf("timers: %u scheduled, %u cancelled, %u expired callbacks, %u stale cancels, %u failed schedules\n",
+		   stormTimerStats.scheduled, stormTimerStats.cancelled, stormTimerStats.expired, stormTimerStats.staleCancels,
+		   stormTimerStats.failures);
+	printf("nv: %u operations, %u record writes, %u skipped by the shadow, %u read-backs avoided, %u journal erases, "
+		   "%u deferred, %u forced, %u still queued\n",
+		   pNv->opsDone, pNv->flashWrites, pNv->flashWritesSaved, pNv->flashReadsSaved, pNv->journalErases,
+		   pNv->opsDeferred, pNv->opsForced, pNv->queueDepth);
+	printf("flash: %u reads, %u writes, %u erases, nv module %u reads, %u writes\n", stormFlashStats.flashReads,
+		   stormFlashStats.flashWrites, stormFlashStats.flashErases, stormFlashStats.nvReads, stormFlashStats.nvWrites);
+
+	if (settled)
+	{
+		printf("settled at %u ms virtual time\n", stormNow);
+	}
+	else
+	{
+		printf("not settled at %u ms virtual time, %u timers still running\n", stormNow, stormTimerStats.inUse);
+	}
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   storm [-v] [-s settle_ms] < sequence
+ *
+ * @return  0, or 2 on a malformed sequence
+ */
+#if LIGHT_CIRCADIAN_ENABLE
+/*********************************************************************
+ * @fn      storm_circadianLineRun
+ *
+ * @brief   Parse "points <minute> <mireds> <level> ..." to load a schedule
+ *          table as it could come out of NV, or "<secOfDay>" to print
+ *          "interp <secOfDay> <mireds> <level>" for the loaded table
+ *
+ * @param   line
+ * @param   lineNum
+ *
+ * @return  None, exits on a malformed line
+ */
+static void storm_circadianLineRun(char *line, u32 lineNum)
+{
+	static light_circadianTable_t table;
+	char *save;
+	char *tok = strtok_r(line, " \t\r\n", &save);
+
+	if (!tok || (tok[0] == '#'))
+	{
+		return;
+	}
+
+	if (!strcmp(tok, "points"))
+	{
+		memset((u8 *)&table, 0, sizeof(table));
+		while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL)
+		{
+			light_circadianPoint_t *pPoint = &table.points[table.pointNum];
+			char *mireds = strtok_r(NULL, " \t\r\n", &save);
+			char *level = strtok_r(NULL, " \t\r\n", &save);
+
+			if (!mireds || !level || (table.pointNum == LIGHT_CIRCADIAN_POINT_MAX))
+			{
+				fprintf(stderr, "line %u: points takes up to %u minute mireds level triples\n", lineNum, LIGHT_CIRCADIAN_POINT_MAX);
+				exit(2);
+			}
+			pPoint->minute = strtoul(tok, NULL, 0);
+			pPoint->mireds = strtoul(mireds, NULL, 0);
+			pPoint->level = strtoul(level, NULL, 0);
+			table.pointNum++;
+		}
+		table.enable = TRUE;
+		return;
+	}
+
+	if (!table.pointNum)
+	{
+		fprintf(stderr, "line %u: no points loaded\n", lineNum);
+		exit(2);
+	}
+
+	u32 secOfDay = strtoul(tok, NULL, 0);
+	u8 level;
+	u16 mireds = lightCircadian_interp(&table, secOfDay, &level);
+
+	printf("interp %u %u %u\n", secOfDay, mireds, level);
+}
+#endif
+
+#if LIGHT_JOURNAL_ENABLE
+/*********************************************************************
+ * @fn      storm_journalRecord
+ *
+ * @brief   Seal a state record numbered by its mireds
+ *
+ * @param   pRec
+ * @param   num
+ *
+ * @return  None
+ */
+static void storm_journalRecord(light_state_record_t *pRec, u16 num)
+{
+	memset((u8 *)pRec, 0, sizeof(light_state_record_t));
+	pRec->version = LIGHT_STATE_RECORD_VERSION;
+	pRec->onOff = TRUE;
+	pRec->mireds = num;
+	pRec->crc = xcrc32((u8 *)pRec + sizeof(pRec->crc), sizeof(light_state_record_t) - sizeof(pRec->crc), 0xffffffff);
+}
+
+/*********************************************************************
+ * @fn      storm_journalBoot
+ *
+ * @brief   lightJournal_init() after a power cycle, with the spare erase
+ *          it queues run as app_task would once idle
+ *
+ * @param   pRec
+ *
+ * @return  TRUE if a record was restored
+ */
+static bool storm_journalBoot(light_state_record_t *pRec)
+{
+	bool found = lightJournal_init(pRec);
+
+	while (lightNv_queueDepth())
+	{
+		lightNv_process();
+	}
+
+	return found;
+}
+
+/*********************************************************************
+ * @fn      storm_journalRun
+ *
+ * @brief   Write STORM_JOURNAL_RECORDS records, once for every flash write
+ *          and erase of that run with the power cut right there. Each time
+ *          the next boot must restore the last record whose append had
+ *          completed, and the journal must take new records after it.
+ *
+ * @param   None
+ *
+ * @return  number of cuts that lost the last record
+ */
+static u32 storm_journalRun(void)
+{
+	light_state_record_t rec;
+	u32 cuts = 0;
+	u32 lost = 0;
+
+	for (u32 cut = 0;; cut++)
+	{
+		u16 durable = 0;
+
+		memset(stormFlash, 0xFF, sizeof(stormFlash));
+		stormFlashBudget = STORM_FLASH_NO_CUT;
+		stormFlashCut = FALSE;
+		storm_journalBoot(&rec);
+
+		stormFlashBudget = cut;
+		for (u16 num = 1; (num <= STORM_JOURNAL_RECORDS) && !stormFlashCut; num++)
+		{
+			storm_journalRecord(&rec, num);
+			lightJournal_append(&rec);
+			if (!stormFlashCut)
+			{
+				durable = num;
+			}
+			lightNv_process();
+		}
+
+		if (!stormFlashCut)
+		{
+			/* the run got through, every operation of it has been cut once */
+			break;
+		}
+		cuts++;
+
+		stormFlashBudget = STORM_FLASH_NO_CUT;
+		bool found = storm_journalBoot(&rec);
+
+		if (durable ? (!found || (rec.mireds != durable)) : found)
+		{
+			printf("cut %u: restored %s %u, expected %u\n", cut, found ? "record" : "nothing", found ? rec.mireds : 0, durable);
+			lost++;
+			continue;
+		}
+
+		storm_journalRecord(&rec, 0x8000);
+		lightJournal_append(&rec);
+		found = storm_journalBoot(&rec);
+		if (!found || (rec.mireds != 0x8000))
+		{
+			printf("cut %u: the record appended after the restore was lost\n", cut);
+			lost++;
+		}
+	}
+
+	printf("journal: %u power cuts, %u lost the last record\n", cuts, lost);
+	return lost;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	char line[STORM_LINE_MAX];
+	u32 lineNum = 0;
+	u32 settleMs = STORM_SETTLE_MS;
+	bool circadian = FALSE;
+	bool journal = FALSE;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "vcjs:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'v':
+			stormVerbose = TRUE;
+			break;
+		case 'c':
+			circadian = TRUE;
+			break;
+		case 'j':
+			journal = TRUE;
+			break;
+		case 's':
+			settleMs = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-v] [-s settle_ms] < sequence\n       %s -c < circadian queries\n       %s -j\n", argv[0], argv[0], argv[0]);
+			return 2;
+		}
+	}
+
+	if (circadian)
+	{
+#if LIGHT_CIRCADIAN_ENABLE
+		while (fgets(line, sizeof(line), stdin))
+		{
+			storm_circadianLineRun(line, ++lineNum);
+		}
+		return 0;
+#else
+		fprintf(stderr, "built without LIGHT_CIRCADIAN_ENABLE\n");
+		return 2;
+#endif
+	}
+
+	if (journal)
+	{
+#if LIGHT_JOURNAL_ENABLE
+		return storm_journalRun() ? 1 : 0;
+#else
+		fprintf(stderr, "built without LIGHT_JOURNAL_ENABLE\n");
+		return 2;
+#endif
+	}
+
+	/* first boot on an erased flash, as user_init() does it */
+	memset(stormFlash, 0xFF, sizeof(stormFlash));
+	zcl_sampleLightAttrsInit();
+	light_adjust();
+	printf("config timers=%u scenes=%u miredsMin=%u miredsMax=%u\n", STORM_TIMER_POOL_SIZE, STORM_SCENE_NUM,
+		   zcl_colorAttrGet()->colorTempPhysicalMinMireds, zcl_colorAttrGet()->colorTempPhysicalMaxMireds);
+	storm_statePrint("initial");
+
+	while (fgets(line, sizeof(line), stdin))
+	{
+		storm_lineRun(line, ++lineNum);
+	}
+
+	/* let every transition run out, a move without end keeps its timer */
+	u32 settleEnd = stormNow + settleMs;
+
+	while (stormTimerStats.inUse && (stormNow < settleEnd))
+	{
+		u32 next = settleEnd;
+
+		for (u8 i = 0; i < STORM_TIMER_POOL_SIZE; i++)
+		{
+			if (stormTimerPool[i].used)
+			{
+				next = min2(next, stormTimerPool[i].timeout);
+			}
+		}
+		storm_timersRun(next);
+	}
+
+	storm_report(stormTimerStats.inUse == 0);
+	storm_statePrint("final");
+	return 0;
+}